@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+"""Compare two ESP Bus benchmark logs.
+
+Usage: compare.py base.log new.log
+
+Only BENCH lines are read. Results are matched on their name and
+parameters; every numeric metric is printed with its change in percent.
+"""
+
+import json
+import sys
+
+# Keys that identify a result rather than measure it
+PARAMS = ('name', 'api', 'kind', 'subs', 'payload', 'interval_ms', 'n')
+
+
+def load(path):
+    results = {}
+    with open(path, errors='replace') as f:
+        for line in f:
+            pos = line.find('BENCH {')
+            if pos < 0:
+                continue
+            r = json.loads(line[pos + 6:])
+            key = tuple((k, r[k]) for k in PARAMS if k in r)
+            results[key] = r
+    return results
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    base, new = load(sys.argv[1]), load(sys.argv[2])
+
+    for key, r in new.items():
+        if r['name'] == 'config':
+            continue
+        label = ' '.join(f'{v}' if k == 'name' else f'{k}={v}' for k, v in key)
+        old = base.get(key)
+        if old is None:
+            print(f'{label}: new')
+            continue
+        for metric, value in r.items():
+            if metric in PARAMS or not isinstance(value, (int, float)):
+                continue
+            before = old.get(metric)
+            if not isinstance(before, (int, float)):
+                continue
+            delta = (value - before) * 100.0 / before if before else 0.0
+            print(f'{label} {metric}: {before} -> {value} ({delta:+.1f}%)')
+
+    # Numbers from different configs are not comparable one to one
+    if base.get((('name', 'config'),)) != new.get((('name', 'config'),)):
+        print('note: runs were built with different configs')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,371 @@
+/**
+ * @file bench_esp_bus.c
+ * @brief ESP Bus benchmarks
+ *
+ * Measures request round trips, emit throughput, wildcard dispatch cost,
+ * service jitter and heap operations per message. Every result is printed
+ * as one line:
+ *
+ *   BENCH {"name":"...", ...}
+ *
+ * so a run can be captured with `grep '^BENCH '` and compared between
+ * component versions or Kconfig modes (see compare.py). The first line,
+ * "config", records the options the run was built with.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_attr.h"
+#include "esp_system.h"
+
+#include "esp_bus.h"
+
+#define REQ_SAMPLES     2000
+#define EMIT_COUNT      5000
+#define WILD_COUNT      2000
+#define TIMER_RUNS      200
+#define MAX_SUBS        64
+
+//-----------------------------------------------------------------------------
+// Heap operation counting
+//-----------------------------------------------------------------------------
+
+static volatile bool s_heap_counting = false;
+static volatile uint32_t s_heap_ops = 0;
+
+#ifdef CONFIG_HEAP_USE_HOOKS
+void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    if (s_heap_counting) __atomic_add_fetch(&s_heap_ops, 1, __ATOMIC_RELAXED);
+}
+
+void IRAM_ATTR esp_heap_trace_free_hook(void *ptr)
+{
+    if (s_heap_counting) __atomic_add_fetch(&s_heap_ops, 1, __ATOMIC_RELAXED);
+}
+#endif
+
+static void heap_window_start(void)
+{
+    s_heap_ops = 0;
+    s_heap_counting = true;
+}
+
+/**
+ * @brief Heap allocations plus frees per operation, -1 without heap hooks
+ */
+static float heap_window_end(uint32_t ops)
+{
+    s_heap_counting = false;
+#ifdef CONFIG_HEAP_USE_HOOKS
+    return ops ? (float)s_heap_ops / ops : 0;
+#else
+    return -1;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------------------
+
+static uint32_t s_samples[REQ_SAMPLES];
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Percentile of a sample set (sorts it in place)
+ */
+static uint32_t percentile(uint32_t *v, size_t n, int pct)
+{
+    qsort(v, n, sizeof(*v), cmp_u32);
+    size_t i = (n * pct) / 100;
+    return v[i < n ? i : n - 1];
+}
+
+static uint32_t ops_per_s(uint32_t ops, int64_t us)
+{
+    return us > 0 ? (uint32_t)(ops * 1000000LL / us) : 0;
+}
+
+//-----------------------------------------------------------------------------
+// Bench modules
+//-----------------------------------------------------------------------------
+
+static volatile uint32_t s_delivered = 0;
+
+static esp_err_t bench_req_handler(const char *action,
+                                   const void *req, size_t req_len,
+                                   void *res, size_t res_size, size_t *res_len,
+                                   void *ctx)
+{
+    if (strcmp(action, "echo") == 0 && req && res) {
+        size_t n = req_len < res_size ? req_len : res_size;
+        memcpy(res, req, n);
+        if (res_len) *res_len = n;
+    }
+    return ESP_OK;
+}
+
+static void count_handler(const char *evt, const void *data, size_t len, void *ctx)
+{
+    s_delivered++;
+}
+
+/**
+ * @brief Wait until the bus task went through everything queued before
+ *
+ * Events and the bench module's requests share the normal lane, so one
+ * blocking request is served after every earlier emit.
+ */
+static void barrier(void)
+{
+    esp_bus_req("bench.nop", NULL, 0, NULL, 0, NULL, 5000);
+}
+
+//-----------------------------------------------------------------------------
+// Request round trip
+//-----------------------------------------------------------------------------
+
+static void bench_req_rtt(const char *name, const char *pattern, bool handle)
+{
+    esp_bus_handle_t h = esp_bus_resolve(pattern);
+    uint32_t payload = 0x12345678, res = 0;
+    
+    for (int i = 0; i < 100; i++) {
+        esp_bus_req_h(h, &payload, sizeof(payload), &res, sizeof(res), NULL, 1000);
+    }
+    
+    heap_window_start();
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < REQ_SAMPLES; i++) {
+        int64_t t = esp_timer_get_time();
+        if (handle) {
+            esp_bus_req_h(h, &payload, sizeof(payload), &res, sizeof(res), NULL, 1000);
+        } else {
+            esp_bus_req(pattern, &payload, sizeof(payload), &res, sizeof(res), NULL, 1000);
+        }
+        s_samples[i] = (uint32_t)(esp_timer_get_time() - t);
+    }
+    int64_t total = esp_timer_get_time() - start;
+    float heap = heap_window_end(REQ_SAMPLES);
+    
+    uint32_t p50 = percentile(s_samples, REQ_SAMPLES, 50);
+    uint32_t p99 = percentile(s_samples, REQ_SAMPLES, 99);
+    printf("BENCH {\"name\":\"%s\",\"api\":\"%s\",\"n\":%d,\"ops_s\":%lu,"
+           "\"p50_us\":%lu,\"p99_us\":%lu,\"max_us\":%lu,\"heap_per_op\":%.2f}\n",
+           name, handle ? "handle" : "string", REQ_SAMPLES,
+           (unsigned long)ops_per_s(REQ_SAMPLES, total), (unsigned long)p50,
+           (unsigned long)p99, (unsigned long)s_samples[REQ_SAMPLES - 1], heap);
+}
+
+static void bench_req_nowait(void)
+{
+    esp_bus_handle_t h = esp_bus_resolve("bench.nop");
+    barrier();
+    
+    heap_window_start();
+    int64_t start = esp_timer_get_time();
+    int sent = 0;
+    while (sent < EMIT_COUNT) {
+        if (esp_bus_req_h(h, NULL, 0, NULL, 0, NULL, ESP_BUS_NO_WAIT) == ESP_OK) sent++;
+        else taskYIELD();
+    }
+    barrier();
+    int64_t total = esp_timer_get_time() - start;
+    float heap = heap_window_end(EMIT_COUNT);
+    
+    printf("BENCH {\"name\":\"req_nowait\",\"n\":%d,\"ops_s\":%lu,\"heap_per_op\":%.2f}\n",
+           EMIT_COUNT, (unsigned long)ops_per_s(EMIT_COUNT, total), heap);
+}
+
+//-----------------------------------------------------------------------------
+// Emit throughput
+//-----------------------------------------------------------------------------
+
+static void bench_emit(int subs, size_t payload_len, bool handle)
+{
+    int ids[MAX_SUBS];
+    for (int i = 0; i < subs; i++) ids[i] = esp_bus_sub("bench:evt", count_handler, NULL);
+    
+    esp_bus_handle_t h = esp_bus_resolve("bench:evt");
+    uint8_t payload[64] = {0};
+    barrier();
+    s_delivered = 0;
+    
+    // Producer waits for room instead of dropping (see esp_bus_overflow)
+    heap_window_start();
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < EMIT_COUNT; i++) {
+        if (handle) esp_bus_emit_h(h, payload, payload_len);
+        else esp_bus_emit("bench", "evt", payload, payload_len);
+    }
+    barrier();
+    int64_t total = esp_timer_get_time() - start;
+    float heap = heap_window_end(EMIT_COUNT);
+    
+    printf("BENCH {\"name\":\"emit\",\"api\":\"%s\",\"subs\":%d,\"payload\":%u,\"n\":%d,"
+           "\"ops_s\":%lu,\"delivered\":%lu,\"heap_per_op\":%.2f}\n",
+           handle ? "handle" : "string", subs, (unsigned)payload_len, EMIT_COUNT,
+           (unsigned long)ops_per_s(EMIT_COUNT, total), (unsigned long)s_delivered, heap);
+    
+    for (int i = 0; i < subs; i++) esp_bus_unsub(ids[i]);
+}
+
+//-----------------------------------------------------------------------------
+// Wildcard dispatch cost
+//-----------------------------------------------------------------------------
+
+static void bench_wildcard(const char *kind, const char *pattern, int subs)
+{
+    int ids[MAX_SUBS];
+    for (int i = 0; i < subs; i++) ids[i] = esp_bus_sub(pattern, count_handler, NULL);
+    
+    // Decoys that share the bus but never match
+    int decoys[8];
+    for (int i = 0; i < 8; i++) {
+        char p[ESP_BUS_PATTERN_MAX];
+        snprintf(p, sizeof(p), "other%d:*", i);
+        decoys[i] = esp_bus_sub(p, count_handler, NULL);
+    }
+    
+    esp_bus_handle_t h = esp_bus_resolve("bench:tick");
+    barrier();
+    s_delivered = 0;
+    
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < WILD_COUNT; i++) esp_bus_emit_h(h, NULL, 0);
+    barrier();
+    int64_t total = esp_timer_get_time() - start;
+    
+    printf("BENCH {\"name\":\"wildcard\",\"kind\":\"%s\",\"subs\":%d,\"n\":%d,"
+           "\"ns_per_evt\":%lu,\"ns_per_delivery\":%lu,\"delivered\":%lu}\n",
+           kind, subs, WILD_COUNT, (unsigned long)(total * 1000 / WILD_COUNT),
+           (unsigned long)(s_delivered ? total * 1000 / s_delivered : 0),
+           (unsigned long)s_delivered);
+    
+    for (int i = 0; i < 8; i++) esp_bus_unsub(decoys[i]);
+    for (int i = 0; i < subs; i++) esp_bus_unsub(ids[i]);
+}
+
+//-----------------------------------------------------------------------------
+// Service jitter
+//-----------------------------------------------------------------------------
+
+static int64_t s_runs[TIMER_RUNS];
+static volatile int s_run_cnt = 0;
+
+static void timer_fn(void *ctx)
+{
+    if (s_run_cnt < TIMER_RUNS) s_runs[s_run_cnt++] = esp_timer_get_time();
+}
+
+static void bench_timer(uint32_t interval_ms)
+{
+    s_run_cnt = 0;
+    int id = esp_bus_every(timer_fn, interval_ms, NULL);
+    while (s_run_cnt < TIMER_RUNS) vTaskDelay(pdMS_TO_TICKS(interval_ms * 10));
+    
+    esp_bus_svc_stats_t st = {0};
+    esp_bus_svc_stats(id, &st);
+    esp_bus_cancel(id);
+    
+    // Deviation from the fixed timeline started by the first run
+    int64_t period = interval_ms * 1000LL;
+    int n = TIMER_RUNS - 1;
+    for (int i = 1; i < TIMER_RUNS; i++) {
+        int64_t off = s_runs[i] - s_runs[0];
+        int64_t slot = (off + period / 2) / period;
+        int64_t dev = off - slot * period;
+        s_samples[i - 1] = (uint32_t)(dev < 0 ? -dev : dev);
+    }
+    uint32_t p50 = percentile(s_samples, n, 50);
+    uint32_t p99 = percentile(s_samples, n, 99);
+    
+    printf("BENCH {\"name\":\"timer\",\"interval_ms\":%lu,\"n\":%d,\"jitter_p50_us\":%lu,"
+           "\"jitter_p99_us\":%lu,\"jitter_max_us\":%lu,\"late_avg_us\":%lu,"
+           "\"late_max_us\":%lu,\"missed\":%lu}\n",
+           (unsigned long)interval_ms, n, (unsigned long)p50, (unsigned long)p99,
+           (unsigned long)s_samples[n - 1], (unsigned long)st.late_avg_us,
+           (unsigned long)st.late_max_us, (unsigned long)st.missed);
+}
+
+//-----------------------------------------------------------------------------
+// Main
+//-----------------------------------------------------------------------------
+
+static void print_config(void)
+{
+#ifdef CONFIG_ESP_BUS_HIRES_TIMER
+    int hires = 1;
+#else
+    int hires = 0;
+#endif
+#ifdef CONFIG_ESP_BUS_PROFILE
+    int profile = 1;
+#else
+    int profile = 0;
+#endif
+    printf("BENCH {\"name\":\"config\",\"idf\":\"%s\",\"tick_hz\":%d,\"queue\":%d,"
+           "\"inline\":%d,\"workers\":%d,\"hires\":%d,\"profile\":%d}\n",
+           esp_get_idf_version(), configTICK_RATE_HZ, CONFIG_ESP_BUS_QUEUE_SIZE,
+           CONFIG_ESP_BUS_INLINE_PAYLOAD_SIZE, CONFIG_ESP_BUS_WORKERS, hires, profile);
+}
+
+void app_main(void)
+{
+    ESP_ERROR_CHECK(esp_bus_init());
+    esp_bus_log_level(ESP_LOG_ERROR);
+    
+    esp_bus_module_t mod = { .name = "bench", .on_req = bench_req_handler };
+    ESP_ERROR_CHECK(esp_bus_reg(&mod));
+    ESP_ERROR_CHECK(esp_bus_overflow("bench:evt", ESP_BUS_OVERFLOW_BLOCK, 1000));
+    ESP_ERROR_CHECK(esp_bus_overflow("bench:tick", ESP_BUS_OVERFLOW_BLOCK, 1000));
+    
+    print_config();
+    
+    bench_req_rtt("req_rtt", "bench.echo", false);
+    bench_req_rtt("req_rtt", "bench.echo", true);
+#if CONFIG_ESP_BUS_WORKERS > 0
+    esp_bus_module_t wmod = { .name = "benchw", .on_req = bench_req_handler, .worker = 1 };
+    ESP_ERROR_CHECK(esp_bus_reg(&wmod));
+    bench_req_rtt("req_rtt_worker", "benchw.echo", true);
+    esp_bus_unreg("benchw");
+#endif
+    bench_req_nowait();
+    
+    static const int subs[] = { 0, 1, 8 };
+    for (size_t i = 0; i < sizeof(subs) / sizeof(subs[0]); i++) {
+        bench_emit(subs[i], 4, false);
+        bench_emit(subs[i], 4, true);
+        bench_emit(subs[i], 48, true);
+    }
+    
+    static const struct { const char *kind; const char *pattern; } kinds[] = {
+        { "exact",  "bench:tick" },
+        { "prefix", "bench:*" },
+        { "suffix", "*:tick" },
+        { "glob",   "b*ch:t*k" },
+    };
+    static const int counts[] = { 1, 4, 16, 64 };
+    for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+            bench_wildcard(kinds[k].kind, kinds[k].pattern, counts[c]);
+        }
+    }
+    
+    bench_timer(1);
+    bench_timer(10);
+    
+    printf("BENCH {\"name\":\"done\"}\n");
+    esp_bus_unreg("bench");
+    esp_bus_deinit();
+}
@@ -0,0 +1 @@
+CONFIG_ESP_BUS_PROFILE=y
@@ -41,6 +41,14 @@ extern "C" {
 // Types
 // ============================================================================
 
+/**
+ * @brief Pre-resolved pattern handle
+ * 
+ * Obtained from esp_bus_resolve(). Valid until esp_bus_deinit(); survives
+ * unregistering and re-registering the target module.
+ */
+typedef struct esp_bus_pat *esp_bus_handle_t;
+
 /**
  * @brief Request handler callback
  */
@@ -74,6 +82,27 @@ typedef void (*esp_bus_transform_fn)(
     void *ctx
 );
 
+/**
+ * @brief Completion callback of an async request
+ *
+ * Runs on the task serving the module, right after its handler. res is
+ * only valid during the call.
+ */
+typedef void (*esp_bus_done_fn)(esp_err_t err, const void *res, size_t res_len, void *ctx);
+
+/**
+ * @brief Transform callback returning a resolved target
+ * 
+ * Like esp_bus_transform_fn, but sets *out_req to a handle from
+ * esp_bus_resolve() (NULL for no request), so the hop involves no pattern
+ * lookup.
+ */
+typedef void (*esp_bus_transform_h_fn)(
+    const char *evt, const void *data, size_t len,
+    esp_bus_handle_t *out_req, void **out_data, size_t *out_len,
+    void *ctx
+);
+
 /**
  * @brief Error callback
  */
@@ -81,12 +110,17 @@ typedef void (*esp_bus_err_fn)(const char *pattern, esp_err_t err, const char *m
 
 /**
  * @brief Action schema
+ *
+ * With a handler set, requests for the action call it directly: the
+ * action is looked up once when its pattern is bound, not per request.
+ * Actions without one go to the module's on_req.
  */
 typedef struct {
     const char *name;
     const char *req_type;
     const char *res_type;
     const char *desc;
+    esp_bus_req_fn handler;     // Optional, receives the module ctx
 } esp_bus_action_t;
 
 /**
@@ -112,8 +146,191 @@ typedef struct {
     size_t action_cnt;
     const esp_bus_event_t *events;
     size_t event_cnt;
+    
+    // Serving task (optional): 0 bus task, 1..CONFIG_ESP_BUS_WORKERS worker
+    uint8_t worker;
 } esp_bus_module_t;
 
+/**
+ * @brief Result of one target of esp_bus_req_all()
+ */
+typedef struct {
+    char module[ESP_BUS_NAME_MAX];
+    esp_err_t err;
+} esp_bus_target_res_t;
+
+/**
+ * @brief Subscription declared with ESP_BUS_SUB_DEFINE()
+ */
+typedef struct {
+    const char *pattern;
+    esp_bus_evt_fn handler;
+    void *ctx;
+} esp_bus_sub_desc_t;
+
+/**
+ * @brief Route declared with ESP_BUS_ROUTE_DEFINE()
+ */
+typedef struct {
+    const char *evt_pattern;
+    const char *req_pattern;
+    const void *req_data;
+    size_t req_len;
+} esp_bus_route_desc_t;
+
+/**
+ * @brief Batch emit entry
+ *
+ * Set either h, or src and evt.
+ */
+typedef struct {
+    const char *src;
+    const char *evt;
+    esp_bus_handle_t h;
+    const void *data;
+    size_t len;
+} esp_bus_evt_batch_t;
+
+/**
+ * @brief What a repeating service does when it falls behind its timeline
+ */
+typedef enum {
+    ESP_BUS_OVERRUN_SKIP = 0,   ///< Drop missed runs, keep the original phase (default)
+    ESP_BUS_OVERRUN_CATCH_UP,   ///< Run missed periods back-to-back, up to a cap
+    ESP_BUS_OVERRUN_COALESCE,   ///< Run once for all missed periods, restart timeline
+} esp_bus_overrun_t;
+
+/**
+ * @brief Service timing statistics
+ */
+typedef struct {
+    uint32_t runs;              // Callbacks executed
+    uint32_t missed;            // Periods skipped or coalesced
+    uint32_t late_max_us;       // Worst start delay past the deadline
+    uint32_t late_avg_us;       // Mean start delay past the deadline
+} esp_bus_svc_stats_t;
+
+/**
+ * @brief Subscription timing statistics
+ *
+ * Kept only for subscriptions with a budget or an offload worker.
+ */
+typedef struct {
+    uint32_t calls;             // Handler runs
+    uint32_t over_budget;       // Runs longer than the budget
+    uint32_t max_us;            // Longest run
+    uint32_t offloaded;         // Events handed to the worker
+    uint32_t drops;             // Events lost to a full worker queue
+} esp_bus_sub_stats_t;
+
+/**
+ * @brief Bus task lane of a pattern's messages
+ */
+typedef enum {
+    ESP_BUS_PRIO_HIGH = 0,      ///< Served before everything else
+    ESP_BUS_PRIO_NORMAL,        ///< Default
+    ESP_BUS_PRIO_LOW,           ///< Bulk traffic, served when higher lanes allow
+    ESP_BUS_PRIO_MAX,
+} esp_bus_prio_t;
+
+/**
+ * @brief What an event emit does when its lane is full
+ */
+typedef enum {
+    ESP_BUS_OVERFLOW_DROP_NEWEST = 0,   ///< Fail with ESP_ERR_TIMEOUT (default)
+    ESP_BUS_OVERFLOW_BLOCK,             ///< Wait up to the pattern's timeout for room
+    ESP_BUS_OVERFLOW_DROP_OLDEST,       ///< Evict the oldest queued event of the lane
+    ESP_BUS_OVERFLOW_COALESCE,          ///< Conflate the topic (see esp_bus_conflate())
+} esp_bus_overflow_t;
+
+/**
+ * @brief Lane congestion callback
+ * @param congested true when a lane reached the high watermark, false once
+ *        every lane is back at or below the low watermark
+ */
+typedef void (*esp_bus_flow_fn)(bool congested, void *ctx);
+
+#define ESP_BUS_POOL_CLASSES  3
+
+/**
+ * @brief Payload pool statistics
+ */
+typedef struct {
+    uint32_t hits;              // Payloads served from a pool block
+    uint32_t misses;            // Payloads that fell back to the heap
+    struct {
+        uint16_t block_size;
+        uint16_t count;
+        uint16_t in_use;
+        uint16_t high_water;
+    } cls[ESP_BUS_POOL_CLASSES];
+} esp_bus_pool_stats_t;
+
+#define ESP_BUS_HIST_BUCKETS  8
+
+/**
+ * @brief Fixed-bucket duration histogram (CONFIG_ESP_BUS_PROFILE)
+ *
+ * Bucket 0 counts durations under 16 us, bucket i under 4^(i + 2) us;
+ * the last one is unbounded (64 ms and more).
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t buckets[ESP_BUS_HIST_BUCKETS];
+} esp_bus_hist_t;
+
+/**
+ * @brief Profiler statistics of one pattern or a set of patterns
+ */
+typedef struct {
+    esp_bus_hist_t latency;     // Enqueue to dispatch, queued messages only
+    esp_bus_hist_t exec;        // Handler time: requests served, events dispatched
+    uint16_t lane_high_water[ESP_BUS_PRIO_MAX];     // Deepest each lane got, bus-wide
+    uint32_t wakeups;           // Bus task wake-ups since the last reset, bus-wide
+    uint32_t wakeups_per_s;     // Average wake-up rate since the last reset
+} esp_bus_stats_t;
+
+/**
+ * @brief Trace record kinds
+ */
+typedef enum {
+    ESP_BUS_TRACE_BOOT = 0,     ///< esp_bus_init() ran; pattern ids restart here
+    ESP_BUS_TRACE_REQ,          ///< Request served, err is the handler result
+    ESP_BUS_TRACE_EVT,          ///< Event dispatched to its subscribers and routes
+    ESP_BUS_TRACE_DROP,         ///< Event dropped or evicted from a full lane
+} esp_bus_trace_type_t;
+
+/**
+ * @brief Trace ring record (CONFIG_ESP_BUS_TRACE_SIZE), 16 bytes
+ *
+ * Records are stored in completion order, so a long handler shows up after
+ * records that started later.
+ */
+typedef struct {
+    uint32_t ts_us;             // Handler start, esp_timer_get_time() low 32 bits
+    uint16_t pat_id;            // Interned pattern id, see esp_bus_trace_dump()
+    uint8_t type;               // esp_bus_trace_type_t
+    uint8_t task;               // 0 bus task, n worker n, 0xff any other task
+    uint16_t len;               // Payload length, saturated
+    uint16_t dur_us;            // Handler time, saturated
+    int32_t err;                // esp_err_t
+} esp_bus_trace_rec_t;
+
+/**
+ * @brief Reference-counted event payload
+ *
+ * Written by the producer, then read-only once emitted. Freed (or returned
+ * to the payload pool) when the last reference is released.
+ */
+typedef struct {
+    uint32_t refs;              // Managed by acquire/release
+    size_t size;                // Capacity of data[]
+    size_t len;                 // Bytes in use, size after alloc
+    uint8_t data[];
+} esp_bus_buf_t;
+
 // ============================================================================
 // Core API
 // ============================================================================
@@ -149,10 +366,149 @@ esp_err_t esp_bus_reg(const esp_bus_module_t *module);
 /**
  * @brief Unregister a module
  * @param name Module name
- * @return ESP_OK on success
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED for a static module
  */
 esp_err_t esp_bus_unreg(const char *name);
 
+/**
+ * @brief Resolve pattern to a handle
+ * 
+ * Parses the pattern once and binds it to the target module, so requests
+ * and events sent through the handle skip all string work. If the module
+ * is unregistered, the handle behaves like an unknown module until it is
+ * registered again.
+ * 
+ * @param pattern Pattern "module.action" or "module:event" (no wildcards)
+ * @return Handle, or NULL if the pattern is invalid or out of memory
+ */
+esp_bus_handle_t esp_bus_resolve(const char *pattern);
+
+/**
+ * @brief Set the lane of a pattern's requests or events
+ * 
+ * The bus task always takes the highest non-empty lane first. A lower lane
+ * passed over CONFIG_ESP_BUS_PRIO_BURST times in a row gets the next turn,
+ * so it is delayed but never starved. Requests to worker modules keep
+ * their worker's single queue.
+ * 
+ * @param pattern Pattern "module.action" or "module:event" (no wildcards)
+ * @param prio Lane, ESP_BUS_PRIO_NORMAL by default
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG
+ */
+esp_err_t esp_bus_prio(const char *pattern, esp_bus_prio_t prio);
+
+/**
+ * @brief Conflate a state topic to its latest value
+ * 
+ * While an emit for the event is still queued, esp_bus_emit() replaces
+ * its payload instead of taking another queue slot, so a fast producer
+ * holds at most one slot. Subscribers see only the latest value. Applies
+ * to esp_bus_emit()/esp_bus_emit_h(); batches and shared buffers are
+ * queued as usual.
+ * 
+ * @param pattern Pattern "module:event" (no wildcards)
+ * @param enable true to conflate, false for one message per emit (default)
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG
+ */
+esp_err_t esp_bus_conflate(const char *pattern, bool enable);
+
+/**
+ * @brief Set what emitting an event does when its lane is full
+ * 
+ * Drops are counted (esp_bus_drop_count()) and reported through
+ * esp_bus_on_err(). Emits from the bus task itself never block or evict.
+ * Batches always use ESP_BUS_OVERFLOW_DROP_NEWEST.
+ * 
+ * @param pattern Pattern "module:event" (no wildcards)
+ * @param policy Overflow policy
+ * @param timeout_ms Longest wait for ESP_BUS_OVERFLOW_BLOCK
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG
+ */
+esp_err_t esp_bus_overflow(const char *pattern, esp_bus_overflow_t policy, uint32_t timeout_ms);
+
+/**
+ * @brief Watch the lanes for congestion
+ * 
+ * fn(true) runs on the emitting task when a lane holds high messages;
+ * fn(false) runs on the bus task once all lanes are down to low. Keep it
+ * short: producers typically just set a throttle flag.
+ * 
+ * @param high High watermark in messages (1..CONFIG_ESP_BUS_QUEUE_SIZE)
+ * @param low Low watermark in messages, below high
+ * @param fn Callback, NULL to stop watching
+ * @param ctx User context
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG
+ */
+esp_err_t esp_bus_flow(uint16_t high, uint16_t low, esp_bus_flow_fn fn, void *ctx);
+
+/**
+ * @brief Messages dropped because a lane was full
+ * @param pattern Pattern "module:event", or NULL for the total
+ * @return Drop count since init
+ */
+uint32_t esp_bus_drop_count(const char *pattern);
+
+/**
+ * @brief Retain the last value of an event topic
+ * 
+ * The bus keeps a copy of the last delivered payload. New subscriptions
+ * matching the topic receive it on the bus task right after subscribing,
+ * and esp_bus_get_retained() reads it without a request round trip.
+ * 
+ * @param pattern Pattern "module:event" (no wildcards)
+ * @param enable true to retain, false to drop the value (default)
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG
+ */
+esp_err_t esp_bus_retain(const char *pattern, bool enable);
+
+// ============================================================================
+// Static Registration
+// ============================================================================
+
+/**
+ * @brief Define a module at compile time
+ *
+ * The descriptor is placed in flash in a name-sorted linker section and
+ * used in place by esp_bus_init(): no allocation, no registration call,
+ * and lookups by name are a binary search. The module name is the
+ * identifier, so it must be a valid C identifier. Static modules cannot
+ * be unregistered.
+ *
+ * The section is only collected from objects that end up linked. If the
+ * file holds nothing else referenced by the application, register its
+ * component with WHOLE_ARCHIVE.
+ *
+ * @code
+ * ESP_BUS_MODULE_DEFINE(sensor,
+ *     .on_req = sensor_req,
+ *     .actions = sensor_actions,
+ *     .action_cnt = 2,
+ * );
+ * @endcode
+ */
+#define ESP_BUS_MODULE_DEFINE(id, ...) \
+    __attribute__((used, section(".esp_bus_mod." #id), aligned(__alignof__(esp_bus_module_t)))) \
+    static const esp_bus_module_t esp_bus_mod_##id = { .name = #id, __VA_ARGS__ }
+
+/**
+ * @brief Define a subscription installed by esp_bus_init()
+ * @param id Unique identifier for the descriptor
+ */
+#define ESP_BUS_SUB_DEFINE(id, pattern_, handler_, ctx_) \
+    __attribute__((used, section(".esp_bus_sub"), aligned(__alignof__(esp_bus_sub_desc_t)))) \
+    static const esp_bus_sub_desc_t esp_bus_sub_##id = { \
+        .pattern = (pattern_), .handler = (handler_), .ctx = (ctx_) }
+
+/**
+ * @brief Define an event-to-request route installed by esp_bus_init()
+ * @param id Unique identifier for the descriptor
+ */
+#define ESP_BUS_ROUTE_DEFINE(id, evt_pattern_, req_pattern_, req_data_, req_len_) \
+    __attribute__((used, section(".esp_bus_route"), aligned(__alignof__(esp_bus_route_desc_t)))) \
+    static const esp_bus_route_desc_t esp_bus_route_##id = { \
+        .evt_pattern = (evt_pattern_), .req_pattern = (req_pattern_), \
+        .req_data = (req_data_), .req_len = (req_len_) }
+
 // ============================================================================
 // Request API
 // ============================================================================
@@ -166,7 +522,9 @@ esp_err_t esp_bus_unreg(const char *name);
  * @param res_size Response buffer size
  * @param res_len Actual response length (output)
  * @param timeout_ms Timeout in ms
- * @return ESP_OK on success
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if no result within timeout_ms
+ *         (res is not written after that), ESP_ERR_NO_MEM if all
+ *         CONFIG_ESP_BUS_REPLY_SLOTS callers are already waiting
  */
 esp_err_t esp_bus_req(
     const char *pattern,
@@ -175,6 +533,96 @@ esp_err_t esp_bus_req(
     uint32_t timeout_ms
 );
 
+/**
+ * @brief Send request using a resolved handle
+ * @param h Handle for "module.action"
+ * @see esp_bus_req
+ */
+esp_err_t esp_bus_req_h(
+    esp_bus_handle_t h,
+    const void *req, size_t req_len,
+    void *res, size_t res_size, size_t *res_len,
+    uint32_t timeout_ms
+);
+
+/**
+ * @brief Send request and take the response as a bus buffer
+ *
+ * For variable-size answers: the handler sizes the response with
+ * esp_bus_res_buf() and it is handed over without a copy, so no probe
+ * request or oversized caller buffer is needed.
+ * @param pattern Pattern "module.action"
+ * @param req Request data
+ * @param req_len Request length
+ * @param res Set to the response (release with esp_bus_buf_release()), or
+ *            NULL if the handler returned none
+ * @param timeout_ms Timeout in ms (must be > 0)
+ * @return Handler result, ESP_ERR_TIMEOUT, or ESP_ERR_INVALID_ARG
+ */
+esp_err_t esp_bus_req_buf(const char *pattern, const void *req, size_t req_len,
+                          esp_bus_buf_t **res, uint32_t timeout_ms);
+
+/**
+ * @brief Send buffer request using a resolved handle
+ * @see esp_bus_req_buf
+ */
+esp_err_t esp_bus_req_buf_h(esp_bus_handle_t h, const void *req, size_t req_len,
+                            esp_bus_buf_t **res, uint32_t timeout_ms);
+
+/**
+ * @brief Send request without waiting for the result
+ *
+ * The handler gets a response buffer of res_size bytes owned by the bus;
+ * done receives the result. Nothing is allocated from the kernel, so many
+ * requests can be outstanding at once. When called from the task serving
+ * the module, done runs before this returns.
+ * @param pattern Pattern "module.action"
+ * @param req Request data (copied)
+ * @param req_len Request length
+ * @param res_size Response buffer size (0 for none)
+ * @param done Completion callback
+ * @param ctx User context for done
+ * @return ESP_OK if queued (done will be called), ESP_ERR_TIMEOUT if the
+ *         queue is full
+ */
+esp_err_t esp_bus_req_async(const char *pattern, const void *req, size_t req_len,
+                            size_t res_size, esp_bus_done_fn done, void *ctx);
+
+/**
+ * @brief Send async request using a resolved handle
+ * @see esp_bus_req_async
+ */
+esp_err_t esp_bus_req_async_h(esp_bus_handle_t h, const void *req, size_t req_len,
+                              size_t res_size, esp_bus_done_fn done, void *ctx);
+
+/**
+ * @brief Send one request to every module matching a pattern
+ *
+ * The module part may hold '*' wildcards ("led*.off", "*.reset"); the
+ * action is exact. Modules with a schema that lacks the action are left
+ * out. The request is queued once and fanned out by the bus task; targets
+ * on a worker are served there. Called from the bus task or a worker, the
+ * caller fans out itself and serves its own targets inline. Responses are
+ * not collected.
+ *
+ * Results are reported only with a timeout: per target (up to max, in
+ * module table order) and as the return value, ESP_OK when all succeeded,
+ * otherwise the first error seen.
+ *
+ * @param pattern Target pattern "module_glob.action"
+ * @param req Request data
+ * @param req_len Request data length
+ * @param res Per-target results (optional)
+ * @param max Capacity of res
+ * @param cnt Number of targets matched, may exceed max (optional)
+ * @param timeout_ms Wait for all targets (0 = fire and forget)
+ * @return ESP_OK, the first target error, ESP_ERR_NOT_FOUND if nothing
+ *         matched, or ESP_ERR_TIMEOUT
+ */
+esp_err_t esp_bus_req_all(const char *pattern, const void *req, size_t req_len,
+                          esp_bus_target_res_t *res, size_t max, size_t *cnt,
+                          uint32_t timeout_ms);
+
 /**
  * @brief Call without response
  */
@@ -201,8 +649,81 @@ esp_err_t esp_bus_req(
  */
 esp_err_t esp_bus_emit(const char *src, const char *evt, const void *data, size_t len);
 
+/**
+ * @brief Emit event using a resolved handle
+ * @param h Handle for "module:event"
+ * @param data Event data
+ * @param len Data length
+ * @return ESP_OK on success
+ */
+esp_err_t esp_bus_emit_h(esp_bus_handle_t h, const void *data, size_t len);
+
+/**
+ * @brief Emit event from ISR
+ *
+ * Copies the event into a preallocated ring drained by the bus task; never
+ * allocates or blocks. Not IRAM-safe: do not call while the flash cache is
+ * disabled.
+ * @param src Source module name
+ * @param evt Event name
+ * @param data Event data (at most CONFIG_ESP_BUS_ISR_PAYLOAD_MAX bytes)
+ * @param len Data length
+ * @param woken Set to pdTRUE if a context switch should be requested
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the ring is full
+ */
+esp_err_t esp_bus_emit_isr(const char *src, const char *evt, const void *data, size_t len,
+                           BaseType_t *woken);
+
+/**
+ * @brief Emit event from ISR using a resolved handle
+ */
+esp_err_t esp_bus_emit_isr_h(esp_bus_handle_t h, const void *data, size_t len,
+                             BaseType_t *woken);
+
+/**
+ * @brief Emit several events as one queued message
+ *
+ * Payloads are copied into a single buffer and the events are dispatched
+ * in order. Nothing is queued if any entry is invalid.
+ * @param evts Batch entries
+ * @param n Number of entries
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the queue is full
+ */
+esp_err_t esp_bus_emit_batch(const esp_bus_evt_batch_t *evts, size_t n);
+
+/**
+ * @brief Emit a shared buffer without copying it
+ *
+ * On success the bus takes over the caller's reference; subscribers get
+ * buf->data and may keep it past the callback with esp_bus_cur_buf().
+ * On failure the caller still owns its reference.
+ * @param src Source module name
+ * @param evt Event name
+ * @param buf Buffer from esp_bus_buf_alloc()
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the queue is full
+ */
+esp_err_t esp_bus_emit_buf(const char *src, const char *evt, esp_bus_buf_t *buf);
+
+/**
+ * @brief Emit a shared buffer using a resolved handle
+ */
+esp_err_t esp_bus_emit_buf_h(esp_bus_handle_t h, esp_bus_buf_t *buf);
+
+/**
+ * @brief Read the retained value of a topic
+ * @param pattern Pattern "module:event"
+ * @param buf Destination buffer
+ * @param size Buffer size; longer values are truncated
+ * @param len Full length of the value (output, optional)
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if not retained or nothing emitted yet
+ */
+esp_err_t esp_bus_get_retained(const char *pattern, void *buf, size_t size, size_t *len);
+
 /**
  * @brief Subscribe to events
+ *
+ * Matching retained topics (esp_bus_retain()) are delivered right away.
+ * All subscribers of an event are called before any of its routes.
  * @param pattern Pattern "module:event" (supports wildcards)
  * @param handler Event handler
  * @param ctx User context
@@ -216,12 +737,102 @@ int esp_bus_sub(const char *pattern, esp_bus_evt_fn handler, void *ctx);
  */
 void esp_bus_unsub(int id);
 
+/**
+ * @brief Set a handler time budget
+ *
+ * Every run of the handler is timed. A run over budget is counted and
+ * reported through esp_bus_on_err() with ESP_ERR_TIMEOUT; the handler is
+ * not interrupted.
+ * @param id Subscription ID
+ * @param budget_us Budget in microseconds, 0 to stop measuring
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND
+ */
+esp_err_t esp_bus_sub_budget(int id, uint32_t budget_us);
+
+/**
+ * @brief Run a subscription's handler on a worker task
+ *
+ * The bus task copies each matching event into the worker's queue instead
+ * of calling the handler, so a slow handler (flash writes, long
+ * computations) no longer delays other subscribers, routes and requests.
+ * Events still reach the handler in order. A full worker queue drops the
+ * event (esp_bus_drop_count()). The worker also serves the requests of
+ * modules pinned to it, so the handler must not wait on one of those.
+ * esp_bus_cur_buf() and esp_bus_cur_pattern() return NULL there.
+ * @param id Subscription ID
+ * @param worker Worker 1..CONFIG_ESP_BUS_WORKERS, 0 for the bus task
+ * @return ESP_OK, ESP_ERR_NOT_FOUND, ESP_ERR_INVALID_ARG for an unknown
+ *         worker, or ESP_ERR_NOT_SUPPORTED without workers
+ */
+esp_err_t esp_bus_sub_offload(int id, uint8_t worker);
+
+/**
+ * @brief Get subscription timing statistics
+ */
+esp_err_t esp_bus_sub_stats(int id, esp_bus_sub_stats_t *stats);
+
+// ============================================================================
+// Buffer API
+// ============================================================================
+
+/**
+ * @brief Allocate a shared buffer holding one reference
+ * @param size Payload capacity
+ * @return Buffer, or NULL if out of memory
+ */
+esp_bus_buf_t *esp_bus_buf_alloc(size_t size);
+
+/**
+ * @brief Take another reference
+ * @return buf
+ */
+esp_bus_buf_t *esp_bus_buf_acquire(esp_bus_buf_t *buf);
+
+/**
+ * @brief Drop a reference, freeing the buffer with the last one
+ *
+ * Safe from any task. Release every reference before esp_bus_deinit().
+ */
+void esp_bus_buf_release(esp_bus_buf_t *buf);
+
+/**
+ * @brief Allocate the response of the request being handled
+ *
+ * Call from a request handler; fill data[] and trim len. The bus owns the
+ * buffer: an esp_bus_req_buf() caller receives it, a fixed-buffer caller
+ * gets a copy of up to res_size bytes with *res_len set to the full length.
+ * @param size Payload capacity
+ * @return Buffer, or NULL if nobody reads the response, outside a handler,
+ *         or out of memory
+ */
+esp_bus_buf_t *esp_bus_res_buf(size_t size);
+
+/**
+ * @brief Buffer of the event being dispatched
+ *
+ * Call esp_bus_buf_acquire() on it to keep the payload after the handler
+ * returns.
+ * @return Buffer, or NULL outside a handler or for copied payloads
+ */
+esp_bus_buf_t *esp_bus_cur_buf(void);
+
+/**
+ * @brief Full pattern of the event being dispatched ("src:evt")
+ *
+ * Lets a wildcard subscriber tell sources apart. The string stays valid
+ * until esp_bus_deinit(), so it may be kept and compared by address.
+ * @return Pattern, or NULL outside an event handler on the bus task
+ */
+const char *esp_bus_cur_pattern(void);
+
 // ============================================================================
 // Routing API
 // ============================================================================
 
 /**
  * @brief Connect event to request
+ *
+ * The request runs after every subscriber of the event has been called.
  * @param evt_pattern Event pattern
  * @param req_pattern Request pattern
  * @param req_data Request data to send
@@ -239,6 +850,12 @@ esp_err_t esp_bus_on(
  */
 esp_err_t esp_bus_on_fn(const char *evt_pattern, esp_bus_transform_fn fn, void *ctx);
 
+/**
+ * @brief Connect with a transform that picks a resolved target
+ * @see esp_bus_transform_h_fn
+ */
+esp_err_t esp_bus_on_fn_h(const char *evt_pattern, esp_bus_transform_h_fn fn, void *ctx);
+
 /**
  * @brief Disconnect route
  */
@@ -280,6 +897,47 @@ int esp_bus_after(esp_bus_svc_fn fn, uint32_t delay_ms, void *ctx);
  */
 int esp_bus_every(esp_bus_svc_fn fn, uint32_t interval_ms, void *ctx);
 
+/**
+ * @brief Re-arm a timer in place
+ *
+ * Reschedules a pending or running one-shot (or the next run of a
+ * repeating service) to fire after delay_ms, reusing the same id. Calling
+ * it from the timer's own callback keeps a one-shot alive.
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if the timer already expired
+ */
+esp_err_t esp_bus_rearm(int id, uint32_t delay_ms);
+
+/**
+ * @brief Set overrun policy of a repeating service
+ *
+ * Repeating services are scheduled on a fixed timeline (next += interval),
+ * so dispatch latency does not accumulate.
+ * @param id Service ID
+ * @param policy Overrun policy
+ * @param max_catch_up Back-to-back runs allowed by ESP_BUS_OVERRUN_CATCH_UP
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND
+ */
+esp_err_t esp_bus_svc_policy(int id, esp_bus_overrun_t policy, uint8_t max_catch_up);
+
+/**
+ * @brief Hold the CPU at its maximum frequency while a service runs
+ *
+ * Takes an ESP_PM_CPU_FREQ_MAX lock around each run of the callback and
+ * drops it in between, so dynamic frequency scaling and light sleep stay
+ * available while the service waits for its next deadline.
+ * @param id Service ID
+ * @param max_freq true to take the lock, false to run at whatever the
+ *        power manager picked (default)
+ * @return ESP_OK, ESP_ERR_NOT_FOUND, or ESP_ERR_NOT_SUPPORTED without
+ *         CONFIG_PM_ENABLE
+ */
+esp_err_t esp_bus_svc_pm(int id, bool max_freq);
+
+/**
+ * @brief Get service timing statistics
+ */
+esp_err_t esp_bus_svc_stats(int id, esp_bus_svc_stats_t *stats);
+
 /**
  * @brief Cancel timer
  */
@@ -295,6 +953,23 @@ void esp_bus_trigger(void);
  */
 void esp_bus_trigger_isr(BaseType_t *woken);
 
+/**
+ * @brief Run a callback on the bus task (from ISR)
+ *
+ * Queued through the ISR event ring, in order with esp_bus_emit_isr().
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the ring is full
+ */
+esp_err_t esp_bus_defer_isr(esp_bus_svc_fn fn, void *ctx, BaseType_t *woken);
+
+/**
+ * @brief Run a callback on the bus task (from task)
+ *
+ * Queued through the ISR event ring behind everything interrupts have
+ * queued so far, e.g. to free a context only after its deferred calls ran.
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the ring is full
+ */
+esp_err_t esp_bus_defer(esp_bus_svc_fn fn, void *ctx);
+
 // ============================================================================
 // Query API
 // ============================================================================
@@ -303,6 +978,53 @@ bool esp_bus_exists(const char *module);
 bool esp_bus_has_action(const char *module, const char *action);
 bool esp_bus_has_event(const char *module, const char *event);
 
+/**
+ * @brief Get payload pool statistics
+ */
+esp_err_t esp_bus_pool_stats(esp_bus_pool_stats_t *stats);
+
+/**
+ * @brief Get profiler statistics (CONFIG_ESP_BUS_PROFILE)
+ *
+ * Sums the histograms of every pattern matching pattern, e.g. "btn1.*" for
+ * all requests of a module, "btn1:*" for its events, or one exact pattern.
+ * 
+ * @param pattern Pattern with optional wildcards, NULL for the whole bus
+ * @param stats Output
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if no pattern matched, or
+ *         ESP_ERR_NOT_SUPPORTED when the profiler is compiled out
+ */
+esp_err_t esp_bus_stats_get(const char *pattern, esp_bus_stats_t *stats);
+
+/**
+ * @brief Clear all profiler statistics
+ */
+esp_err_t esp_bus_stats_reset(void);
+
+/**
+ * @brief Copy the most recent trace records, oldest first
+ *
+ * The ring lives in no-init RAM and survives a software reset or panic
+ * reboot, so this also works before esp_bus_init() to read the records of
+ * the previous run. Records written concurrently may come out torn.
+ * 
+ * @param out Output array
+ * @param max Capacity of out
+ * @return Number of records copied (0 when the trace is compiled out)
+ */
+size_t esp_bus_trace_read(esp_bus_trace_rec_t *out, size_t max);
+
+/**
+ * @brief Print the trace ring with esp_rom_printf()
+ *
+ * Takes no locks and does not allocate, so it can run from a panic handler
+ * hook. Pattern ids are printed by name while the bus is initialized, but
+ * only for records after the newest BOOT marker: ids restart at every
+ * esp_bus_init(), so older records, e.g. those of the previous run read
+ * back after a reboot, show the id alone.
+ */
+void esp_bus_trace_dump(void);
+
 // ============================================================================
 // Config API
 // ============================================================================
@@ -0,0 +1,210 @@
+/**
+ * @file esp_bus_bridge.h
+ * @brief ESP Bus - Bridge Module
+ *
+ * Links the buses of two devices over any byte or datagram transport
+ * (UART, SPI, ESP-NOW). Selected local events are forwarded to the peer,
+ * and remote modules show up locally under a name prefix, so a request to
+ * "remote_led.on" is carried over the link and answered by the peer's "led".
+ *
+ * @section Usage
+ *
+ * @code{.c}
+ * #include "esp_bus.h"
+ * #include "esp_bus_bridge.h"
+ * #include "esp_bus_led.h"
+ * #include "driver/uart.h"
+ *
+ * static esp_err_t uart_send(const void *frame, size_t len, void *ctx) {
+ *     return uart_write_bytes(UART_NUM_1, frame, len) == len ? ESP_OK : ESP_FAIL;
+ * }
+ *
+ * static void uart_rx_task(void *arg) {
+ *     uint8_t buf[128];
+ *     for (;;) {
+ *         int n = uart_read_bytes(UART_NUM_1, buf, sizeof(buf), pdMS_TO_TICKS(20));
+ *         if (n > 0) esp_bus_bridge_input("link", buf, n);
+ *     }
+ * }
+ *
+ * void app_main(void) {
+ *     esp_bus_init();
+ *     // ... uart_driver_install(UART_NUM_1, ...) and start uart_rx_task ...
+ *
+ *     esp_bus_bridge_reg("link", &(esp_bus_bridge_cfg_t){
+ *         .prefix = "remote_",
+ *         .send = uart_send,
+ *         .events = (const char *[]){ "btn1:*" },
+ *         .event_cnt = 1,
+ *         .modules = (const char *[]){ "led" },
+ *         .module_cnt = 1,
+ *         .worker = 1,
+ *     });
+ *
+ *     // Served by the peer's "led"
+ *     esp_bus_call(LED_CMD_ON("remote_led"));
+ *
+ *     // The peer's forwarded events arrive under the same prefix
+ *     esp_bus_sub("remote_btn1:*", on_remote_btn, NULL);
+ * }
+ * @endcode
+ *
+ * For ESP-NOW, send with esp_now_send() and pass each received packet to
+ * esp_bus_bridge_input(). A frame never exceeds the configured mtu.
+ *
+ * @section Protocol
+ * A frame is a 2-byte sync word, a 16-bit payload length, the payload and
+ * a CRC-16. The payload holds records packed back to back, so small events
+ * queued within batch_ms share one frame. Patterns cross the link once per
+ * session as a (id, string) definition; events and requests then carry the
+ * 16-bit id. Each side announces itself when registered; on the peer's
+ * announcement the ids are defined anew, and a record with an unknown id
+ * asks the peer to do the same.
+ *
+ * @section Actions
+ * | Action | Request | Response | Description |
+ * |--------|---------|----------|-------------|
+ * | stats | - | esp_bus_bridge_stats_t | Link counters |
+ * | reset_stats | - | - | Clear the counters |
+ * | hello | - | - | Announce again, e.g. after the link came back |
+ *
+ * @section Events
+ * | Event | Data | Description |
+ * |-------|------|-------------|
+ * | peer_up | - | The peer announced itself |
+ */
+
+#pragma once
+
+#include "esp_bus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// Constants (Compile-time safety)
+// ============================================================================
+
+// Actions
+#define BRIDGE_STATS        "stats"
+#define BRIDGE_RESET_STATS  "reset_stats"
+#define BRIDGE_HELLO        "hello"
+
+// Events
+#define BRIDGE_EVT_PEER_UP  "peer_up"
+
+// Pattern builders (use module name as parameter)
+#define BRIDGE_CMD_STATS(name)       name "." BRIDGE_STATS
+#define BRIDGE_CMD_RESET_STATS(name) name "." BRIDGE_RESET_STATS
+#define BRIDGE_CMD_HELLO(name)       name "." BRIDGE_HELLO
+#define BRIDGE_ON_PEER_UP(name)      name ":" BRIDGE_EVT_PEER_UP
+
+// ============================================================================
+// Types
+// ============================================================================
+
+#define ESP_BUS_BRIDGE_IDS_MAX  64      ///< Patterns defined per direction and session
+#define ESP_BUS_BRIDGE_MTU      250     ///< Default frame size, the ESP-NOW payload limit
+
+/**
+ * @brief Transport write: sends one complete frame
+ * @return ESP_OK if the frame was handed to the link
+ */
+typedef esp_err_t (*esp_bus_bridge_send_fn)(const void *frame, size_t len, void *ctx);
+
+/**
+ * @brief Bridge configuration
+ *
+ * The name lists are copied.
+ */
+typedef struct {
+    const char *prefix;                 ///< Local name prefix of remote modules and events
+    esp_bus_bridge_send_fn send;        ///< Transport write
+    void *send_ctx;                     ///< Context for send
+    uint16_t mtu;                       ///< Largest frame in bytes, 0 for ESP_BUS_BRIDGE_MTU
+    uint16_t batch_ms;                  ///< Hold events this long to share a frame, 0 to send at once
+    uint32_t timeout_ms;                ///< Remote request timeout, 0 for 1000
+    const char *const *events;          ///< Local event patterns forwarded to the peer
+    size_t event_cnt;
+    const char *const *modules;         ///< Remote modules exposed as prefix + name
+    size_t module_cnt;
+    const char *const *serve;           ///< Local modules the peer may call, NULL for all
+    size_t serve_cnt;
+    uint8_t worker;                     ///< Task serving the remote modules, see esp_bus_module_t
+} esp_bus_bridge_cfg_t;
+
+/**
+ * @brief Link counters (BRIDGE_STATS)
+ *
+ * Messages are events, requests and responses; pattern definitions and
+ * announcements only count towards frames and bytes.
+ */
+typedef struct {
+    uint32_t tx_frames;
+    uint32_t tx_bytes;
+    uint32_t tx_msgs;
+    uint32_t rx_frames;
+    uint32_t rx_bytes;
+    uint32_t rx_msgs;
+    uint32_t rx_errors;                 ///< Bad CRC, malformed record or unknown id
+    uint32_t drops;                     ///< Lost: too large, id table full, send failed or local queue full
+    uint32_t timeouts;                  ///< Remote requests without a response in time
+    esp_bus_hist_t rtt;                 ///< Remote request round trips
+} esp_bus_bridge_stats_t;
+
+// ============================================================================
+// API
+// ============================================================================
+
+/**
+ * @brief Register a bridge and announce it to the peer
+ *
+ * A remote request blocks the task serving the remote modules until the
+ * response arrives, so give them a worker: on the bus task the whole bus
+ * waits for the link.
+ *
+ * @param name Module name (e.g., "link")
+ * @param cfg Configuration
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if a prefixed name does
+ *         not fit ESP_BUS_NAME_MAX
+ */
+esp_err_t esp_bus_bridge_reg(const char *name, const esp_bus_bridge_cfg_t *cfg);
+
+/**
+ * @brief Feed received bytes to a bridge
+ *
+ * Takes any split of the byte stream, or one datagram per call. Call from
+ * one task per bridge. Received events are emitted and requests queued
+ * from this call.
+ *
+ * @param name Bridge name
+ * @param data Received bytes
+ * @param len Number of bytes
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if no such bridge
+ */
+esp_err_t esp_bus_bridge_input(const char *name, const void *data, size_t len);
+
+/**
+ * @brief Unregister a bridge and its remote modules
+ *
+ * Stop calling esp_bus_bridge_input() first. Remote requests in flight
+ * fail with ESP_ERR_INVALID_STATE.
+ *
+ * @param name Bridge name
+ * @return ESP_OK on success
+ */
+esp_err_t esp_bus_bridge_unreg(const char *name);
+
+// ============================================================================
+// Schema (for validation)
+// ============================================================================
+
+extern const esp_bus_action_t esp_bus_bridge_actions[];
+extern const size_t esp_bus_bridge_action_cnt;
+extern const esp_bus_event_t esp_bus_bridge_events[];
+extern const size_t esp_bus_bridge_event_cnt;
+
+#ifdef __cplusplus
+}
+#endif
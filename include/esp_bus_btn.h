@@ -17,6 +17,7 @@
  *         .active_low = true,
  *         .long_press_ms = 1000,    // Optional, default 1000
  *         .double_press_ms = 300,   // Optional, default 300
+ *         .use_isr = true,          // Optional, no polling while idle
  *     });
  *     
  *     // Direct control
@@ -103,6 +104,7 @@ typedef struct {
     uint32_t long_press_ms;     ///< Long press threshold (default: 1000)
     uint32_t double_press_ms;   ///< Double press window (default: 300)
     uint32_t debounce_ms;       ///< Debounce time (default: 20)
+    bool use_isr;               ///< Edge interrupts, poll only while active (default: false)
 } esp_bus_btn_cfg_t;
 
 /**
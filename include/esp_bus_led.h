@@ -27,6 +27,18 @@
  *     esp_bus_call_s(LED_CMD_BLINK("led1"), "500,500,-1");  // Blink forever
  *     esp_bus_call(LED_CMD_BLINK("led1"));                  // Default 200ms
  *     
+ *     // Typed blink and a pattern (ms, alternating on/off, starting on)
+ *     esp_bus_led_blink_t blink = { .on_ms = 50, .off_ms = 950, .count = -1 };
+ *     esp_bus_req(LED_CMD_BLINK_BIN("led1"), &blink, sizeof(blink), NULL, 0, NULL, 0);
+ *     esp_bus_led_pattern_t sos = {
+ *         .repeat = -1, .step_cnt = 4, .steps = { 100, 100, 300, 500 },
+ *     };
+ *     esp_bus_req(LED_CMD_PATTERN("led1"), &sos, sizeof(sos), NULL, 0, NULL, 0);
+ *     
+ *     // Several LEDs in lockstep, driven by one timer
+ *     esp_bus_led_group_reg("leds", (const char *[]){ "led1", "led2" }, 2);
+ *     esp_bus_call(LED_CMD_BLINK("leds"));
+ *     
  *     // Get state
  *     uint8_t state;
  *     esp_bus_req(LED_CMD_STATE("led1"), NULL, 0, &state, sizeof(state), NULL, 100);
@@ -45,6 +57,8 @@
  * | off | - | - | Turn LED off |
  * | toggle | - | - | Toggle LED state |
  * | blink | string "on,off[,count]" | - | Blink LED |
+ * | blink_bin | esp_bus_led_blink_t | - | Blink LED, binary parameters |
+ * | pattern | esp_bus_led_pattern_t | - | Run a step pattern |
  * | get_state | - | uint8_t | Get LED state (0/1) |
  * 
  * @section Blink Format
@@ -73,6 +87,7 @@ extern "C" {
 #define LED_OFF          "off"
 #define LED_TOGGLE       "toggle"
 #define LED_BLINK        "blink"
+#define LED_BLINK_BIN    "blink_bin"
 #define LED_PATTERN      "pattern"
 #define LED_GET_STATE    "get_state"
 
@@ -81,12 +96,16 @@ extern "C" {
 #define LED_CMD_OFF(name)     name "." LED_OFF
 #define LED_CMD_TOGGLE(name)  name "." LED_TOGGLE
 #define LED_CMD_BLINK(name)   name "." LED_BLINK
+#define LED_CMD_BLINK_BIN(name) name "." LED_BLINK_BIN
+#define LED_CMD_PATTERN(name) name "." LED_PATTERN
 #define LED_CMD_STATE(name)   name "." LED_GET_STATE
 
 // ============================================================================
 // Types
 // ============================================================================
 
+#define ESP_BUS_LED_STEPS_MAX 16
+
 /**
  * @brief LED configuration
  */
@@ -95,6 +114,29 @@ typedef struct {
     bool active_low;            ///< True if LED on = LOW (default: false)
 } esp_bus_led_cfg_t;
 
+/**
+ * @brief Blink request (LED_BLINK_BIN)
+ */
+typedef struct {
+    uint16_t on_ms;             ///< On time, 0 for 200 ms
+    uint16_t off_ms;            ///< Off time, 0 for 200 ms
+    int16_t count;              ///< Blinks, -1 forever, 0 stop
+} esp_bus_led_blink_t;
+
+/**
+ * @brief Pattern request (LED_PATTERN)
+ *
+ * Even steps are on, odd steps off. The table is copied when the request
+ * is handled, so it may live on the caller's stack. The request may stop
+ * after the last used step. The LED is left off when the pattern ends.
+ */
+typedef struct {
+    int16_t repeat;             ///< Passes over the steps, -1 forever, 0 stop
+    uint8_t step_cnt;           ///< Used entries of steps[]
+    uint8_t reserved;
+    uint16_t steps[ESP_BUS_LED_STEPS_MAX];  ///< Step durations in ms, non-zero
+} esp_bus_led_pattern_t;
+
 // ============================================================================
 // API
 // ============================================================================
@@ -108,9 +150,24 @@ typedef struct {
 esp_err_t esp_bus_led_reg(const char *name, const esp_bus_led_cfg_t *cfg);
 
 /**
- * @brief Unregister LED module
+ * @brief Register a group of LEDs that run in lockstep
+ *
+ * The group is a module with the same actions as an LED. It drives all
+ * members from one timer, so they stay in phase. Starting a group command
+ * stops the members' own blink or pattern. A member's own command applies
+ * until the group's next step.
+ *
+ * @param name Module name (e.g., "leds")
+ * @param members Registered LED (or group) names
+ * @param cnt Number of members
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if a member is not an LED
+ */
+esp_err_t esp_bus_led_group_reg(const char *name, const char *const *members, size_t cnt);
+
+/**
+ * @brief Unregister LED module or group
  * @param name Module name
- * @return ESP_OK on success
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE while part of a group
  */
 esp_err_t esp_bus_led_unreg(const char *name);
 
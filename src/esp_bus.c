@@ -44,44 +44,15 @@ bool esp_bus_match_pattern(const char *pattern, const char *target) {
     return (*p == '\0' && *t == '\0');
 }
 
-bool esp_bus_parse_pattern(const char *pattern, char *module, char *action, char *sep) {
-    const char *dot = strchr(pattern, '.');
-    const char *colon = strchr(pattern, ':');
-    
-    if (dot) {
-        size_t len = dot - pattern;
-        if (len >= ESP_BUS_NAME_MAX) return false;
-        strncpy(module, pattern, len);
-        module[len] = '\0';
-        strncpy(action, dot + 1, ESP_BUS_NAME_MAX - 1);
-        action[ESP_BUS_NAME_MAX - 1] = '\0';
-        *sep = '.';
-        return true;
-    }
-    
-    if (colon) {
-        size_t len = colon - pattern;
-        if (len >= ESP_BUS_NAME_MAX) return false;
-        strncpy(module, pattern, len);
-        module[len] = '\0';
-        strncpy(action, colon + 1, ESP_BUS_NAME_MAX - 1);
-        action[ESP_BUS_NAME_MAX - 1] = '\0';
-        *sep = ':';
-        return true;
-    }
-    
-    strncpy(module, pattern, ESP_BUS_NAME_MAX - 1);
-    module[ESP_BUS_NAME_MAX - 1] = '\0';
-    action[0] = '\0';
-    *sep = '\0';
-    return true;
-}
-
-module_node_t *esp_bus_find_module(const char *name) {
-    module_node_t *node;
-    SLIST_FOREACH(node, &g_bus.modules, next) {
-        if (strcmp(node->name, name) == 0) {
-            return node;
+// Caller holds g_bus.mutex or a read section
+const esp_bus_module_t *esp_bus_find_module(const char *name) {
+    const esp_bus_module_t *mod = esp_bus_static_find(name);
+    if (mod) return mod;
+    
+    module_table_t *t = __atomic_load_n(&g_bus.modules, __ATOMIC_ACQUIRE);
+    for (size_t i = 0; t && i < t->cnt; i++) {
+        if (strcmp(t->mods[i]->name, name) == 0) {
+            return &t->mods[i]->desc;
         }
     }
     return NULL;
@@ -100,57 +71,216 @@ void esp_bus_report_error(const char *pattern, esp_err_t err, const char *msg) {
 // Task
 // ============================================================================
 
-static void process_message(message_t *msg) {
+void esp_bus_process_message(message_t *msg) {
+#ifdef CONFIG_ESP_BUS_PROFILE
+    esp_bus_prof_dequeue(msg);
+#endif
     switch (msg->type) {
-        case MSG_REQ: {
-            esp_err_t err = esp_bus_process_request(msg->pattern, msg->data, msg->len,
-                                                    msg->res_buf, msg->res_size, msg->res_len);
-            if (msg->result) *msg->result = err;
-            if (msg->done) xSemaphoreGive(msg->done);
-            if (msg->data) free(msg->data);
+        case MSG_REQ:
+            if (msg->reply) {
+                esp_bus_reply_serve(msg->pat, esp_bus_msg_payload(msg), msg->len, msg->reply);
+            } else {
+                esp_bus_process_request(msg->pat, esp_bus_msg_payload(msg), msg->len, NULL, 0, NULL, NULL);
+            }
+            esp_bus_msg_free_payload(msg);
+            break;
+        case MSG_EVT:
+            esp_bus_dispatch_event(msg->pat, esp_bus_msg_payload(msg), msg->len);
+            esp_bus_msg_free_payload(msg);
+            break;
+        case MSG_BATCH:
+            esp_bus_dispatch_batch(msg->data, msg->len);
+            esp_bus_msg_free_payload(msg);
+            break;
+        case MSG_CFL:
+            esp_bus_dispatch_conflated(msg->pat);
+            break;
+        case MSG_RETAINED:
+            esp_bus_replay_retained((int)msg->len);
             break;
+        case MSG_MULTI:
+            esp_bus_multi_run(msg->data);   // Frees the job once all targets are done
+            break;
+        case MSG_SUB:
+            esp_bus_sub_run(msg);
+            break;
+        case MSG_BUF: {
+            esp_bus_buf_t *buf = msg->data;
+            g_bus.cur_buf = buf;
+            esp_bus_dispatch_event(msg->pat, buf->len ? buf->data : NULL, buf->len);
+            g_bus.cur_buf = NULL;
+            esp_bus_msg_free_payload(msg);
+            break;
+        }
+    }
+}
+
+bool esp_bus_post(uint8_t prio, message_t *msg, TickType_t ticks) {
+    BUS_PROF_STAMP(msg);
+    bool sent = xQueueSend(g_bus.lanes[prio], msg, ticks) == pdTRUE;
+    if (sent) xSemaphoreGive(g_bus.wake);
+#ifdef CONFIG_ESP_BUS_PROFILE
+    esp_bus_prof_depth(prio);
+#endif
+    
+    // High watermark, signalled once per congestion episode
+    esp_bus_flow_fn fn = g_bus.flow_fn;
+    if (fn && !__atomic_load_n(&g_bus.congested, __ATOMIC_RELAXED) &&
+        uxQueueMessagesWaiting(g_bus.lanes[prio]) >= g_bus.flow_high) {
+        bool expect = false;
+        if (__atomic_compare_exchange_n(&g_bus.congested, &expect, true, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            fn(true, g_bus.flow_ctx);
         }
-        case MSG_EVT: {
-            char module[ESP_BUS_NAME_MAX], event[ESP_BUS_NAME_MAX];
-            char sep;
-            if (esp_bus_parse_pattern(msg->pattern, module, event, &sep) && sep == ':') {
-                esp_bus_dispatch_event(module, event, msg->data, msg->len);
+    }
+    return sent;
+}
+
+// Requests have a waiter, and a conflated topic has one message at most
+static bool evictable(const message_t *msg) {
+    return msg->type == MSG_EVT || msg->type == MSG_BATCH || msg->type == MSG_BUF;
+}
+
+// Makes room by dropping the oldest event of a lane (never on the bus task)
+bool esp_bus_evict(uint8_t prio) {
+    QueueHandle_t lane = g_bus.lanes[prio];
+    message_t msg;
+    
+    if (xQueuePeek(lane, &msg, 0) != pdTRUE || !evictable(&msg)) return false;
+    if (xQueueReceive(lane, &msg, 0) != pdTRUE) return false;
+    if (!evictable(&msg)) {
+        // The bus task took the peeked one first: put this back in front,
+        // unless another producer took the slot meanwhile
+        if (xQueueSendToFront(lane, &msg, 0) != pdTRUE) esp_bus_msg_lost(&msg);
+        xSemaphoreGive(g_bus.wake);
+        return false;
+    }
+    
+    // A batch is counted against its first entry
+    pat_node_t *pat = msg.type == MSG_BATCH ? ((batch_ent_t *)msg.data)[0].pat : msg.pat;
+    esp_bus_count_drop(pat, "evicted, lane full");
+    esp_bus_msg_discard(&msg);
+    return true;
+}
+
+// Low watermark: all lanes drained far enough (bus task)
+static void flow_check(void) {
+    if (!__atomic_load_n(&g_bus.congested, __ATOMIC_RELAXED)) return;
+    for (int p = 0; p < ESP_BUS_PRIO_MAX; p++) {
+        if (uxQueueMessagesWaiting(g_bus.lanes[p]) > g_bus.flow_low) return;
+    }
+    
+    bool expect = true;
+    esp_bus_flow_fn fn = g_bus.flow_fn;
+    if (__atomic_compare_exchange_n(&g_bus.congested, &expect, false, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) && fn) {
+        fn(false, g_bus.flow_ctx);
+    }
+}
+
+// Highest non-empty lane first, except that a lane passed over
+// BUS_PRIO_BURST times while holding messages gets the next turn
+static bool next_message(message_t *msg) {
+    for (int p = ESP_BUS_PRIO_NORMAL; p < ESP_BUS_PRIO_MAX; p++) {
+        if (g_bus.lane_skips[p] >= BUS_PRIO_BURST) {
+            g_bus.lane_skips[p] = 0;
+            if (xQueueReceive(g_bus.lanes[p], msg, 0) == pdTRUE) return true;
+        }
+    }
+    
+    for (int p = 0; p < ESP_BUS_PRIO_MAX; p++) {
+        if (xQueueReceive(g_bus.lanes[p], msg, 0) == pdTRUE) {
+            g_bus.lane_skips[p] = 0;
+            for (int q = p + 1; q < ESP_BUS_PRIO_MAX; q++) {
+                if (uxQueueMessagesWaiting(g_bus.lanes[q])) g_bus.lane_skips[q]++;
             }
-            if (msg->data) free(msg->data);
-            break;
+            return true;
         }
-        case MSG_TRIGGER:
-            break;
     }
+    return false;
+}
+
+#ifdef CONFIG_ESP_BUS_HIRES_TIMER
+
+static void hires_cb(void *arg) {
+    __atomic_store_n(&g_bus.hires_deadline_us, 0, __ATOMIC_RELAXED);
+    esp_bus_trigger();
+}
+
+// The one-shot timer wakes the task on the deadline
+static TickType_t next_wait_ticks(void) {
+    int64_t deadline = esp_bus_next_deadline_us();
+    if (deadline == 0) return portMAX_DELAY;
+    
+    int64_t wait_us = deadline - esp_bus_now_us();
+    if (wait_us <= 0) return 0;
+    
+    if (deadline != __atomic_load_n(&g_bus.hires_deadline_us, __ATOMIC_RELAXED)) {
+        esp_timer_stop(g_bus.hires_timer);
+        g_bus.hires_deadline_us = deadline;
+        if (esp_timer_start_once(g_bus.hires_timer, (uint64_t)wait_us) != ESP_OK) {
+            g_bus.hires_deadline_us = 0;
+            return pdMS_TO_TICKS(wait_us / 1000) + 1;
+        }
+    }
+    return portMAX_DELAY;
+}
+
+#else
+
+// Rounded up, so the task does not wake just short of the deadline only to
+// sleep again
+static TickType_t next_wait_ticks(void) {
+    int64_t deadline = esp_bus_next_deadline_us();
+    if (deadline == 0) return portMAX_DELAY;
+    
+    int64_t wait_us = deadline - esp_bus_now_us();
+    if (wait_us <= 0) return 1;     // Due again right after running: next tick
+    
+    uint64_t ticks = ((uint64_t)wait_us * configTICK_RATE_HZ + 999999) / 1000000;
+    return ticks < portMAX_DELAY ? (TickType_t)ticks : portMAX_DELAY - 1;
 }
 
+#endif
+
+// With nothing queued and no service armed the task blocks without a
+// timeout, so it does not keep the scheduler out of tickless idle
 static void bus_task(void *arg) {
     message_t msg;
-    TickType_t last_service_tick = 0;
+    bool backlog = false;
+    bool retired = false;
     
     ESP_LOGI(TAG, "Task started");
     
     while (1) {
-        uint32_t wait_ms = esp_bus_calc_next_wait();
-        TickType_t wait_ticks = pdMS_TO_TICKS(wait_ms);
-        if (wait_ticks == 0) wait_ticks = 1; // Minimum 1 tick
-        
-        // Wait for message or timeout
-        if (xQueueReceive(g_bus.queue, &msg, wait_ticks) == pdTRUE) {
-            process_message(&msg);
-            
-            // Drain remaining messages (non-blocking)
-            while (xQueueReceive(g_bus.queue, &msg, 0) == pdTRUE) {
-                process_message(&msg);
-            }
+        // Wait for a message, a wake-up or the next service deadline
+        if (!backlog) {
+            // Retired nodes held back by a reader: poll for the next grace period
+            TickType_t wait = next_wait_ticks();
+            if (retired && wait > 1) wait = 1;
+            xSemaphoreTake(g_bus.wake, wait);
+            BUS_PROF_WAKE();
         }
         
-        // Run services at most once per tick to prevent tight loop
-        TickType_t now = xTaskGetTickCount();
-        if (now != last_service_tick) {
-            last_service_tick = now;
-            esp_bus_run_services();
+        // At most one queue's worth per pass, so services and the ISR ring
+        // are not held off by a sustained stream
+        int n = 0;
+        while (n < BUS_QUEUE_SIZE && next_message(&msg)) {
+            esp_bus_process_message(&msg);
+            n++;
         }
+        backlog = (n == BUS_QUEUE_SIZE);
+        flow_check();
+        
+        // Events published from interrupts
+        esp_bus_isr_drain();
+        
+        // Services only once one is due, not on every wake-up
+        int64_t deadline = esp_bus_next_deadline_us();
+        if (deadline != 0 && deadline <= esp_bus_now_us()) esp_bus_run_services();
+        
+        // Quiescent point: free what writers retired
+        retired = esp_bus_rcu_reclaim();
     }
 }
 
@@ -158,6 +288,38 @@ static void bus_task(void *arg) {
 // Init / Deinit
 // ============================================================================
 
+static void lanes_delete(void) {
+    message_t msg;
+    for (int p = 0; p < ESP_BUS_PRIO_MAX; p++) {
+        if (!g_bus.lanes[p]) continue;
+        
+        // Drop queued messages still holding payloads
+        while (xQueueReceive(g_bus.lanes[p], &msg, 0) == pdTRUE) {
+            esp_bus_msg_discard(&msg);
+        }
+        vQueueDelete(g_bus.lanes[p]);
+        g_bus.lanes[p] = NULL;
+    }
+    if (g_bus.wake) { vSemaphoreDelete(g_bus.wake); g_bus.wake = NULL; }
+}
+
+static esp_err_t lanes_create(void) {
+    for (int p = 0; p < ESP_BUS_PRIO_MAX; p++) {
+        g_bus.lanes[p] = xQueueCreate(BUS_QUEUE_SIZE, sizeof(message_t));
+        if (!g_bus.lanes[p]) {
+            lanes_delete();
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    g_bus.wake = xSemaphoreCreateBinary();
+    if (!g_bus.wake) {
+        lanes_delete();
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
 bool esp_bus_is_init(void) {
     return g_bus.initialized;
 }
@@ -172,45 +334,112 @@ esp_err_t esp_bus_init(void) {
     memset(&g_bus, 0, sizeof(g_bus));
     g_bus.log_level = ESP_LOG_INFO;
     
-    SLIST_INIT(&g_bus.modules);
+    esp_err_t err = esp_bus_static_check();
+    if (err != ESP_OK) return err;
+    
     SLIST_INIT(&g_bus.subs);
     SLIST_INIT(&g_bus.routes);
-    SLIST_INIT(&g_bus.services);
-    
-    #ifdef CONFIG_ESP_BUS_QUEUE_SIZE
-    #define BUS_QUEUE_SIZE CONFIG_ESP_BUS_QUEUE_SIZE
-    #else
-    #define BUS_QUEUE_SIZE 16
-    #endif
+    esp_bus_idx_init();
+#if BUS_TRACE_SIZE > 0
+    esp_bus_trace_boot();
+#endif
+#ifdef CONFIG_ESP_BUS_PROFILE
+    g_bus.prof_since_us = esp_bus_now_us();
+#endif
+    
+    if (esp_bus_pool_init() != ESP_OK) return ESP_ERR_NO_MEM;
+    if (esp_bus_isr_init() != ESP_OK) {
+        esp_bus_pool_deinit();
+        return ESP_ERR_NO_MEM;
+    }
+    if (esp_bus_reply_init() != ESP_OK) {
+        esp_bus_isr_deinit();
+        esp_bus_pool_deinit();
+        return ESP_ERR_NO_MEM;
+    }
     
-    g_bus.queue = xQueueCreate(BUS_QUEUE_SIZE, sizeof(message_t));
-    if (!g_bus.queue) return ESP_ERR_NO_MEM;
+    if (lanes_create() != ESP_OK) {
+        esp_bus_reply_deinit();
+        esp_bus_isr_deinit();
+        esp_bus_pool_deinit();
+        return ESP_ERR_NO_MEM;
+    }
     
     g_bus.mutex = xSemaphoreCreateMutex();
     if (!g_bus.mutex) {
-        vQueueDelete(g_bus.queue);
+        lanes_delete();
+        esp_bus_reply_deinit();
+        esp_bus_isr_deinit();
+        esp_bus_pool_deinit();
         return ESP_ERR_NO_MEM;
     }
     
-    #ifdef CONFIG_ESP_BUS_TASK_STACK_SIZE
-    #define BUS_STACK_SIZE CONFIG_ESP_BUS_TASK_STACK_SIZE
-    #else
-    #define BUS_STACK_SIZE 4096
-    #endif
+    if (esp_bus_worker_init() != ESP_OK) {
+        vSemaphoreDelete(g_bus.mutex);
+        lanes_delete();
+        esp_bus_reply_deinit();
+        esp_bus_isr_deinit();
+        esp_bus_pool_deinit();
+        return ESP_ERR_NO_MEM;
+    }
     
-    #ifdef CONFIG_ESP_BUS_TASK_PRIORITY
-    #define BUS_PRIORITY CONFIG_ESP_BUS_TASK_PRIORITY
-    #else
-    #define BUS_PRIORITY 5
-    #endif
+#ifdef CONFIG_ESP_BUS_HIRES_TIMER
+    const esp_timer_create_args_t timer_args = {
+        .callback = hires_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "esp_bus",
+    };
+    if (esp_timer_create(&timer_args, &g_bus.hires_timer) != ESP_OK) {
+        esp_bus_worker_deinit();
+        vSemaphoreDelete(g_bus.mutex);
+        lanes_delete();
+        esp_bus_reply_deinit();
+        esp_bus_isr_deinit();
+        esp_bus_pool_deinit();
+        return ESP_ERR_NO_MEM;
+    }
+#endif
+    
+#ifdef CONFIG_PM_ENABLE
+    // Held only while a service marked with esp_bus_svc_pm() runs
+    if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "esp_bus", &g_bus.pm_lock) != ESP_OK) {
+#ifdef CONFIG_ESP_BUS_HIRES_TIMER
+        esp_timer_delete(g_bus.hires_timer);
+#endif
+        esp_bus_worker_deinit();
+        vSemaphoreDelete(g_bus.mutex);
+        lanes_delete();
+        esp_bus_reply_deinit();
+        esp_bus_isr_deinit();
+        esp_bus_pool_deinit();
+        return ESP_ERR_NO_MEM;
+    }
+#endif
     
     if (xTaskCreate(bus_task, "esp_bus", BUS_STACK_SIZE, NULL, BUS_PRIORITY, &g_bus.task) != pdPASS) {
+#ifdef CONFIG_PM_ENABLE
+        esp_pm_lock_delete(g_bus.pm_lock);
+#endif
+#ifdef CONFIG_ESP_BUS_HIRES_TIMER
+        esp_timer_delete(g_bus.hires_timer);
+#endif
+        esp_bus_worker_deinit();
         vSemaphoreDelete(g_bus.mutex);
-        vQueueDelete(g_bus.queue);
+        lanes_delete();
+        esp_bus_reply_deinit();
+        esp_bus_isr_deinit();
+        esp_bus_pool_deinit();
         return ESP_ERR_NO_MEM;
     }
     
     g_bus.initialized = true;
+    
+    err = esp_bus_static_install();
+    if (err != ESP_OK) {
+        esp_bus_deinit();
+        return err;
+    }
+    
     ESP_LOGI(TAG, "Initialized");
     return ESP_OK;
 }
@@ -222,12 +451,26 @@ esp_err_t esp_bus_deinit(void) {
         vTaskDelete(g_bus.task);
         g_bus.task = NULL;
     }
+    esp_bus_worker_deinit();
+    
+#ifdef CONFIG_ESP_BUS_HIRES_TIMER
+    esp_timer_stop(g_bus.hires_timer);
+    esp_timer_delete(g_bus.hires_timer);
+    g_bus.hires_timer = NULL;
+#endif
+#ifdef CONFIG_PM_ENABLE
+    // No service runs any more, so the lock is not held
+    esp_pm_lock_delete(g_bus.pm_lock);
+    g_bus.pm_lock = NULL;
+#endif
     
     // Free modules
-    module_node_t *mod, *mod_tmp;
-    SLIST_FOREACH_SAFE(mod, &g_bus.modules, next, mod_tmp) {
-        SLIST_REMOVE(&g_bus.modules, mod, module_node, next);
-        free(mod);
+    if (g_bus.modules) {
+        for (size_t i = 0; i < g_bus.modules->cnt; i++) {
+            free(g_bus.modules->mods[i]);
+        }
+        free(g_bus.modules);
+        g_bus.modules = NULL;
     }
     
     // Free subscriptions
@@ -246,14 +489,18 @@ esp_err_t esp_bus_deinit(void) {
     }
     
     // Free services
-    svc_node_t *s, *s_tmp;
-    SLIST_FOREACH_SAFE(s, &g_bus.services, next, s_tmp) {
-        SLIST_REMOVE(&g_bus.services, s, svc_node, next);
-        free(s);
-    }
+    esp_bus_svc_free_all();
+    
+    esp_bus_idx_free_all();
+    esp_bus_pat_free_all();
+    esp_bus_rcu_free_all();
+    
+    lanes_delete();
+    esp_bus_reply_deinit();
+    esp_bus_isr_deinit();
+    esp_bus_pool_deinit();
     
     if (g_bus.mutex) { vSemaphoreDelete(g_bus.mutex); g_bus.mutex = NULL; }
-    if (g_bus.queue) { vQueueDelete(g_bus.queue); g_bus.queue = NULL; }
     
     g_bus.initialized = false;
     ESP_LOGI(TAG, "Deinitialized");
@@ -264,8 +511,52 @@ esp_err_t esp_bus_deinit(void) {
 // Module Registration
 // ============================================================================
 
+// Last reference: the table's (dropped by reclamation) or a running handler's
+static void module_put(void *p) {
+    module_node_t *node = p;
+    if (__atomic_sub_fetch(&node->refs, 1, __ATOMIC_ACQ_REL) == 0) free(node);
+}
+
+// Keeps a module found in a read section allocated after the section ends,
+// so a blocking handler does not hold back reclamation. Static modules are
+// never freed.
+void esp_bus_module_hold(const esp_bus_module_t *mod) {
+    if (esp_bus_static_owns(mod)) return;
+    module_node_t *node = (module_node_t *)((char *)mod - offsetof(module_node_t, desc));
+    __atomic_add_fetch(&node->refs, 1, __ATOMIC_RELAXED);
+}
+
+void esp_bus_module_release(const esp_bus_module_t *mod) {
+    if (esp_bus_static_owns(mod)) return;
+    module_put((char *)mod - offsetof(module_node_t, desc));
+}
+
+// Caller holds g_bus.mutex. Publishes a copy of the table without del and
+// with add appended; readers keep the old one until it is reclaimed.
+static esp_err_t modules_publish(module_node_t *add, const module_node_t *del) {
+    module_table_t *old = g_bus.modules;
+    size_t cnt = old ? old->cnt : 0;
+    module_table_t *t = NULL;
+    
+    if (add || cnt > 1) {
+        t = malloc(sizeof(module_table_t) + (cnt + 1) * sizeof(module_node_t *));
+        if (!t) return ESP_ERR_NO_MEM;
+        
+        t->cnt = 0;
+        for (size_t i = 0; i < cnt; i++) {
+            if (old->mods[i] != del) t->mods[t->cnt++] = old->mods[i];
+        }
+        if (add) t->mods[t->cnt++] = add;
+    }
+    
+    __atomic_store_n(&g_bus.modules, t, __ATOMIC_RELEASE);
+    if (old) esp_bus_retire(&old->rcu, free);
+    return ESP_OK;
+}
+
 esp_err_t esp_bus_reg(const esp_bus_module_t *module) {
     if (!g_bus.initialized || !module || !module->name) return ESP_ERR_INVALID_ARG;
+    if (module->worker > BUS_WORKERS) return ESP_ERR_INVALID_ARG;
     
     xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
     
@@ -282,15 +573,16 @@ esp_err_t esp_bus_reg(const esp_bus_module_t *module) {
     }
     
     strncpy(node->name, module->name, ESP_BUS_NAME_MAX - 1);
-    node->on_req = module->on_req;
-    node->on_evt = module->on_evt;
-    node->ctx = module->ctx;
-    node->actions = module->actions;
-    node->action_cnt = module->action_cnt;
-    node->events = module->events;
-    node->event_cnt = module->event_cnt;
-    
-    SLIST_INSERT_HEAD(&g_bus.modules, node, next);
+    node->refs = 1;
+    node->desc = *module;
+    node->desc.name = node->name;
+    
+    if (modules_publish(node, NULL) != ESP_OK) {
+        xSemaphoreGive(g_bus.mutex);
+        free(node);
+        return ESP_ERR_NO_MEM;
+    }
+    esp_bus_pat_bind(&node->desc);
     xSemaphoreGive(g_bus.mutex);
     
     ESP_LOGI(TAG, "Registered '%s'", module->name);
@@ -302,14 +594,26 @@ esp_err_t esp_bus_unreg(const char *name) {
     
     xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
     
-    module_node_t *mod = esp_bus_find_module(name);
+    const esp_bus_module_t *mod = esp_bus_find_module(name);
     if (!mod) {
         xSemaphoreGive(g_bus.mutex);
         return ESP_ERR_NOT_FOUND;
     }
+    if (esp_bus_static_owns(mod)) {
+        // Linked into the firmware for good
+        xSemaphoreGive(g_bus.mutex);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
     
-    SLIST_REMOVE(&g_bus.modules, mod, module_node, next);
-    free(mod);
+    module_node_t *node = (module_node_t *)((char *)mod - offsetof(module_node_t, desc));
+    if (modules_publish(NULL, node) != ESP_OK) {
+        xSemaphoreGive(g_bus.mutex);
+        return ESP_ERR_NO_MEM;
+    }
+    esp_bus_pat_unbind(mod);
+    
+    // Requests in flight may still be running its handler
+    esp_bus_retire(&node->rcu, module_put);
     xSemaphoreGive(g_bus.mutex);
     
     ESP_LOGI(TAG, "Unregistered '%s'", name);
@@ -322,17 +626,17 @@ esp_err_t esp_bus_unreg(const char *name) {
 
 bool esp_bus_exists(const char *module) {
     if (!g_bus.initialized || !module) return false;
-    xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
+    uint32_t rcu = esp_bus_rcu_lock();
     bool exists = (esp_bus_find_module(module) != NULL);
-    xSemaphoreGive(g_bus.mutex);
+    esp_bus_rcu_unlock(rcu);
     return exists;
 }
 
 bool esp_bus_has_action(const char *module, const char *action) {
     if (!g_bus.initialized || !module || !action) return false;
     
-    xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
-    module_node_t *mod = esp_bus_find_module(module);
+    uint32_t rcu = esp_bus_rcu_lock();
+    const esp_bus_module_t *mod = esp_bus_find_module(module);
     bool found = false;
     
     if (mod && mod->actions) {
@@ -343,15 +647,15 @@ bool esp_bus_has_action(const char *module, const char *action) {
             }
         }
     }
-    xSemaphoreGive(g_bus.mutex);
+    esp_bus_rcu_unlock(rcu);
     return found;
 }
 
 bool esp_bus_has_event(const char *module, const char *event) {
     if (!g_bus.initialized || !module || !event) return false;
     
-    xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
-    module_node_t *mod = esp_bus_find_module(module);
+    uint32_t rcu = esp_bus_rcu_lock();
+    const esp_bus_module_t *mod = esp_bus_find_module(module);
     bool found = false;
     
     if (mod && mod->events) {
@@ -362,7 +666,7 @@ bool esp_bus_has_event(const char *module, const char *event) {
             }
         }
     }
-    xSemaphoreGive(g_bus.mutex);
+    esp_bus_rcu_unlock(rcu);
     return found;
 }
 
@@ -0,0 +1,911 @@
+/**
+ * @file esp_bus_bridge.c
+ * @brief ESP Bus - Bridge Module Implementation
+ *
+ * Outgoing records are packed into one frame buffer under the bridge lock
+ * and written through the transport on flush. Pattern ids are assigned per
+ * session on first use, with the definition placed just ahead of the first
+ * record that uses it. Incoming definitions are resolved to local handles
+ * once, so events and requests from the peer go out with the _h calls.
+ */
+
+#include "esp_bus_bridge.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+static const char *TAG = "esp_bus_bridge";
+
+// Frame: sync word, payload length, payload, CRC-16 of length and payload
+#define SYNC0           0xB5
+#define SYNC1           0x62
+#define FRAME_HEAD      4
+#define FRAME_OVERHEAD  6
+#define PROTO_VERSION   1
+
+// Records; integers are little endian
+enum {
+    REC_HELLO = 1,      // version u8
+    REC_DEF,            // id u16, kind u8, n u8, pattern[n]
+    REC_EVT,            // id u16, len u16, data
+    REC_REQ,            // id u16, seq u16, res_size u16, len u16, data
+    REC_RES,            // seq u16, err i32, len u16, data
+};
+
+#define HELLO_LEN   2
+#define DEF_HEAD    5
+#define EVT_HEAD    5
+#define REQ_HEAD    9
+#define RES_HEAD    9
+
+enum { KIND_EVT, KIND_REQ };
+
+#define PENDING_MAX     4       // Remote requests in flight
+#define SERVE_MAX       8       // Peer requests being served here
+#define DEFAULT_TIMEOUT 1000
+
+// ============================================================================
+// Schema
+// ============================================================================
+
+static esp_err_t bridge_stats(const char *, const void *, size_t, void *, size_t, size_t *, void *);
+static esp_err_t bridge_reset_stats(const char *, const void *, size_t, void *, size_t, size_t *, void *);
+static esp_err_t bridge_hello(const char *, const void *, size_t, void *, size_t, size_t *, void *);
+
+const esp_bus_action_t esp_bus_bridge_actions[] = {
+    {BRIDGE_STATS,       "none", "bridge_stats_t", "Link counters",           bridge_stats},
+    {BRIDGE_RESET_STATS, "none", "none",           "Clear the counters",      bridge_reset_stats},
+    {BRIDGE_HELLO,       "none", "none",           "Announce again to the peer", bridge_hello},
+};
+const size_t esp_bus_bridge_action_cnt = sizeof(esp_bus_bridge_actions) / sizeof(esp_bus_bridge_actions[0]);
+
+const esp_bus_event_t esp_bus_bridge_events[] = {
+    {BRIDGE_EVT_PEER_UP, "none", "The peer announced itself"},
+};
+const size_t esp_bus_bridge_event_cnt = sizeof(esp_bus_bridge_events) / sizeof(esp_bus_bridge_events[0]);
+
+// ============================================================================
+// Context
+// ============================================================================
+
+typedef struct bridge bridge_t;
+
+// Remote module exposed locally as prefix + name
+typedef struct {
+    bridge_t *bridge;
+    char name[ESP_BUS_NAME_MAX];    // Name on the peer
+} proxy_t;
+
+// Remote request waiting for its response
+typedef struct {
+    bool busy;
+    bool done;
+    uint16_t seq;
+    esp_err_t err;
+    void *res;
+    size_t res_size;
+    size_t res_len;
+    SemaphoreHandle_t sem;
+} pending_t;
+
+// Peer request being served by a local module
+typedef struct {
+    bridge_t *bridge;
+    bool busy;
+    uint16_t seq;
+} served_t;
+
+typedef struct {
+    esp_bus_handle_t h;
+    uint8_t kind;
+    bool allowed;               // Request target listed in serve
+} rx_id_t;
+
+struct bridge {
+    char name[ESP_BUS_NAME_MAX];
+    char prefix[ESP_BUS_NAME_MAX];
+    size_t prefix_len;
+    esp_bus_bridge_send_fn send;
+    void *send_ctx;
+    uint16_t mtu;
+    uint16_t batch_ms;
+    uint32_t timeout_ms;
+    
+    SemaphoreHandle_t lock;     // Tx side, pending and served slots, stats
+    
+    // Tx: ids defined to the peer this session. Keys are interned strings,
+    // the event pattern or the proxy's action, compared by address.
+    const char *tx_ids[ESP_BUS_BRIDGE_IDS_MAX];
+    uint16_t tx_id_cnt;
+    uint8_t *tx;                // Frame being filled
+    size_t tx_len;              // Payload bytes in tx
+    uint32_t tx_msgs;           // Messages in tx
+    int flush_timer;
+    uint16_t seq;
+    pending_t pending[PENDING_MAX];
+    served_t served[SERVE_MAX];
+    
+    // Rx: only touched by the task calling esp_bus_bridge_input()
+    rx_id_t rx_ids[ESP_BUS_BRIDGE_IDS_MAX];
+    uint8_t *rx;
+    size_t rx_len;
+    bool resync;                // Asked the peer to define its ids again
+    struct {
+        uint32_t rx_frames, rx_bytes, rx_msgs, rx_errors, drops;
+    } rx_cnt;                   // Added to stats under the lock per input call
+    
+    esp_bus_bridge_stats_t stats;
+    
+    char (*serve)[ESP_BUS_NAME_MAX];
+    size_t serve_cnt;
+    bool serve_all;
+    int *subs;
+    size_t sub_cnt;
+    bool registered;            // Bridge module itself
+    size_t proxy_reg;           // Proxies registered so far
+    
+    uint32_t refs;              // Served requests and remote calls in flight
+    bool closing;
+    bridge_t *next;
+    
+    size_t proxy_cnt;
+    proxy_t proxies[];
+};
+
+static bridge_t *s_bridges = NULL;
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+static inline uint8_t *put16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+    return p + 2;
+}
+
+static inline uint16_t get16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint8_t *put32(uint8_t *p, uint32_t v) {
+    return put16(put16(p, v & 0xffff), v >> 16);
+}
+
+static inline uint32_t get32(const uint8_t *p) {
+    return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+// Same buckets as the profiler; callers hold the lock
+static void hist_add(esp_bus_hist_t *h, int64_t start_us) {
+    int64_t d = esp_timer_get_time() - start_us;
+    uint32_t us = d <= 0 ? 0 : (d > UINT32_MAX ? UINT32_MAX : (uint32_t)d);
+    
+    int b = us < 16 ? 0 : (31 - __builtin_clz(us)) / 2 - 1;
+    if (b >= ESP_BUS_HIST_BUCKETS) b = ESP_BUS_HIST_BUCKETS - 1;
+    
+    h->count++;
+    h->sum_us += us;
+    h->buckets[b]++;
+    if (us > h->max_us) h->max_us = us;
+}
+
+static bridge_t *bridge_find(const char *name) {
+    bridge_t *b = s_bridges;
+    while (b && strcmp(b->name, name) != 0) b = b->next;
+    return b;
+}
+
+// ============================================================================
+// Transmit (lock held)
+// ============================================================================
+
+static esp_err_t tx_flush(bridge_t *b) {
+    if (b->tx_len == 0) return ESP_OK;
+    
+    uint8_t *f = b->tx;
+    f[0] = SYNC0;
+    f[1] = SYNC1;
+    put16(f + 2, b->tx_len);
+    put16(f + FRAME_HEAD + b->tx_len, esp_rom_crc16_le(0, f + 2, b->tx_len + 2));
+    
+    size_t len = b->tx_len + FRAME_OVERHEAD;
+    uint32_t msgs = b->tx_msgs;
+    b->tx_len = 0;
+    b->tx_msgs = 0;
+    
+    esp_err_t err = b->send(f, len, b->send_ctx);
+    if (err != ESP_OK) {
+        b->stats.drops += msgs;
+        return err;
+    }
+    b->stats.tx_frames++;
+    b->stats.tx_bytes += len;
+    b->stats.tx_msgs += msgs;
+    return ESP_OK;
+}
+
+// Room for n payload bytes; sends the current frame first if it is full
+static uint8_t *tx_reserve(bridge_t *b, size_t n) {
+    size_t cap = b->mtu - FRAME_OVERHEAD;
+    if (n > cap) return NULL;
+    if (b->tx_len + n > cap) tx_flush(b);
+    
+    uint8_t *p = b->tx + FRAME_HEAD + b->tx_len;
+    b->tx_len += n;
+    return p;
+}
+
+// Id of key this session, defining it to the peer on first use
+static int tx_id(bridge_t *b, const char *key, uint8_t kind, const char *pattern) {
+    for (uint16_t i = 0; i < b->tx_id_cnt; i++) {
+        if (b->tx_ids[i] == key) return i;
+    }
+    if (b->tx_id_cnt >= ESP_BUS_BRIDGE_IDS_MAX) return -1;
+    
+    size_t n = strlen(pattern);
+    uint8_t *p = tx_reserve(b, DEF_HEAD + n);
+    if (!p) return -1;
+    
+    int id = b->tx_id_cnt++;
+    b->tx_ids[id] = key;
+    *p++ = REC_DEF;
+    p = put16(p, id);
+    *p++ = kind;
+    *p++ = n;
+    memcpy(p, pattern, n);
+    return id;
+}
+
+static void send_hello(bridge_t *b) {
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    uint8_t *p = tx_reserve(b, HELLO_LEN);
+    p[0] = REC_HELLO;
+    p[1] = PROTO_VERSION;
+    tx_flush(b);
+    xSemaphoreGive(b->lock);
+}
+
+static void send_res(bridge_t *b, uint16_t seq, esp_err_t err, const void *res, size_t len) {
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    uint8_t *p = tx_reserve(b, RES_HEAD + len);
+    if (!p) {
+        // Too large for a frame: the caller gets the error instead
+        err = ESP_ERR_INVALID_SIZE;
+        len = 0;
+        p = tx_reserve(b, RES_HEAD);
+    }
+    *p++ = REC_RES;
+    p = put16(p, seq);
+    p = put32(p, (uint32_t)err);
+    p = put16(p, len);
+    if (len) memcpy(p, res, len);
+    b->tx_msgs++;
+    tx_flush(b);
+    xSemaphoreGive(b->lock);
+}
+
+static void bridge_flush(void *ctx) {
+    bridge_t *b = (bridge_t *)ctx;
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    b->flush_timer = -1;
+    tx_flush(b);
+    xSemaphoreGive(b->lock);
+}
+
+// ============================================================================
+// Forwarding
+// ============================================================================
+
+// Events that came in over b carry it past the end of their payload
+static bool from_bridge(const bridge_t *b) {
+    const esp_bus_buf_t *buf = esp_bus_cur_buf();
+    if (!buf || buf->size - buf->len < sizeof(b)) return false;
+    
+    const bridge_t *tag;
+    memcpy(&tag, buf->data + buf->len, sizeof(tag));
+    return tag == b;
+}
+
+static void bridge_evt(const char *event, const void *data, size_t len, void *ctx) {
+    bridge_t *b = (bridge_t *)ctx;
+    const char *pattern = esp_bus_cur_pattern();
+    
+    // Events that came in over this bridge do not go back; a local module
+    // whose name starts with the prefix is still forwarded
+    if (!pattern || from_bridge(b)) return;
+    
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    int id = tx_id(b, pattern, KIND_EVT, pattern);
+    uint8_t *p = id < 0 ? NULL : tx_reserve(b, EVT_HEAD + len);
+    if (!p) {
+        b->stats.drops++;
+        xSemaphoreGive(b->lock);
+        return;
+    }
+    *p++ = REC_EVT;
+    p = put16(p, id);
+    p = put16(p, len);
+    if (len) memcpy(p, data, len);
+    b->tx_msgs++;
+    
+    // The first event of a batch starts the clock
+    if (b->batch_ms == 0) {
+        tx_flush(b);
+    } else if (b->flush_timer < 0) {
+        b->flush_timer = esp_bus_after(bridge_flush, b->batch_ms, b);
+        if (b->flush_timer < 0) tx_flush(b);
+    }
+    xSemaphoreGive(b->lock);
+}
+
+// Remote module: blocks the serving task until the peer responds
+static esp_err_t proxy_req(const char *action, const void *req, size_t req_len,
+                           void *res, size_t res_size, size_t *res_len, void *ctx) {
+    proxy_t *px = (proxy_t *)ctx;
+    bridge_t *b = px->bridge;
+    char pattern[ESP_BUS_PATTERN_MAX];
+    
+    if (snprintf(pattern, sizeof(pattern), "%s.%s", px->name, action) >= (int)sizeof(pattern)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // The response has to fit one frame as well
+    size_t res_cap = b->mtu - FRAME_OVERHEAD - RES_HEAD;
+    if (!res) res_size = 0;
+    if (res_size > res_cap) res_size = res_cap;
+    
+    __atomic_add_fetch(&b->refs, 1, __ATOMIC_ACQ_REL);
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    
+    pending_t *pd = NULL;
+    for (size_t i = 0; i < PENDING_MAX && !b->closing; i++) {
+        if (!b->pending[i].busy) {
+            pd = &b->pending[i];
+            break;
+        }
+    }
+    esp_err_t err = b->closing ? ESP_ERR_INVALID_STATE : ESP_ERR_NO_MEM;
+    uint8_t *p = NULL;
+    if (pd) {
+        // The action string is interned with the pattern, so it keys the id
+        int id = tx_id(b, action, KIND_REQ, pattern);
+        p = id < 0 ? NULL : tx_reserve(b, REQ_HEAD + req_len);
+        if (!p) {
+            b->stats.drops++;
+            err = id < 0 ? ESP_ERR_NO_MEM : ESP_ERR_INVALID_SIZE;
+        } else {
+            *pd = (pending_t) {
+                .busy = true,
+                .seq = ++b->seq,
+                .res = res,
+                .res_size = res_size,
+                .sem = pd->sem,
+            };
+            *p++ = REC_REQ;
+            p = put16(p, id);
+            p = put16(p, pd->seq);
+            p = put16(p, res_size);
+            p = put16(p, req_len);
+            if (req_len) memcpy(p, req, req_len);
+            b->tx_msgs++;
+            err = tx_flush(b);
+            if (err != ESP_OK) pd->busy = false;
+        }
+    }
+    xSemaphoreGive(b->lock);
+    
+    if (!p || err != ESP_OK) {
+        __atomic_sub_fetch(&b->refs, 1, __ATOMIC_ACQ_REL);
+        return err;
+    }
+    
+    int64_t start = esp_timer_get_time();
+    bool woken = xSemaphoreTake(pd->sem, pdMS_TO_TICKS(b->timeout_ms)) == pdTRUE;
+    
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    if (pd->done) {
+        // Given between the timeout and taking the lock
+        if (!woken) xSemaphoreTake(pd->sem, 0);
+        err = pd->err;
+        if (res_len) *res_len = pd->res_len;
+        hist_add(&b->stats.rtt, start);
+    } else if (b->closing) {
+        err = ESP_ERR_INVALID_STATE;
+    } else {
+        err = ESP_ERR_TIMEOUT;
+        b->stats.timeouts++;
+    }
+    pd->busy = false;
+    xSemaphoreGive(b->lock);
+    
+    __atomic_sub_fetch(&b->refs, 1, __ATOMIC_ACQ_REL);
+    return err;
+}
+
+static void serve_done(esp_err_t err, const void *res, size_t res_len, void *ctx) {
+    served_t *s = (served_t *)ctx;
+    bridge_t *b = s->bridge;
+    
+    send_res(b, s->seq, err, res, res_len);
+    
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    s->busy = false;
+    xSemaphoreGive(b->lock);
+    __atomic_sub_fetch(&b->refs, 1, __ATOMIC_ACQ_REL);
+}
+
+// ============================================================================
+// Receive
+// ============================================================================
+
+static bool serves(const bridge_t *b, const char *pattern) {
+    if (b->serve_all) return true;
+    
+    size_t n = strcspn(pattern, ".");
+    for (size_t i = 0; i < b->serve_cnt; i++) {
+        if (strncmp(b->serve[i], pattern, n) == 0 && b->serve[i][n] == '\0') return true;
+    }
+    return false;
+}
+
+// Peer uses an id we never saw defined: ask it to start over, once
+static void rx_unknown(bridge_t *b) {
+    b->rx_cnt.rx_errors++;
+    if (!b->resync) {
+        b->resync = true;
+        send_hello(b);
+    }
+}
+
+static void rx_hello(bridge_t *b) {
+    // The peer lost our ids: define them again on next use
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    b->tx_id_cnt = 0;
+    xSemaphoreGive(b->lock);
+    
+    ESP_LOGI(TAG, "'%s' peer up", b->name);
+    esp_bus_emit(b->name, BRIDGE_EVT_PEER_UP, NULL, 0);
+}
+
+static void rx_def(bridge_t *b, uint16_t id, uint8_t kind, const uint8_t *s, size_t n) {
+    char pattern[ESP_BUS_PATTERN_MAX];
+    
+    if (id >= ESP_BUS_BRIDGE_IDS_MAX || kind > KIND_REQ) {
+        b->rx_cnt.rx_errors++;
+        return;
+    }
+    
+    // Remote events land under the prefix, requests address local modules
+    int len = snprintf(pattern, sizeof(pattern), "%s%.*s",
+                       kind == KIND_EVT ? b->prefix : "", (int)n, (const char *)s);
+    
+    rx_id_t *e = &b->rx_ids[id];
+    e->h = len < (int)sizeof(pattern) ? esp_bus_resolve(pattern) : NULL;
+    e->kind = kind;
+    e->allowed = kind == KIND_REQ && serves(b, pattern);
+    if (!e->h) {
+        ESP_LOGW(TAG, "'%s' cannot map '%.*s'", b->name, (int)n, (const char *)s);
+        b->rx_cnt.rx_errors++;
+    }
+    b->resync = false;
+}
+
+static void rx_evt(bridge_t *b, uint16_t id, const uint8_t *data, size_t len) {
+    if (id >= ESP_BUS_BRIDGE_IDS_MAX || !b->rx_ids[id].h || b->rx_ids[id].kind != KIND_EVT) {
+        rx_unknown(b);
+        return;
+    }
+    b->rx_cnt.rx_msgs++;
+    
+    // Shared buffer tagged with the bridge, so bridge_evt() knows it by
+    // identity rather than by name
+    esp_bus_buf_t *buf = esp_bus_buf_alloc(len + sizeof(b));
+    if (!buf) {
+        b->rx_cnt.drops++;
+        return;
+    }
+    if (len) memcpy(buf->data, data, len);
+    memcpy(buf->data + len, &b, sizeof(b));
+    buf->len = len;
+    if (esp_bus_emit_buf_h(b->rx_ids[id].h, buf) != ESP_OK) {
+        esp_bus_buf_release(buf);
+        b->rx_cnt.drops++;
+    }
+}
+
+static void rx_req(bridge_t *b, uint16_t id, uint16_t seq, uint16_t res_size,
+                   const uint8_t *data, size_t len) {
+    b->rx_cnt.rx_msgs++;
+    if (id >= ESP_BUS_BRIDGE_IDS_MAX || !b->rx_ids[id].h || b->rx_ids[id].kind != KIND_REQ) {
+        rx_unknown(b);
+        send_res(b, seq, ESP_ERR_NOT_FOUND, NULL, 0);
+        return;
+    }
+    if (!b->rx_ids[id].allowed) {
+        send_res(b, seq, ESP_ERR_NOT_SUPPORTED, NULL, 0);
+        return;
+    }
+    
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    served_t *s = NULL;
+    for (size_t i = 0; i < SERVE_MAX; i++) {
+        if (!b->served[i].busy) {
+            s = &b->served[i];
+            s->busy = true;
+            s->seq = seq;
+            break;
+        }
+    }
+    xSemaphoreGive(b->lock);
+    if (!s) {
+        send_res(b, seq, ESP_ERR_NO_MEM, NULL, 0);
+        return;
+    }
+    
+    // The peer's size is not trusted: nothing past one frame can go back
+    size_t res_cap = b->mtu - FRAME_OVERHEAD - RES_HEAD;
+    if (res_size > res_cap) res_size = (uint16_t)res_cap;
+    
+    __atomic_add_fetch(&b->refs, 1, __ATOMIC_ACQ_REL);
+    esp_err_t err = esp_bus_req_async_h(b->rx_ids[id].h, len ? data : NULL, len, res_size, serve_done, s);
+    if (err != ESP_OK) {
+        xSemaphoreTake(b->lock, portMAX_DELAY);
+        s->busy = false;
+        xSemaphoreGive(b->lock);
+        __atomic_sub_fetch(&b->refs, 1, __ATOMIC_ACQ_REL);
+        send_res(b, seq, err, NULL, 0);
+    }
+}
+
+static void rx_res(bridge_t *b, uint16_t seq, esp_err_t err, const uint8_t *data, size_t len) {
+    b->rx_cnt.rx_msgs++;
+    
+    // No match: the caller timed out already
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    for (size_t i = 0; i < PENDING_MAX; i++) {
+        pending_t *pd = &b->pending[i];
+        if (!pd->busy || pd->done || pd->seq != seq) continue;
+        
+        pd->res_len = len < pd->res_size ? len : pd->res_size;
+        if (pd->res_len) memcpy(pd->res, data, pd->res_len);
+        pd->err = err;
+        pd->done = true;
+        xSemaphoreGive(pd->sem);
+        break;
+    }
+    xSemaphoreGive(b->lock);
+}
+
+// Length of the record at p, 0 if it is unknown or its header is cut short
+static size_t rec_len(const uint8_t *p, size_t left) {
+    switch (p[0]) {
+        case REC_HELLO: return HELLO_LEN;
+        case REC_DEF:   return left < DEF_HEAD ? 0 : DEF_HEAD + p[4];
+        case REC_EVT:   return left < EVT_HEAD ? 0 : EVT_HEAD + get16(p + 3);
+        case REC_REQ:   return left < REQ_HEAD ? 0 : REQ_HEAD + get16(p + 7);
+        case REC_RES:   return left < RES_HEAD ? 0 : RES_HEAD + get16(p + 7);
+        default:        return 0;
+    }
+}
+
+static void rx_frame(bridge_t *b, const uint8_t *p, size_t len) {
+    const uint8_t *end = p + len;
+    
+    while (p < end) {
+        size_t n = rec_len(p, end - p);
+        if (n == 0 || n > (size_t)(end - p)) {
+            // The rest of the frame cannot be trusted
+            b->rx_cnt.rx_errors++;
+            return;
+        }
+        
+        switch (p[0]) {
+            case REC_HELLO:
+                rx_hello(b);
+                break;
+            case REC_DEF:
+                rx_def(b, get16(p + 1), p[3], p + DEF_HEAD, p[4]);
+                break;
+            case REC_EVT:
+                rx_evt(b, get16(p + 1), p + EVT_HEAD, get16(p + 3));
+                break;
+            case REC_REQ:
+                rx_req(b, get16(p + 1), get16(p + 3), get16(p + 5), p + REQ_HEAD, get16(p + 7));
+                break;
+            case REC_RES:
+                rx_res(b, get16(p + 1), (esp_err_t)get32(p + 3), p + RES_HEAD, get16(p + 7));
+                break;
+        }
+        p += n;
+    }
+}
+
+static void rx_check(bridge_t *b) {
+    size_t len = get16(b->rx + 2);
+    if (esp_rom_crc16_le(0, b->rx + 2, len + 2) != get16(b->rx + FRAME_HEAD + len)) {
+        b->rx_cnt.rx_errors++;
+        return;
+    }
+    b->rx_cnt.rx_frames++;
+    rx_frame(b, b->rx + FRAME_HEAD, len);
+}
+
+// ============================================================================
+// Action Handlers
+// ============================================================================
+
+static esp_err_t bridge_stats(const char *action, const void *req, size_t req_len,
+                              void *res, size_t res_size, size_t *res_len, void *ctx) {
+    bridge_t *b = (bridge_t *)ctx;
+    if (!res || res_size < sizeof(esp_bus_bridge_stats_t)) return ESP_ERR_INVALID_SIZE;
+    
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    memcpy(res, &b->stats, sizeof(b->stats));
+    xSemaphoreGive(b->lock);
+    if (res_len) *res_len = sizeof(esp_bus_bridge_stats_t);
+    return ESP_OK;
+}
+
+static esp_err_t bridge_reset_stats(const char *action, const void *req, size_t req_len,
+                                    void *res, size_t res_size, size_t *res_len, void *ctx) {
+    bridge_t *b = (bridge_t *)ctx;
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    memset(&b->stats, 0, sizeof(b->stats));
+    xSemaphoreGive(b->lock);
+    return ESP_OK;
+}
+
+static esp_err_t bridge_hello(const char *action, const void *req, size_t req_len,
+                              void *res, size_t res_size, size_t *res_len, void *ctx) {
+    send_hello((bridge_t *)ctx);
+    return ESP_OK;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+static void bridge_free(void *ctx) {
+    bridge_t *b = (bridge_t *)ctx;
+    
+    // Served requests and remote calls still use the context
+    if (__atomic_load_n(&b->refs, __ATOMIC_ACQUIRE) > 0) {
+        if (esp_bus_after(bridge_free, 10, b) < 0) {
+            ESP_LOGW(TAG, "'%s' context leaked", b->name);
+        }
+        return;
+    }
+    
+    if (b->flush_timer >= 0) esp_bus_cancel(b->flush_timer);
+    for (size_t i = 0; i < PENDING_MAX; i++) {
+        if (b->pending[i].sem) vSemaphoreDelete(b->pending[i].sem);
+    }
+    if (b->lock) vSemaphoreDelete(b->lock);
+    free(b->tx);
+    free(b->serve);
+    free(b->subs);
+    free(b);
+}
+
+// Takes the bridge off the bus; the context goes once nothing uses it
+static void bridge_close(bridge_t *b) {
+    char name[ESP_BUS_NAME_MAX];
+    
+    for (size_t i = 0; i < b->sub_cnt; i++) esp_bus_unsub(b->subs[i]);
+    for (size_t i = 0; i < b->proxy_reg; i++) {
+        snprintf(name, sizeof(name), "%s%s", b->prefix, b->proxies[i].name);
+        esp_bus_unreg(name);
+    }
+    if (b->registered) esp_bus_unreg(b->name);
+    
+    if (b->lock) {
+        xSemaphoreTake(b->lock, portMAX_DELAY);
+        b->closing = true;
+        for (size_t i = 0; i < PENDING_MAX; i++) {
+            if (b->pending[i].busy) xSemaphoreGive(b->pending[i].sem);
+        }
+        xSemaphoreGive(b->lock);
+    }
+    
+    // Never on the bus: nothing else can hold the context
+    if (!b->registered) {
+        bridge_free(b);
+        return;
+    }
+    
+    // Free on the bus task, after any event or flush already queued has run
+    if (esp_bus_after(bridge_free, 0, b) < 0) {
+        ESP_LOGW(TAG, "'%s' context leaked", b->name);
+    }
+}
+
+static esp_err_t bridge_open(bridge_t *b, const esp_bus_bridge_cfg_t *cfg) {
+    b->lock = xSemaphoreCreateMutex();
+    if (!b->lock) return ESP_ERR_NO_MEM;
+    for (size_t i = 0; i < PENDING_MAX; i++) {
+        b->pending[i].sem = xSemaphoreCreateBinary();
+        if (!b->pending[i].sem) return ESP_ERR_NO_MEM;
+    }
+    
+    esp_bus_module_t mod = {
+        .name = b->name,
+        .ctx = b,
+        .actions = esp_bus_bridge_actions,
+        .action_cnt = esp_bus_bridge_action_cnt,
+        .events = esp_bus_bridge_events,
+        .event_cnt = esp_bus_bridge_event_cnt,
+    };
+    esp_err_t err = esp_bus_reg(&mod);
+    if (err != ESP_OK) return err;
+    b->registered = true;
+    
+    // No schema: the peer's module decides which actions exist
+    char name[ESP_BUS_NAME_MAX];
+    for (; b->proxy_reg < b->proxy_cnt; b->proxy_reg++) {
+        proxy_t *px = &b->proxies[b->proxy_reg];
+        snprintf(name, sizeof(name), "%s%s", b->prefix, px->name);
+        esp_bus_module_t proxy = {
+            .name = name,
+            .on_req = proxy_req,
+            .ctx = px,
+            .worker = cfg->worker,
+        };
+        err = esp_bus_reg(&proxy);
+        if (err != ESP_OK) return err;
+    }
+    
+    for (; b->sub_cnt < cfg->event_cnt; b->sub_cnt++) {
+        int id = esp_bus_sub(cfg->events[b->sub_cnt], bridge_evt, b);
+        if (id < 0) return ESP_ERR_INVALID_ARG;
+        b->subs[b->sub_cnt] = id;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_bus_bridge_reg(const char *name, const esp_bus_bridge_cfg_t *cfg) {
+    if (!name || !cfg || !cfg->send || !cfg->prefix || !cfg->prefix[0]) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if ((cfg->event_cnt && !cfg->events) || (cfg->module_cnt && !cfg->modules) ||
+        (cfg->serve_cnt && !cfg->serve)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // A frame must hold the longest pattern definition
+    uint16_t mtu = cfg->mtu ? cfg->mtu : ESP_BUS_BRIDGE_MTU;
+    size_t prefix_len = strlen(cfg->prefix);
+    if (mtu < FRAME_OVERHEAD + DEF_HEAD + ESP_BUS_PATTERN_MAX || prefix_len >= ESP_BUS_NAME_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < cfg->module_cnt; i++) {
+        if (!cfg->modules[i] || prefix_len + strlen(cfg->modules[i]) >= ESP_BUS_NAME_MAX) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    if (bridge_find(name)) return ESP_ERR_INVALID_STATE;
+    
+    // Allocate context
+    bridge_t *b = calloc(1, sizeof(bridge_t) + cfg->module_cnt * sizeof(proxy_t));
+    if (!b) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    strncpy(b->name, name, ESP_BUS_NAME_MAX - 1);
+    strncpy(b->prefix, cfg->prefix, ESP_BUS_NAME_MAX - 1);
+    b->prefix_len = prefix_len;
+    b->send = cfg->send;
+    b->send_ctx = cfg->send_ctx;
+    b->mtu = mtu;
+    b->batch_ms = cfg->batch_ms;
+    b->timeout_ms = cfg->timeout_ms ? cfg->timeout_ms : DEFAULT_TIMEOUT;
+    b->flush_timer = -1;
+    b->serve_all = cfg->serve == NULL;
+    for (size_t i = 0; i < SERVE_MAX; i++) b->served[i].bridge = b;
+    for (size_t i = 0; i < cfg->module_cnt; i++) {
+        b->proxies[i].bridge = b;
+        strncpy(b->proxies[i].name, cfg->modules[i], ESP_BUS_NAME_MAX - 1);
+    }
+    b->proxy_cnt = cfg->module_cnt;
+    
+    b->tx = malloc(2 * mtu);
+    b->rx = b->tx ? b->tx + mtu : NULL;
+    b->subs = cfg->event_cnt ? calloc(cfg->event_cnt, sizeof(int)) : NULL;
+    b->serve = cfg->serve_cnt ? calloc(cfg->serve_cnt, ESP_BUS_NAME_MAX) : NULL;
+    if (!b->tx || (cfg->event_cnt && !b->subs) || (cfg->serve_cnt && !b->serve)) {
+        free(b->tx);
+        free(b->subs);
+        free(b->serve);
+        free(b);
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t i = 0; i < cfg->serve_cnt; i++) {
+        if (cfg->serve[i]) strncpy(b->serve[i], cfg->serve[i], ESP_BUS_NAME_MAX - 1);
+    }
+    b->serve_cnt = cfg->serve_cnt;
+    
+    // Register module, remote modules and forwarded events
+    esp_err_t err = bridge_open(b, cfg);
+    if (err != ESP_OK) {
+        bridge_close(b);
+        return err;
+    }
+    
+    b->next = s_bridges;
+    s_bridges = b;
+    
+    send_hello(b);
+    ESP_LOGI(TAG, "Registered '%s' (%u remote modules, %u event patterns)",
+             name, (unsigned)cfg->module_cnt, (unsigned)cfg->event_cnt);
+    return ESP_OK;
+}
+
+esp_err_t esp_bus_bridge_input(const char *name, const void *data, size_t len) {
+    if (!name || (!data && len)) return ESP_ERR_INVALID_ARG;
+    
+    bridge_t *b = bridge_find(name);
+    if (!b) return ESP_ERR_NOT_FOUND;
+    
+    const uint8_t *in = (const uint8_t *)data;
+    b->rx_cnt.rx_bytes += len;
+    
+    while (len > 0) {
+        if (b->rx_len < FRAME_HEAD) {
+            // Hunt for the sync word, then take the length
+            uint8_t c = *in++;
+            len--;
+            if (b->rx_len == 0 && c != SYNC0) continue;
+            if (b->rx_len == 1 && c != SYNC1) {
+                b->rx_len = c == SYNC0;
+                continue;
+            }
+            b->rx[b->rx_len++] = c;
+            if (b->rx_len == FRAME_HEAD && get16(b->rx + 2) > b->mtu - FRAME_OVERHEAD) {
+                b->rx_cnt.rx_errors++;
+                b->rx_len = 0;
+            }
+            continue;
+        }
+        
+        size_t total = get16(b->rx + 2) + FRAME_OVERHEAD;
+        size_t n = total - b->rx_len;
+        if (n > len) n = len;
+        memcpy(b->rx + b->rx_len, in, n);
+        b->rx_len += n;
+        in += n;
+        len -= n;
+        
+        if (b->rx_len == total) {
+            rx_check(b);
+            b->rx_len = 0;
+        }
+    }
+    
+    // stats is read and cleared on the serving task
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    b->stats.rx_frames += b->rx_cnt.rx_frames;
+    b->stats.rx_bytes += b->rx_cnt.rx_bytes;
+    b->stats.rx_msgs += b->rx_cnt.rx_msgs;
+    b->stats.rx_errors += b->rx_cnt.rx_errors;
+    b->stats.drops += b->rx_cnt.drops;
+    xSemaphoreGive(b->lock);
+    memset(&b->rx_cnt, 0, sizeof(b->rx_cnt));
+    return ESP_OK;
+}
+
+esp_err_t esp_bus_bridge_unreg(const char *name) {
+    if (!name) return ESP_ERR_INVALID_ARG;
+    
+    bridge_t **pp = &s_bridges;
+    while (*pp && strcmp((*pp)->name, name) != 0) pp = &(*pp)->next;
+    bridge_t *b = *pp;
+    if (!b) return ESP_ERR_NOT_FOUND;
+    *pp = b->next;
+    
+    bridge_close(b);
+    ESP_LOGI(TAG, "Unregistered '%s'", name);
+    return ESP_OK;
+}
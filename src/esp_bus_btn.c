@@ -14,11 +14,16 @@ static const char *TAG = "esp_bus_btn";
 // Schema
 // ============================================================================
 
+static esp_err_t btn_get_state(const char *, const void *, size_t, void *, size_t, size_t *, void *);
+static esp_err_t btn_config(const char *, const void *, size_t, void *, size_t, size_t *, void *);
+
+// wait_press and wait_release would need a blocking implementation and
+// answer ESP_ERR_NOT_SUPPORTED for now
 const esp_bus_action_t esp_bus_btn_actions[] = {
-    {BTN_GET_STATE,    "none", "btn_state_t", "Get button state"},
-    {BTN_WAIT_PRESS,   "none", "none",        "Block until pressed"},
-    {BTN_WAIT_RELEASE, "none", "none",        "Block until released"},
-    {BTN_CONFIG,       "btn_cfg_t", "none",   "Reconfigure button"},
+    {BTN_GET_STATE,    "none", "btn_state_t", "Get button state",     btn_get_state},
+    {BTN_WAIT_PRESS,   "none", "none",        "Block until pressed",  NULL},
+    {BTN_WAIT_RELEASE, "none", "none",        "Block until released", NULL},
+    {BTN_CONFIG,       "btn_cfg_t", "none",   "Reconfigure button",   btn_config},
 };
 const size_t esp_bus_btn_action_cnt = sizeof(esp_bus_btn_actions) / sizeof(esp_bus_btn_actions[0]);
 
@@ -35,7 +40,7 @@ const size_t esp_bus_btn_event_cnt = sizeof(esp_bus_btn_events) / sizeof(esp_bus
 // Context
 // ============================================================================
 
-typedef struct {
+typedef struct btn_ctx {
     char name[ESP_BUS_NAME_MAX];
     gpio_num_t pin;
     bool active_low;
@@ -54,9 +59,20 @@ typedef struct {
     int64_t debounce_until_ms;  // Debounce end time
     bool long_fired;            // Long press event already fired
     
-    int tick_id;                // Service tick ID
+    int tick_id;                // Service tick ID (polling mode)
+    
+    // Interrupt mode
+    bool use_isr;
+    int poll_id;                // Pending poll timer, -1 if idle (bus task only)
+    bool closing;               // Unregistered, waiting to be freed
+    
+    struct btn_ctx *next;
 } btn_ctx_t;
 
+static btn_ctx_t *s_btns = NULL;
+
+#define BTN_POLL_MS 10
+
 // ============================================================================
 // Helpers
 // ============================================================================
@@ -140,41 +156,127 @@ static void btn_tick(void *ctx) {
 }
 
 // ============================================================================
-// Request Handler
+// Interrupt Mode
 // ============================================================================
 
-static esp_err_t btn_req_handler(const char *action, const void *req, size_t req_len,
-                                  void *res, size_t res_size, size_t *res_len, void *ctx) {
-    btn_ctx_t *btn = (btn_ctx_t *)ctx;
-    
-    if (strcmp(action, BTN_GET_STATE) == 0) {
-        if (res && res_size >= sizeof(esp_bus_btn_state_t)) {
-            esp_bus_btn_state_t *state = (esp_bus_btn_state_t *)res;
-            state->pressed = btn->state;
-            state->press_count = btn->press_count;
-            state->last_press_ms = btn->last_press_ms;
-            if (res_len) *res_len = sizeof(esp_bus_btn_state_t);
-        } else if (res && res_size >= sizeof(uint8_t)) {
-            *(uint8_t *)res = btn->state;
-            if (res_len) *res_len = sizeof(uint8_t);
+// Debouncing, a settled level not yet reported, or a long press still to
+// time: all need sampling. Otherwise only an edge can change anything.
+static bool btn_busy(btn_ctx_t *btn) {
+    return now_ms() < btn->debounce_until_ms ||
+           btn->raw_state != btn->state ||
+           read_pin(btn) != btn->state ||
+           (btn->state && !btn->long_fired);
+}
+
+static void btn_poll(void *ctx);
+
+static void btn_arm(btn_ctx_t *btn) {
+    if (!btn_busy(btn)) {
+        gpio_intr_enable(btn->pin);
+        // An edge between the last sample and enabling would be lost
+        if (read_pin(btn) == btn->state) {
+            btn->poll_id = -1;
+            return;
         }
-        return ESP_OK;
+        gpio_intr_disable(btn->pin);
     }
     
-    if (strcmp(action, BTN_CONFIG) == 0) {
-        if (req && req_len >= sizeof(esp_bus_btn_cfg_t)) {
-            const esp_bus_btn_cfg_t *cfg = (const esp_bus_btn_cfg_t *)req;
-            if (cfg->long_press_ms > 0) btn->long_press_ms = cfg->long_press_ms;
-            if (cfg->double_press_ms > 0) btn->double_press_ms = cfg->double_press_ms;
-            if (cfg->debounce_ms > 0) btn->debounce_ms = cfg->debounce_ms;
-        }
-        return ESP_OK;
+    if (btn->poll_id >= 0 && esp_bus_rearm(btn->poll_id, BTN_POLL_MS) == ESP_OK) return;
+    
+    btn->poll_id = esp_bus_after(btn_poll, BTN_POLL_MS, btn);
+    if (btn->poll_id < 0) {
+        gpio_intr_enable(btn->pin);
+    }
+}
+
+static void btn_poll(void *ctx) {
+    btn_ctx_t *btn = (btn_ctx_t *)ctx;
+    if (__atomic_load_n(&btn->closing, __ATOMIC_ACQUIRE)) return;
+    
+    btn_tick(btn);
+    btn_arm(btn);
+}
+
+// Deferred from the GPIO ISR, runs on the bus task
+static void btn_wake(void *ctx) {
+    btn_ctx_t *btn = (btn_ctx_t *)ctx;
+    if (__atomic_load_n(&btn->closing, __ATOMIC_ACQUIRE) || btn->poll_id >= 0) return;
+    
+    btn_tick(btn);
+    btn_arm(btn);
+}
+
+static void btn_isr(void *arg) {
+    btn_ctx_t *btn = (btn_ctx_t *)arg;
+    BaseType_t woken = pdFALSE;
+    
+    gpio_intr_disable(btn->pin);
+    if (esp_bus_defer_isr(btn_wake, btn, &woken) != ESP_OK) {
+        // Ring full: keep the interrupt so the next edge retries
+        gpio_intr_enable(btn->pin);
+    }
+    if (woken) portYIELD_FROM_ISR();
+}
+
+// Runs on the bus task from the ISR ring, behind any wake queued before the
+// interrupt handler was removed
+static void btn_free(void *ctx) {
+    btn_ctx_t *btn = (btn_ctx_t *)ctx;
+    esp_bus_cancel(btn->poll_id);
+    free(btn);
+}
+
+// Retried while the ring is full: a timer alone could run before a wake
+static void btn_retire(void *ctx) {
+    if (esp_bus_defer(btn_free, ctx) == ESP_OK) return;
+    if (esp_bus_after(btn_retire, BTN_POLL_MS, ctx) < 0) {
+        ESP_LOGW(TAG, "'%s' context leaked", ((btn_ctx_t *)ctx)->name);
     }
+}
+
+// ============================================================================
+// Action Handlers
+// ============================================================================
+
+// out may be a bus buffer, which is not 8-byte aligned
+static void fill_state(const btn_ctx_t *btn, void *out) {
+    esp_bus_btn_state_t state = {
+        .pressed = btn->state,
+        .press_count = btn->press_count,
+        .last_press_ms = btn->last_press_ms,
+    };
+    memcpy(out, &state, sizeof(state));
+}
+
+static esp_err_t btn_get_state(const char *action, const void *req, size_t req_len,
+                               void *res, size_t res_size, size_t *res_len, void *ctx) {
+    btn_ctx_t *btn = (btn_ctx_t *)ctx;
+    esp_bus_buf_t *buf = NULL;
     
-    // wait_press and wait_release would need blocking implementation
-    // For now, return not supported
+    if (res && res_size >= sizeof(esp_bus_btn_state_t)) {
+        fill_state(btn, res);
+        if (res_len) *res_len = sizeof(esp_bus_btn_state_t);
+    } else if (res && res_size >= sizeof(uint8_t)) {
+        *(uint8_t *)res = btn->state;
+        if (res_len) *res_len = sizeof(uint8_t);
+    } else if (!res && (buf = esp_bus_res_buf(sizeof(esp_bus_btn_state_t)))) {
+        // esp_bus_req_buf() caller: full state, no buffer sizing needed
+        fill_state(btn, buf->data);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t btn_config(const char *action, const void *req, size_t req_len,
+                            void *res, size_t res_size, size_t *res_len, void *ctx) {
+    btn_ctx_t *btn = (btn_ctx_t *)ctx;
     
-    return ESP_ERR_NOT_SUPPORTED;
+    if (req && req_len >= sizeof(esp_bus_btn_cfg_t)) {
+        const esp_bus_btn_cfg_t *cfg = (const esp_bus_btn_cfg_t *)req;
+        if (cfg->long_press_ms > 0) btn->long_press_ms = cfg->long_press_ms;
+        if (cfg->double_press_ms > 0) btn->double_press_ms = cfg->double_press_ms;
+        if (cfg->debounce_ms > 0) btn->debounce_ms = cfg->debounce_ms;
+    }
+    return ESP_OK;
 }
 
 // ============================================================================
@@ -199,13 +301,16 @@ esp_err_t esp_bus_btn_reg(const char *name, const esp_bus_btn_cfg_t *cfg) {
     ctx->double_press_ms = cfg->double_press_ms > 0 ? cfg->double_press_ms : 300;
     ctx->debounce_ms = cfg->debounce_ms > 0 ? cfg->debounce_ms : 20;
     
+    ctx->use_isr = cfg->use_isr;
+    ctx->poll_id = -1;
+    
     // Configure GPIO
     gpio_config_t io_cfg = {
         .pin_bit_mask = (1ULL << cfg->pin),
         .mode = GPIO_MODE_INPUT,
         .pull_up_en = cfg->active_low ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE,
         .pull_down_en = cfg->active_low ? GPIO_PULLDOWN_DISABLE : GPIO_PULLDOWN_ENABLE,
-        .intr_type = GPIO_INTR_DISABLE,
+        .intr_type = cfg->use_isr ? GPIO_INTR_ANYEDGE : GPIO_INTR_DISABLE,
     };
     esp_err_t err = gpio_config(&io_cfg);
     if (err != ESP_OK) {
@@ -221,7 +326,6 @@ esp_err_t esp_bus_btn_reg(const char *name, const esp_bus_btn_cfg_t *cfg) {
     // Register module
     esp_bus_module_t mod = {
         .name = name,
-        .on_req = btn_req_handler,
         .ctx = ctx,
         .actions = esp_bus_btn_actions,
         .action_cnt = esp_bus_btn_action_cnt,
@@ -235,21 +339,69 @@ esp_err_t esp_bus_btn_reg(const char *name, const esp_bus_btn_cfg_t *cfg) {
         return err;
     }
     
-    // Register tick (poll every 10ms)
-    ctx->tick_id = esp_bus_tick(btn_tick, 10, ctx);
-    if (ctx->tick_id < 0) {
-        esp_bus_unreg(name);
-        free(ctx);
-        return ESP_ERR_NO_MEM;
+    if (ctx->use_isr) {
+        // Shared ISR service, may already be installed by the application
+        gpio_intr_disable(cfg->pin);
+        err = gpio_install_isr_service(0);
+        if (err == ESP_OK || err == ESP_ERR_INVALID_STATE) {
+            err = gpio_isr_handler_add(cfg->pin, btn_isr, ctx);
+        }
+        if (err != ESP_OK) {
+            esp_bus_unreg(name);
+            free(ctx);
+            return err;
+        }
+        ctx->tick_id = -1;
+        ctx->next = s_btns;
+        s_btns = ctx;
+        
+        // First sample on the bus task arms the interrupt; without it the
+        // interrupt stays disabled. Queued in the ISR ring like any wake,
+        // so an unreg right after still frees behind it.
+        err = esp_bus_defer(btn_wake, ctx);
+        if (err != ESP_OK) {
+            gpio_isr_handler_remove(cfg->pin);
+            s_btns = ctx->next;
+            esp_bus_unreg(name);
+            free(ctx);
+            return err;
+        }
+    } else {
+        // Register tick (poll every 10ms)
+        ctx->tick_id = esp_bus_tick(btn_tick, BTN_POLL_MS, ctx);
+        if (ctx->tick_id < 0) {
+            esp_bus_unreg(name);
+            free(ctx);
+            return ESP_ERR_NO_MEM;
+        }
+        ctx->next = s_btns;
+        s_btns = ctx;
     }
     
-    ESP_LOGI(TAG, "Registered '%s' on GPIO%d", name, cfg->pin);
+    ESP_LOGI(TAG, "Registered '%s' on GPIO%d%s", name, cfg->pin, cfg->use_isr ? " (isr)" : "");
     return ESP_OK;
 }
 
 esp_err_t esp_bus_btn_unreg(const char *name) {
-    // Note: This is a simplified version
-    // Full implementation would need to track and free context
-    return esp_bus_unreg(name);
+    if (!name) return ESP_ERR_INVALID_ARG;
+    
+    btn_ctx_t **pp = &s_btns;
+    while (*pp && strcmp((*pp)->name, name) != 0) pp = &(*pp)->next;
+    btn_ctx_t *btn = *pp;
+    if (!btn) return esp_bus_unreg(name);
+    *pp = btn->next;
+    
+    esp_err_t err = esp_bus_unreg(name);
+    
+    if (btn->use_isr) {
+        gpio_intr_disable(btn->pin);
+        gpio_isr_handler_remove(btn->pin);
+    } else {
+        esp_bus_tick_del(btn->tick_id);
+    }
+    
+    // Free on the bus task, after any queued wake or poll has run
+    __atomic_store_n(&btn->closing, true, __ATOMIC_RELEASE);
+    btn_retire(btn);
+    return err;
 }
-
@@ -0,0 +1,189 @@
+/**
+ * @file esp_bus_idx.c
+ * @brief ESP Bus - Subscription index
+ *
+ * Listeners (subscriptions and routes) are classified when they are added:
+ * - exact "mod:evt"      -> list on the interned pattern node
+ * - prefix "btn*..."     -> prefix trie keyed on the text before the first '*'
+ * - suffix "*:pressed"   -> suffix trie keyed on the text after the last '*'
+ * - "*..." ending in '*' -> glob list, checked with esp_bus_match_pattern()
+ *
+ * A single trailing (prefix) or leading (suffix) '*' is fully decided by the
+ * trie walk; any other glob found in a trie is verified with the matcher, so
+ * results are identical to matching every listener against the event.
+ * Subscribers are all served before any route, as they were when the
+ * subscription and route lists were matched one after the other.
+ *
+ * Writers hold g_bus.mutex and publish with release stores; dispatch walks
+ * the index lock-free inside a read section, and unlinked listeners and
+ * trie nodes are retired rather than freed (see esp_bus_rcu.c).
+ */
+
+#include "esp_bus_priv.h"
+#include <string.h>
+#include <stdlib.h>
+
+// ============================================================================
+// Trie
+// ============================================================================
+
+static trie_node_t *trie_child(trie_node_t *node, char c) {
+    trie_node_t *ch;
+    for (ch = __atomic_load_n(&node->child, __ATOMIC_ACQUIRE); ch;
+         ch = __atomic_load_n(&ch->sibling, __ATOMIC_ACQUIRE)) {
+        if (ch->c == c) return ch;
+    }
+    return NULL;
+}
+
+static trie_node_t *trie_get(trie_node_t *root, const char *key, size_t len, bool reverse) {
+    trie_node_t *node = root;
+    for (size_t i = 0; i < len; i++) {
+        char c = reverse ? key[len - 1 - i] : key[i];
+        trie_node_t *ch = trie_child(node, c);
+        if (!ch) {
+            ch = calloc(1, sizeof(trie_node_t));
+            if (!ch) return NULL;
+            ch->c = c;
+            ch->parent = node;
+            SLIST_INIT(&ch->subs);
+            ch->sibling = node->child;
+            __atomic_store_n(&node->child, ch, __ATOMIC_RELEASE);
+        }
+        node = ch;
+    }
+    return node;
+}
+
+static void trie_prune(trie_node_t *node) {
+    while (node->parent && !node->child && SLIST_EMPTY(&node->subs)) {
+        trie_node_t *parent = node->parent;
+        trie_node_t **pp = &parent->child;
+        while (*pp != node) pp = &(*pp)->sibling;
+        __atomic_store_n(pp, node->sibling, __ATOMIC_RELEASE);
+        esp_bus_retire(&node->rcu, free);
+        node = parent;
+    }
+}
+
+static void trie_free(trie_node_t *node) {
+    trie_node_t *ch = node->child;
+    while (ch) {
+        trie_node_t *next = ch->sibling;
+        trie_free(ch);
+        free(ch);
+        ch = next;
+    }
+    node->child = NULL;
+}
+
+static void deliver(const struct idx_list *list, bool routes,
+                    const pat_node_t *pat, const void *data, size_t len) {
+    sub_node_t *s;
+    RCU_SLIST_FOREACH(s, list, idx_next) {
+        if ((s->id < 0) != routes) continue;
+        if (s->verify && !esp_bus_match_pattern(s->pattern, pat->pattern)) continue;
+        if (s->worker || s->budget_us) {
+            esp_bus_sub_deliver(s, pat, data, len);
+        } else {
+            s->handler(pat->name, data, len, s->ctx);
+        }
+    }
+}
+
+// ============================================================================
+// Internal API
+// ============================================================================
+
+void esp_bus_idx_init(void) {
+    memset(&g_bus.prefix_root, 0, sizeof(g_bus.prefix_root));
+    memset(&g_bus.suffix_root, 0, sizeof(g_bus.suffix_root));
+    SLIST_INIT(&g_bus.prefix_root.subs);
+    SLIST_INIT(&g_bus.suffix_root.subs);
+    SLIST_INIT(&g_bus.globs);
+}
+
+// Caller holds g_bus.mutex
+esp_err_t esp_bus_idx_add(sub_node_t *sub) {
+    const char *p = sub->pattern;
+    const char *first = strchr(p, '*');
+    
+    if (!first) {
+        pat_node_t *pat = esp_bus_pat_intern_locked(p);
+        if (pat) {
+            sub->kind = SUB_EXACT;
+            sub->verify = false;
+            sub->list = &pat->subs;
+            RCU_SLIST_INSERT_HEAD(sub->list, sub, idx_next);
+            return ESP_OK;
+        }
+        // Not internable (no separator): leave exact semantics to the matcher
+    }
+    
+    const char *last = first ? strrchr(p, '*') : NULL;
+    size_t prefix_len = first ? (size_t)(first - p) : 0;
+    size_t suffix_len = last ? strlen(last + 1) : 0;
+    trie_node_t *node = NULL;
+    
+    if (prefix_len > 0) {
+        node = trie_get(&g_bus.prefix_root, p, prefix_len, false);
+        if (!node) return ESP_ERR_NO_MEM;
+        sub->kind = SUB_PREFIX;
+        sub->verify = !(first == last && suffix_len == 0);
+    } else if (suffix_len > 0) {
+        node = trie_get(&g_bus.suffix_root, last + 1, suffix_len, true);
+        if (!node) return ESP_ERR_NO_MEM;
+        sub->kind = SUB_SUFFIX;
+        sub->verify = (first != last);
+    } else {
+        sub->kind = SUB_GLOB;
+        sub->verify = true;
+    }
+    
+    sub->trie = node;
+    sub->list = node ? &node->subs : &g_bus.globs;
+    RCU_SLIST_INSERT_HEAD(sub->list, sub, idx_next);
+    return ESP_OK;
+}
+
+// Caller holds g_bus.mutex
+void esp_bus_idx_remove(sub_node_t *sub) {
+    if (!sub->list) return;
+    RCU_SLIST_REMOVE(sub->list, sub, sub_node, idx_next);
+    sub->list = NULL;
+    if (sub->trie) {
+        trie_prune(sub->trie);
+        sub->trie = NULL;
+    }
+}
+
+static void walk(const pat_node_t *pat, bool routes, const void *data, size_t len) {
+    const char *full = pat->pattern;
+    size_t full_len = strlen(full);
+    
+    deliver(&pat->subs, routes, pat, data, len);
+    
+    trie_node_t *node = &g_bus.prefix_root;
+    for (size_t i = 0; i < full_len && (node = trie_child(node, full[i])); i++) {
+        if (RCU_SLIST_FIRST(&node->subs)) deliver(&node->subs, routes, pat, data, len);
+    }
+    
+    node = &g_bus.suffix_root;
+    for (size_t i = full_len; i > 0 && (node = trie_child(node, full[i - 1])); i--) {
+        if (RCU_SLIST_FIRST(&node->subs)) deliver(&node->subs, routes, pat, data, len);
+    }
+    
+    deliver(&g_bus.globs, routes, pat, data, len);
+}
+
+// Routes share the index but run after every subscriber, so a routed
+// request never overtakes a subscriber of the same event
+void esp_bus_idx_dispatch(const pat_node_t *pat, const void *data, size_t len) {
+    walk(pat, false, data, len);
+    if (RCU_SLIST_FIRST(&g_bus.routes)) walk(pat, true, data, len);
+}
+
+void esp_bus_idx_free_all(void) {
+    trie_free(&g_bus.prefix_root);
+    trie_free(&g_bus.suffix_root);
+}
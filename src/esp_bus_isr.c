@@ -0,0 +1,195 @@
+/**
+ * @file esp_bus_isr.c
+ * @brief ESP Bus - ISR event ring
+ *
+ * Bounded multi-producer ring preallocated at init, carrying events and
+ * deferred calls from interrupt context. Each slot carries a
+ * sequence number: producers claim a position with a CAS on the head and
+ * publish the slot by advancing its sequence, the bus task is the only
+ * consumer. Producers never allocate or take a lock, so they are safe in
+ * interrupt context on either core.
+ */
+
+#include "esp_bus_priv.h"
+#include <string.h>
+#include <stdlib.h>
+
+// ============================================================================
+// Init / Deinit
+// ============================================================================
+
+esp_err_t esp_bus_isr_init(void) {
+    uint32_t size = 1;
+    while (size < BUS_ISR_RING_SIZE) size <<= 1;
+    
+    g_bus.isr_ring = calloc(size, sizeof(isr_slot_t));
+    if (!g_bus.isr_ring) return ESP_ERR_NO_MEM;
+    
+    for (uint32_t i = 0; i < size; i++) {
+        g_bus.isr_ring[i].seq = i;
+    }
+    g_bus.isr_mask = size - 1;
+    g_bus.isr_head = 0;
+    g_bus.isr_tail = 0;
+    g_bus.isr_pending = 0;
+    return ESP_OK;
+}
+
+void esp_bus_isr_deinit(void) {
+    free(g_bus.isr_ring);
+    g_bus.isr_ring = NULL;
+}
+
+// ============================================================================
+// Producer
+// ============================================================================
+
+static isr_slot_t *ring_claim(uint32_t *pos_out) {
+    uint32_t pos = __atomic_load_n(&g_bus.isr_head, __ATOMIC_RELAXED);
+    
+    while (1) {
+        isr_slot_t *slot = &g_bus.isr_ring[pos & g_bus.isr_mask];
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        int32_t dif = (int32_t)(seq - pos);
+        
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&g_bus.isr_head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *pos_out = pos;
+                return slot;
+            }
+        } else if (dif < 0) {
+            return NULL;    // Full
+        } else {
+            pos = __atomic_load_n(&g_bus.isr_head, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// True when the bus task needs waking: one wake-up per drain, however many
+// entries arrive meanwhile
+static bool ring_commit(isr_slot_t *slot, uint32_t pos) {
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    return __atomic_exchange_n(&g_bus.isr_pending, 1, __ATOMIC_SEQ_CST) == 0;
+}
+
+static void ring_publish(isr_slot_t *slot, uint32_t pos, BaseType_t *woken) {
+    if (ring_commit(slot, pos)) xSemaphoreGiveFromISR(g_bus.wake, woken);
+}
+
+static esp_err_t isr_emit(pat_node_t *pat, const char *src, const char *evt,
+                          const void *data, size_t len, BaseType_t *woken) {
+    if (!g_bus.isr_ring) return ESP_ERR_INVALID_STATE;
+    if (len > BUS_ISR_PAYLOAD_MAX) return ESP_ERR_INVALID_SIZE;
+    
+    uint32_t pos;
+    isr_slot_t *slot = ring_claim(&pos);
+    if (!slot) return ESP_ERR_TIMEOUT;
+    
+    slot->fn = NULL;
+    slot->pat = pat;
+    if (!pat) {
+        // Not interned yet: carry the text, the bus task interns it
+        size_t sl = strlen(src);
+        size_t el = strlen(evt);
+        memcpy(slot->pattern, src, sl);
+        slot->pattern[sl] = ':';
+        memcpy(slot->pattern + sl + 1, evt, el + 1);
+    }
+    slot->len = (uint8_t)len;
+    if (len) memcpy(slot->data, data, len);
+    
+    ring_publish(slot, pos, woken);
+    return ESP_OK;
+}
+
+// ============================================================================
+// Consumer (bus task)
+// ============================================================================
+
+void esp_bus_isr_drain(void) {
+    if (!g_bus.isr_ring) return;
+    
+    __atomic_store_n(&g_bus.isr_pending, 0, __ATOMIC_SEQ_CST);
+    
+    while (1) {
+        uint32_t pos = g_bus.isr_tail;
+        isr_slot_t *slot = &g_bus.isr_ring[pos & g_bus.isr_mask];
+        if ((int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - (pos + 1)) < 0) break;
+        
+        if (slot->fn) {
+            slot->fn(slot->ctx);
+        } else {
+            pat_node_t *pat = slot->pat;
+            if (!pat) pat = esp_bus_pat_get(slot->pattern);
+            
+            if (pat && pat->sep == ':') {
+                esp_bus_dispatch_event(pat, slot->len ? slot->data : NULL, slot->len);
+            } else {
+                esp_bus_report_error(slot->pattern, ESP_ERR_INVALID_ARG, "invalid pattern");
+            }
+        }
+        
+        g_bus.isr_tail = pos + 1;
+        __atomic_store_n(&slot->seq, pos + g_bus.isr_mask + 1, __ATOMIC_RELEASE);
+    }
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+esp_err_t esp_bus_emit_isr(const char *src, const char *evt, const void *data, size_t len,
+                           BaseType_t *woken) {
+    if (!g_bus.initialized || !src || !evt) return ESP_ERR_INVALID_ARG;
+    if (len && !data) return ESP_ERR_INVALID_ARG;
+    
+    size_t sl = strlen(src);
+    size_t el = strlen(evt);
+    if (sl + el + 1 >= ESP_BUS_PATTERN_MAX) return ESP_ERR_INVALID_ARG;
+    
+    char full[ESP_BUS_PATTERN_MAX];
+    memcpy(full, src, sl);
+    full[sl] = ':';
+    memcpy(full + sl + 1, evt, el + 1);
+    
+    // Lock-free lookup; a miss is resolved later by the bus task
+    pat_node_t *pat = esp_bus_pat_find(full);
+    if (pat && pat->sep != ':') return ESP_ERR_INVALID_ARG;
+    return isr_emit(pat, src, evt, data, len, woken);
+}
+
+esp_err_t esp_bus_emit_isr_h(esp_bus_handle_t h, const void *data, size_t len,
+                             BaseType_t *woken) {
+    if (!g_bus.initialized || !h || h->sep != ':') return ESP_ERR_INVALID_ARG;
+    if (len && !data) return ESP_ERR_INVALID_ARG;
+    return isr_emit(h, NULL, NULL, data, len, woken);
+}
+
+esp_err_t esp_bus_defer_isr(esp_bus_svc_fn fn, void *ctx, BaseType_t *woken) {
+    if (!g_bus.initialized || !fn) return ESP_ERR_INVALID_ARG;
+    if (!g_bus.isr_ring) return ESP_ERR_INVALID_STATE;
+    
+    uint32_t pos;
+    isr_slot_t *slot = ring_claim(&pos);
+    if (!slot) return ESP_ERR_TIMEOUT;
+    
+    slot->fn = fn;
+    slot->ctx = ctx;
+    ring_publish(slot, pos, woken);
+    return ESP_OK;
+}
+
+esp_err_t esp_bus_defer(esp_bus_svc_fn fn, void *ctx) {
+    if (!g_bus.initialized || !fn) return ESP_ERR_INVALID_ARG;
+    if (!g_bus.isr_ring) return ESP_ERR_INVALID_STATE;
+    
+    uint32_t pos;
+    isr_slot_t *slot = ring_claim(&pos);
+    if (!slot) return ESP_ERR_TIMEOUT;
+    
+    slot->fn = fn;
+    slot->ctx = ctx;
+    if (ring_commit(slot, pos)) xSemaphoreGive(g_bus.wake);
+    return ESP_OK;
+}
@@ -14,13 +14,22 @@ static const char *TAG = "esp_bus_led";
 // Schema
 // ============================================================================
 
+static esp_err_t led_on(const char *, const void *, size_t, void *, size_t, size_t *, void *);
+static esp_err_t led_off(const char *, const void *, size_t, void *, size_t, size_t *, void *);
+static esp_err_t led_toggle_req(const char *, const void *, size_t, void *, size_t, size_t *, void *);
+static esp_err_t led_blink(const char *, const void *, size_t, void *, size_t, size_t *, void *);
+static esp_err_t led_blink_bin(const char *, const void *, size_t, void *, size_t, size_t *, void *);
+static esp_err_t led_pattern(const char *, const void *, size_t, void *, size_t, size_t *, void *);
+static esp_err_t led_get_state(const char *, const void *, size_t, void *, size_t, size_t *, void *);
+
 const esp_bus_action_t esp_bus_led_actions[] = {
-    {LED_ON,        "none",   "none",  "Turn LED on"},
-    {LED_OFF,       "none",   "none",  "Turn LED off"},
-    {LED_TOGGLE,    "none",   "none",  "Toggle LED state"},
-    {LED_BLINK,     "string", "none",  "Blink LED: 'on_ms,off_ms[,count]'"},
-    {LED_PATTERN,   "string", "none",  "LED pattern: 't1,t2,t3,...'"},
-    {LED_GET_STATE, "none",   "uint8", "Get LED state (0/1)"},
+    {LED_ON,        "none",   "none",  "Turn LED on",                       led_on},
+    {LED_OFF,       "none",   "none",  "Turn LED off",                      led_off},
+    {LED_TOGGLE,    "none",   "none",  "Toggle LED state",                  led_toggle_req},
+    {LED_BLINK,     "string", "none",  "Blink LED: 'on_ms,off_ms[,count]'", led_blink},
+    {LED_BLINK_BIN, "led_blink_t", "none", "Blink LED, binary parameters",  led_blink_bin},
+    {LED_PATTERN,   "led_pattern_t", "none", "Run an on/off step pattern",  led_pattern},
+    {LED_GET_STATE, "none",   "uint8", "Get LED state (0/1)",               led_get_state},
 };
 const size_t esp_bus_led_action_cnt = sizeof(esp_bus_led_actions) / sizeof(esp_bus_led_actions[0]);
 
@@ -28,7 +37,7 @@ const size_t esp_bus_led_action_cnt = sizeof(esp_bus_led_actions) / sizeof(esp_b
 // Context
 // ============================================================================
 
-typedef struct {
+typedef struct led_ctx {
     char name[ESP_BUS_NAME_MAX];
     gpio_num_t pin;
     bool active_low;
@@ -36,74 +45,110 @@ typedef struct {
     // State
     uint8_t state;              // Current state (0/1)
     
-    // Blink
-    uint16_t on_ms;
-    uint16_t off_ms;
-    int16_t blink_count;        // -1=infinite, 0=stopped
-    int timer_id;               // Timer ID for blink
+    // Pattern engine: steps[pos] is running, even steps are on
+    uint16_t steps[ESP_BUS_LED_STEPS_MAX];
+    uint8_t step_cnt;
+    uint8_t pos;
+    int16_t repeat;             // Passes left, -1=infinite, 0=stopped
+    int timer_id;               // One-shot timer, re-armed per step
+    
+    uint8_t groups;             // Groups this LED is a member of
+    bool closing;               // Unregistered, waiting to be freed
+    struct led_ctx *next;
+    
+    // Group: drives the members instead of a pin
+    size_t member_cnt;
+    struct led_ctx *members[];
 } led_ctx_t;
 
+static led_ctx_t *s_leds = NULL;
+
 // ============================================================================
 // Helpers
 // ============================================================================
 
-static void led_set_hw(led_ctx_t *led, uint8_t state) {
-    gpio_set_level(led->pin, led->active_low ? !state : state);
-}
-
 static void led_set(led_ctx_t *led, uint8_t state) {
     led->state = state;
-    led_set_hw(led, state);
+    if (led->member_cnt == 0) {
+        gpio_set_level(led->pin, led->active_low ? !state : state);
+    }
+    for (size_t i = 0; i < led->member_cnt; i++) {
+        led_set(led->members[i], state);
+    }
 }
 
 static void led_toggle(led_ctx_t *led) {
     led_set(led, !led->state);
 }
 
-static void led_stop_blink(led_ctx_t *led) {
+// A group also takes its members off their own patterns
+static void led_stop(led_ctx_t *led) {
     if (led->timer_id >= 0) {
         esp_bus_cancel(led->timer_id);
         led->timer_id = -1;
     }
-    led->blink_count = 0;
+    led->repeat = 0;
+    for (size_t i = 0; i < led->member_cnt; i++) {
+        led_stop(led->members[i]);
+    }
+}
+
+static led_ctx_t *led_find(const char *name) {
+    led_ctx_t *led = s_leds;
+    while (led && strcmp(led->name, name) != 0) led = led->next;
+    return led;
 }
 
 // ============================================================================
-// Blink Timer
+// Pattern Engine
 // ============================================================================
 
-static void led_blink_step(void *ctx) {
+static void led_step(void *ctx) {
     led_ctx_t *led = (led_ctx_t *)ctx;
     
-    // Toggle state
-    led_toggle(led);
+    // A closing group no longer owns its members
+    if (__atomic_load_n(&led->closing, __ATOMIC_ACQUIRE)) {
+        led->timer_id = -1;
+        return;
+    }
     
-    // Check if done
-    if (led->blink_count > 0) {
-        led->blink_count--;
-        if (led->blink_count == 0) {
+    if (++led->pos >= led->step_cnt) {
+        led->pos = 0;
+        if (led->repeat > 0 && --led->repeat == 0) {
             led_set(led, 0);  // Turn off when done
             led->timer_id = -1;
             return;
         }
     }
+    led_set(led, !(led->pos & 1));
     
-    // Schedule next toggle
-    uint32_t next_ms = led->state ? led->on_ms : led->off_ms;
-    led->timer_id = esp_bus_after(led_blink_step, next_ms, led);
+    // Reuse the timer that just fired
+    uint16_t ms = led->steps[led->pos];
+    if (esp_bus_rearm(led->timer_id, ms) != ESP_OK) {
+        led->timer_id = esp_bus_after(led_step, ms, led);
+    }
 }
 
-static void led_start_blink(led_ctx_t *led, uint16_t on_ms, uint16_t off_ms, int16_t count) {
-    led_stop_blink(led);
+static void led_start(led_ctx_t *led, const uint16_t *steps, uint8_t cnt, int16_t repeat) {
+    led_stop(led);
     
-    if (count == 0) return;
+    if (repeat == 0 || cnt == 0) return;
     
-    led->on_ms = on_ms > 0 ? on_ms : 200;
-    led->off_ms = off_ms > 0 ? off_ms : 200;
-    led->blink_count = count < 0 ? -1 : count * 2;  // count * 2 for on/off cycles
+    memcpy(led->steps, steps, cnt * sizeof(steps[0]));
+    led->step_cnt = cnt;
+    led->pos = 0;
+    led->repeat = repeat < 0 ? -1 : repeat;
     
     led_set(led, 1);  // Start with LED on
-    led->timer_id = esp_bus_after(led_blink_step, led->on_ms, led);
+    led->timer_id = esp_bus_after(led_step, steps[0], led);
+}
+
+static void led_start_blink(led_ctx_t *led, uint16_t on_ms, uint16_t off_ms, int16_t count) {
+    const uint16_t steps[2] = {
+        on_ms > 0 ? on_ms : 200,
+        off_ms > 0 ? off_ms : 200,
+    };
+    led_start(led, steps, 2, count);
 }
 
 // ============================================================================
@@ -122,63 +167,104 @@ static bool parse_blink_params(const char *str, uint16_t *on_ms, uint16_t *off_m
 }
 
 // ============================================================================
-// Request Handler
+// Action Handlers
 // ============================================================================
 
-static esp_err_t led_req_handler(const char *action, const void *req, size_t req_len,
-                                  void *res, size_t res_size, size_t *res_len, void *ctx) {
+static esp_err_t led_on(const char *action, const void *req, size_t req_len,
+                        void *res, size_t res_size, size_t *res_len, void *ctx) {
+    led_ctx_t *led = (led_ctx_t *)ctx;
+    led_stop(led);
+    led_set(led, 1);
+    return ESP_OK;
+}
+
+static esp_err_t led_off(const char *action, const void *req, size_t req_len,
+                         void *res, size_t res_size, size_t *res_len, void *ctx) {
     led_ctx_t *led = (led_ctx_t *)ctx;
+    led_stop(led);
+    led_set(led, 0);
+    return ESP_OK;
+}
+
+static esp_err_t led_toggle_req(const char *action, const void *req, size_t req_len,
+                                void *res, size_t res_size, size_t *res_len, void *ctx) {
+    led_ctx_t *led = (led_ctx_t *)ctx;
+    led_stop(led);
+    led_toggle(led);
+    return ESP_OK;
+}
+
+static esp_err_t led_blink(const char *action, const void *req, size_t req_len,
+                           void *res, size_t res_size, size_t *res_len, void *ctx) {
+    uint16_t on_ms, off_ms;
+    int16_t count;
     
-    if (strcmp(action, LED_ON) == 0) {
-        led_stop_blink(led);
-        led_set(led, 1);
-        return ESP_OK;
-    }
+    const char *params = (req && req_len > 0) ? (const char *)req : NULL;
+    parse_blink_params(params, &on_ms, &off_ms, &count);
     
-    if (strcmp(action, LED_OFF) == 0) {
-        led_stop_blink(led);
-        led_set(led, 0);
-        return ESP_OK;
-    }
+    led_start_blink((led_ctx_t *)ctx, on_ms, off_ms, count);
+    return ESP_OK;
+}
+
+static esp_err_t led_blink_bin(const char *action, const void *req, size_t req_len,
+                               void *res, size_t res_size, size_t *res_len, void *ctx) {
+    if (!req || req_len < sizeof(esp_bus_led_blink_t)) return ESP_ERR_INVALID_ARG;
     
-    if (strcmp(action, LED_TOGGLE) == 0) {
-        led_stop_blink(led);
-        led_toggle(led);
-        return ESP_OK;
-    }
+    esp_bus_led_blink_t b;
+    memcpy(&b, req, sizeof(b));  // Payload blocks are not aligned
+    led_start_blink((led_ctx_t *)ctx, b.on_ms, b.off_ms, b.count);
+    return ESP_OK;
+}
+
+static esp_err_t led_pattern(const char *action, const void *req, size_t req_len,
+                             void *res, size_t res_size, size_t *res_len, void *ctx) {
+    const size_t head = offsetof(esp_bus_led_pattern_t, steps);
+    esp_bus_led_pattern_t p;
+    if (!req || req_len < head) return ESP_ERR_INVALID_ARG;
     
-    if (strcmp(action, LED_BLINK) == 0) {
-        uint16_t on_ms, off_ms;
-        int16_t count;
-        
-        const char *params = (req && req_len > 0) ? (const char *)req : NULL;
-        parse_blink_params(params, &on_ms, &off_ms, &count);
-        
-        led_start_blink(led, on_ms, off_ms, count);
-        return ESP_OK;
+    memcpy(&p, req, head);
+    if (p.step_cnt > ESP_BUS_LED_STEPS_MAX || req_len < head + p.step_cnt * sizeof(p.steps[0])) {
+        return ESP_ERR_INVALID_ARG;
     }
-    
-    if (strcmp(action, LED_GET_STATE) == 0) {
-        if (res && res_size >= sizeof(uint8_t)) {
-            *(uint8_t *)res = led->state;
-            if (res_len) *res_len = sizeof(uint8_t);
-        }
-        return ESP_OK;
+    memcpy(p.steps, (const uint8_t *)req + head, p.step_cnt * sizeof(p.steps[0]));
+    for (uint8_t i = 0; i < p.step_cnt; i++) {
+        if (p.steps[i] == 0) return ESP_ERR_INVALID_ARG;
     }
     
-    if (strcmp(action, LED_PATTERN) == 0) {
-        // Pattern implementation could be added here
-        // Format: "t1,t2,t3,..." alternating on/off times
-        return ESP_ERR_NOT_SUPPORTED;
+    led_start((led_ctx_t *)ctx, p.steps, p.step_cnt, p.repeat);
+    return ESP_OK;
+}
+
+static esp_err_t led_get_state(const char *action, const void *req, size_t req_len,
+                               void *res, size_t res_size, size_t *res_len, void *ctx) {
+    led_ctx_t *led = (led_ctx_t *)ctx;
+    if (res && res_size >= sizeof(uint8_t)) {
+        *(uint8_t *)res = led->state;
+        if (res_len) *res_len = sizeof(uint8_t);
     }
-    
-    return ESP_ERR_NOT_SUPPORTED;
+    return ESP_OK;
 }
 
 // ============================================================================
 // Public API
 // ============================================================================
 
+static esp_err_t led_add(led_ctx_t *ctx) {
+    esp_bus_module_t mod = {
+        .name = ctx->name,
+        .ctx = ctx,
+        .actions = esp_bus_led_actions,
+        .action_cnt = esp_bus_led_action_cnt,
+    };
+    
+    esp_err_t err = esp_bus_reg(&mod);
+    if (err != ESP_OK) return err;
+    
+    ctx->next = s_leds;
+    s_leds = ctx;
+    return ESP_OK;
+}
+
 esp_err_t esp_bus_led_reg(const char *name, const esp_bus_led_cfg_t *cfg) {
     if (!name || !cfg) {
         return ESP_ERR_INVALID_ARG;
@@ -213,15 +299,7 @@ esp_err_t esp_bus_led_reg(const char *name, const esp_bus_led_cfg_t *cfg) {
     led_set(ctx, 0);
     
     // Register module
-    esp_bus_module_t mod = {
-        .name = name,
-        .on_req = led_req_handler,
-        .ctx = ctx,
-        .actions = esp_bus_led_actions,
-        .action_cnt = esp_bus_led_action_cnt,
-    };
-    
-    err = esp_bus_reg(&mod);
+    err = led_add(ctx);
     if (err != ESP_OK) {
         free(ctx);
         return err;
@@ -231,9 +309,64 @@ esp_err_t esp_bus_led_reg(const char *name, const esp_bus_led_cfg_t *cfg) {
     return ESP_OK;
 }
 
-esp_err_t esp_bus_led_unreg(const char *name) {
-    // Note: This is a simplified version
-    // Full implementation would need to track and free context
-    return esp_bus_unreg(name);
+esp_err_t esp_bus_led_group_reg(const char *name, const char *const *members, size_t cnt) {
+    if (!name || !members || cnt == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    led_ctx_t *ctx = calloc(1, sizeof(led_ctx_t) + cnt * sizeof(led_ctx_t *));
+    if (!ctx) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    strncpy(ctx->name, name, ESP_BUS_NAME_MAX - 1);
+    ctx->pin = GPIO_NUM_NC;
+    ctx->timer_id = -1;
+    for (size_t i = 0; i < cnt; i++) {
+        ctx->members[i] = members[i] ? led_find(members[i]) : NULL;
+        if (!ctx->members[i]) {
+            free(ctx);
+            return ESP_ERR_NOT_FOUND;
+        }
+    }
+    ctx->member_cnt = cnt;
+    
+    esp_err_t err = led_add(ctx);
+    if (err != ESP_OK) {
+        free(ctx);
+        return err;
+    }
+    for (size_t i = 0; i < cnt; i++) ctx->members[i]->groups++;
+    
+    ESP_LOGI(TAG, "Registered group '%s' (%u LEDs)", name, (unsigned)cnt);
+    return ESP_OK;
+}
+
+static void led_free(void *ctx) {
+    led_ctx_t *led = (led_ctx_t *)ctx;
+    esp_bus_cancel(led->timer_id);
+    free(led);
 }
 
+esp_err_t esp_bus_led_unreg(const char *name) {
+    if (!name) return ESP_ERR_INVALID_ARG;
+    
+    led_ctx_t **pp = &s_leds;
+    while (*pp && strcmp((*pp)->name, name) != 0) pp = &(*pp)->next;
+    led_ctx_t *led = *pp;
+    if (!led) return esp_bus_unreg(name);
+    if (led->groups > 0) return ESP_ERR_INVALID_STATE;
+    *pp = led->next;
+    
+    esp_err_t err = esp_bus_unreg(name);
+    
+    // Members may go as soon as this returns; pending steps skip them
+    __atomic_store_n(&led->closing, true, __ATOMIC_RELEASE);
+    for (size_t i = 0; i < led->member_cnt; i++) led->members[i]->groups--;
+    
+    // Free on the bus task, after any step already queued has run
+    if (esp_bus_after(led_free, 0, led) < 0) {
+        ESP_LOGW(TAG, "'%s' context leaked", name);
+    }
+    return err;
+}
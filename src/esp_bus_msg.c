@@ -6,79 +6,442 @@
 #include "esp_bus_priv.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 
 static const char *TAG = "esp_bus";
 
+static portMUX_TYPE s_cfl_lock = portMUX_INITIALIZER_UNLOCKED;
+static portMUX_TYPE s_ret_lock = portMUX_INITIALIZER_UNLOCKED;
+
 // ============================================================================
-// Request Processing
+// Message Payload
 // ============================================================================
 
-esp_err_t esp_bus_process_request(const char *pattern, const void *req, size_t req_len,
-                                   void *res, size_t res_size, size_t *res_len) {
-    char module_name[ESP_BUS_NAME_MAX];
-    char action[ESP_BUS_NAME_MAX];
-    char sep;
+esp_err_t esp_bus_msg_set_payload(message_t *msg, const void *data, size_t len) {
+    msg->inlined = false;
+    msg->data = NULL;
+    msg->len = 0;
+    if (!data || len == 0) return ESP_OK;
     
-    if (!esp_bus_parse_pattern(pattern, module_name, action, &sep) || sep != '.') {
-        esp_bus_report_error(pattern, ESP_ERR_INVALID_ARG, "invalid pattern");
+    if (len <= BUS_INLINE_MAX) {
+        // Small payloads travel by value inside the queue slot
+        memcpy(msg->buf, data, len);
+        msg->inlined = true;
+    } else {
+        msg->data = esp_bus_alloc(len);
+        if (!msg->data) return ESP_ERR_NO_MEM;
+        memcpy(msg->data, data, len);
+    }
+    msg->len = len;
+    return ESP_OK;
+}
+
+void esp_bus_msg_free_payload(message_t *msg) {
+    if (msg->type == MSG_BUF) {
+        esp_bus_buf_release(msg->data);
+    } else if (!msg->inlined) {
+        esp_bus_free(msg->data);
+    }
+    msg->data = NULL;
+}
+
+static void sub_put(void *p);
+
+// Dropped unprocessed at deinit: async requests complete without a callback
+void esp_bus_msg_discard(message_t *msg) {
+    if (msg->type == MSG_SUB) sub_put(((sub_evt_t *)msg->data)->sub);
+    esp_bus_msg_free_payload(msg);
+    if (msg->type == MSG_REQ && msg->reply && msg->reply->fn) esp_bus_reply_release(msg->reply);
+}
+
+// Taken off a lane and not put back: waiters fail, the loss is counted
+void esp_bus_msg_lost(message_t *msg) {
+    const char *reason = "lost, lane full";
+    
+    if (msg->type == MSG_CFL) {
+        // The topic would stay marked as queued and never send again
+        portENTER_CRITICAL_SAFE(&s_cfl_lock);
+        void *data = msg->pat->cfl_data;
+        msg->pat->cfl_data = NULL;
+        msg->pat->cfl_len = 0;
+        msg->pat->cfl_queued = false;
+        portEXIT_CRITICAL_SAFE(&s_cfl_lock);
+        esp_bus_free(data);
+    }
+    
+    if (msg->pat) {
+        esp_bus_count_drop(msg->pat, reason);
+    } else {
+        __atomic_add_fetch(&g_bus.drops, 1, __ATOMIC_RELAXED);
+        const char *pattern = msg->type == MSG_MULTI ? ((multi_job_t *)msg->data)->pattern : "";
+        esp_bus_report_error(pattern, ESP_ERR_TIMEOUT, reason);
+    }
+    
+    if (msg->reply) {
+        esp_bus_reply_finish(msg->reply, ESP_ERR_TIMEOUT, NULL, 0, 0);
+        esp_bus_msg_free_payload(msg);
+    } else {
+        esp_bus_msg_discard(msg);
+    }
+}
+
+// ============================================================================
+// Request Processing
+// ============================================================================
+
+// Handler of the bound action, else on_req. Raced by a rebind, the index
+// may belong to another module; re-reading pat->mod after it catches that
+// (an old module stays allocated, so its address is not reused).
+static esp_bus_req_fn action_fn(const pat_node_t *pat, const esp_bus_module_t *mod) {
+    int16_t i = __atomic_load_n(&pat->index, __ATOMIC_ACQUIRE);
+    if (i >= 0 && mod->actions[i].handler &&
+        __atomic_load_n(&pat->mod, __ATOMIC_ACQUIRE) == mod) {
+        return mod->actions[i].handler;
+    }
+    return mod->on_req;
+}
+
+esp_err_t esp_bus_process_request(const pat_node_t *pat, const void *req, size_t req_len,
+                                   void *res, size_t res_size, size_t *res_len,
+                                   esp_bus_buf_t **res_buf) {
+    if (res_buf) *res_buf = NULL;
+    if (pat->sep != '.') {
+        esp_bus_report_error(pat->pattern, ESP_ERR_INVALID_ARG, "invalid pattern");
         return ESP_ERR_INVALID_ARG;
     }
     
-    module_node_t *mod = esp_bus_find_module(module_name);
+    // Nested requests served on this task keep their own response buffer
+    int idx = esp_bus_worker_index();
+    res_slot_t *slot = idx >= 0 ? &g_bus.res_slots[idx] : NULL;
+    res_slot_t outer = { 0 };
+    if (slot) {
+        outer = *slot;
+        slot->wanted = (res_buf != NULL);
+        slot->buf = NULL;
+    }
+    
+    // Held rather than read-locked across the handler, which may block
+    BUS_CLOCK_START(t);
+    uint32_t rcu = esp_bus_rcu_lock();
+    esp_err_t err = ESP_OK;
+    const esp_bus_module_t *mod = __atomic_load_n(&pat->mod, __ATOMIC_ACQUIRE);
+    esp_bus_req_fn fn = mod ? action_fn(pat, mod) : NULL;
+    if (fn) esp_bus_module_hold(mod);
+    esp_bus_rcu_unlock(rcu);
+    
     if (!mod) {
         if (g_bus.strict) {
-            esp_bus_report_error(pattern, ESP_ERR_NOT_FOUND, "module not found");
-            return ESP_ERR_NOT_FOUND;
+            esp_bus_report_error(pat->pattern, ESP_ERR_NOT_FOUND, "module not found");
+            err = ESP_ERR_NOT_FOUND;
         }
-        return ESP_OK;
+    } else if (!fn) {
+        esp_bus_report_error(pat->pattern, ESP_ERR_NOT_SUPPORTED, "no handler");
+        err = ESP_ERR_NOT_SUPPORTED;
+    } else {
+        ESP_LOGD(TAG, "REQ %s", pat->pattern);
+        err = fn(pat->name, req, req_len, res, res_size, res_len, mod->ctx);
+        BUS_PROF_EXEC(pat, t);
+        esp_bus_module_release(mod);
     }
+    BUS_TRACE(pat, ESP_BUS_TRACE_REQ, req_len, t, err);
     
-    if (!mod->on_req) {
-        esp_bus_report_error(pattern, ESP_ERR_NOT_SUPPORTED, "no handler");
-        return ESP_ERR_NOT_SUPPORTED;
+    if (slot) {
+        if (res_buf) *res_buf = slot->buf;
+        *slot = outer;
     }
-    
-    ESP_LOGD(TAG, "REQ %s", pattern);
-    return mod->on_req(action, req, req_len, res, res_size, res_len, mod->ctx);
+    return err;
 }
 
 // ============================================================================
 // Event Processing
 // ============================================================================
 
-void esp_bus_dispatch_event(const char *src, const char *evt, const void *data, size_t len) {
-    char full[ESP_BUS_PATTERN_MAX];
-    snprintf(full, sizeof(full), "%s:%s", src, evt);
+// Bus task only: readers on other tasks copy under s_ret_lock
+static void retain_update(pat_node_t *pat, const void *data, size_t len) {
+    bool keep = __atomic_load_n(&pat->retain, __ATOMIC_RELAXED);
+    void *copy = NULL;
+    if (keep && data && len) {
+        copy = esp_bus_alloc(len);
+        if (!copy) {
+            esp_bus_report_error(pat->pattern, ESP_ERR_NO_MEM, "retained value lost");
+            keep = false;
+        } else {
+            memcpy(copy, data, len);
+        }
+    }
+    if (!keep) len = 0;
+    
+    portENTER_CRITICAL_SAFE(&s_ret_lock);
+    void *old = pat->ret_data;
+    pat->ret_data = copy;
+    pat->ret_len = len;
+    pat->ret_valid = keep;
+    portEXIT_CRITICAL_SAFE(&s_ret_lock);
+    esp_bus_free(old);
+}
+
+void esp_bus_dispatch_event(const pat_node_t *pat, const void *data, size_t len) {
+    ESP_LOGD(TAG, "EVT %s", pat->pattern);
+    
+    if (pat->retain || pat->ret_valid) retain_update((pat_node_t *)pat, data, len);
     
-    ESP_LOGD(TAG, "EVT %s", full);
+    // Subscribers and routes, via the subscription index
+    uint32_t rcu = esp_bus_rcu_lock();
+    BUS_CLOCK_START(t);
+    const pat_node_t *outer = g_bus.cur_pat;
+    g_bus.cur_pat = pat;
+    esp_bus_idx_dispatch(pat, data, len);
+    g_bus.cur_pat = outer;
+    BUS_PROF_EXEC(pat, t);
+    esp_bus_rcu_unlock(rcu);
+    BUS_TRACE(pat, ESP_BUS_TRACE_EVT, len, t, ESP_OK);
+}
+
+const char *esp_bus_cur_pattern(void) {
+    if (xTaskGetCurrentTaskHandle() != g_bus.task) return NULL;
+    return g_bus.cur_pat ? g_bus.cur_pat->pattern : NULL;
+}
+
+void esp_bus_dispatch_batch(const void *batch, size_t n) {
+    const batch_ent_t *ent = batch;
+    for (size_t i = 0; i < n; i++) {
+        const void *data = ent[i].len ? (const uint8_t *)batch + ent[i].off : NULL;
+        esp_bus_dispatch_event(ent[i].pat, data, ent[i].len);
+    }
+}
+
+// Takes the latest payload; an emit from here on queues a fresh message
+void esp_bus_dispatch_conflated(pat_node_t *pat) {
+    portENTER_CRITICAL_SAFE(&s_cfl_lock);
+    void *data = pat->cfl_data;
+    size_t len = pat->cfl_len;
+    pat->cfl_data = NULL;
+    pat->cfl_len = 0;
+    pat->cfl_queued = false;
+    portEXIT_CRITICAL_SAFE(&s_cfl_lock);
     
-    // Dispatch to subscribers
-    sub_node_t *sub;
-    SLIST_FOREACH(sub, &g_bus.subs, next) {
-        if (esp_bus_match_pattern(sub->pattern, full)) {
-            sub->handler(evt, data, len, sub->ctx);
+    esp_bus_dispatch_event(pat, data, len);
+    esp_bus_free(data);
+}
+
+// Late subscriber: current values of the retained topics it matches
+void esp_bus_replay_retained(int sub_id) {
+    xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
+    sub_node_t *node;
+    SLIST_FOREACH(node, &g_bus.subs, next) {
+        if (node->id == sub_id) break;
+    }
+    // Unsubscribing meanwhile must not free it under the handler
+    if (node) __atomic_add_fetch(&node->refs, 1, __ATOMIC_RELAXED);
+    xSemaphoreGive(g_bus.mutex);
+    if (!node) return;      // Unsubscribed meanwhile
+    
+    // ret_* only change on this task, so no lock is needed to read them here.
+    // Budgeted and offloaded subscribers get the replay the way they get
+    // live events.
+    for (size_t b = 0; b < ESP_BUS_PAT_BUCKETS; b++) {
+        for (pat_node_t *p = __atomic_load_n(&g_bus.pats[b], __ATOMIC_ACQUIRE); p; p = p->next) {
+            if (__atomic_load_n(&node->gone, __ATOMIC_ACQUIRE)) break;
+            if (!p->ret_valid || !p->retain || !esp_bus_match_pattern(node->pattern, p->pattern)) continue;
+            
+            const void *data = p->ret_len ? p->ret_data : NULL;
+            g_bus.cur_pat = p;
+            if (node->worker || node->budget_us) {
+                esp_bus_sub_deliver(node, p, data, p->ret_len);
+            } else {
+                node->handler(p->name, data, p->ret_len, node->ctx);
+            }
+            g_bus.cur_pat = NULL;
         }
     }
+    sub_put(node);
+}
+
+// Routed requests run on the task serving the target module
+static void route_request(pat_node_t *pat, const void *data, size_t len) {
+    QueueHandle_t queue = esp_bus_worker_queue(pat);
+    if (!queue || pat->sep != '.') {
+        esp_bus_process_request(pat, data, len, NULL, 0, NULL, NULL);
+        return;
+    }
     
-    // Process routes
-    route_node_t *r;
-    SLIST_FOREACH(r, &g_bus.routes, next) {
-        if (!esp_bus_match_pattern(r->evt_pattern, full)) continue;
-        
-        if (r->transform) {
-            const char *out_req = NULL;
-            void *out_data = NULL;
-            size_t out_len = 0;
-            r->transform(evt, data, len, &out_req, &out_data, &out_len, r->ctx);
-            if (out_req) {
-                ESP_LOGD(TAG, "ROUTE %s -> %s", full, out_req);
-                esp_bus_process_request(out_req, out_data, out_len, NULL, 0, NULL);
+    message_t msg = { .type = MSG_REQ, .pat = pat };
+    if (esp_bus_msg_set_payload(&msg, data, len) != ESP_OK) {
+        esp_bus_report_error(pat->pattern, ESP_ERR_NO_MEM, "no memory");
+        return;
+    }
+    BUS_PROF_STAMP(&msg);
+    if (xQueueSend(queue, &msg, 0) != pdTRUE) {
+        esp_bus_msg_free_payload(&msg);
+        esp_bus_report_error(pat->pattern, ESP_ERR_TIMEOUT, "worker queue full");
+    }
+}
+
+// Index listener of a route
+static void route_handler(const char *evt, const void *data, size_t len, void *ctx) {
+    route_node_t *r = (route_node_t *)ctx;
+    
+    if (r->transform_h) {
+        esp_bus_handle_t target = NULL;
+        void *out_data = NULL;
+        size_t out_len = 0;
+        r->transform_h(evt, data, len, &target, &out_data, &out_len, r->ctx);
+        if (target) {
+            ESP_LOGD(TAG, "ROUTE %s -> %s", r->listener.pattern, target->pattern);
+            route_request(target, out_data, out_len);
+        }
+    } else if (r->transform) {
+        const char *out_req = NULL;
+        void *out_data = NULL;
+        size_t out_len = 0;
+        r->transform(evt, data, len, &out_req, &out_data, &out_len, r->ctx);
+        if (out_req) {
+            ESP_LOGD(TAG, "ROUTE %s -> %s", r->listener.pattern, out_req);
+            pat_node_t *target = esp_bus_pat_get(out_req);
+            if (!target) {
+                esp_bus_report_error(out_req, ESP_ERR_INVALID_ARG, "invalid pattern");
+                return;
             }
-        } else {
-            ESP_LOGD(TAG, "ROUTE %s -> %s", full, r->req_pattern);
-            esp_bus_process_request(r->req_pattern, r->req_data, r->req_len, NULL, 0, NULL);
+            route_request(target, out_data, out_len);
+        }
+    } else {
+        ESP_LOGD(TAG, "ROUTE %s -> %s", r->listener.pattern, r->req_pat->pattern);
+        route_request(r->req_pat, r->req_data, r->req_len);
+    }
+}
+
+// ============================================================================
+// Request Fan-out
+// ============================================================================
+
+static void multi_finish(multi_job_t *job) {
+    // Compact the entries in place into the public result array
+    esp_bus_target_res_t *out = (esp_bus_target_res_t *)job->ent;
+    size_t n = job->cnt < job->max ? job->cnt : job->max;
+    for (size_t i = 0; i < n; i++) {
+        memmove(&out[i], &job->ent[i].res, sizeof(out[i]));
+    }
+    
+    esp_err_t err = job->cnt ? job->first_err : ESP_ERR_NOT_FOUND;
+    if (job->reply) esp_bus_reply_finish(job->reply, err, out, n * sizeof(out[0]), job->cnt);
+    esp_bus_free(job);
+}
+
+// Any serving task; the last target to finish completes the job
+static void multi_put(multi_job_t *job, esp_err_t err) {
+    if (err != ESP_OK) {
+        esp_err_t ok = ESP_OK;
+        __atomic_compare_exchange_n(&job->first_err, &ok, err, false,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+    if (__atomic_sub_fetch(&job->pending, 1, __ATOMIC_ACQ_REL) == 0) multi_finish(job);
+}
+
+static void multi_done(esp_err_t err, const void *res, size_t res_len, void *ctx) {
+    multi_ent_t *e = (multi_ent_t *)ctx;
+    if (e != &e->job->sink) e->res.err = err;
+    multi_put(e->job, err);
+}
+
+// A target the fanning-out task serves itself, run once the read section ends
+typedef struct {
+    pat_node_t *pat;
+    multi_ent_t *e;
+} multi_inline_t;
+
+static void multi_target(multi_job_t *job, const esp_bus_module_t *mod, const char *action,
+                         multi_inline_t *inl, size_t *inl_cnt) {
+    // A schema that lacks the action means the module is not a target
+    if (mod->actions) {
+        size_t i = 0;
+        while (i < mod->action_cnt && strcmp(mod->actions[i].name, action) != 0) i++;
+        if (i == mod->action_cnt) return;
+    }
+    
+    multi_ent_t *e = job->cnt < job->max ? &job->ent[job->cnt] : &job->sink;
+    if (e != &job->sink) strncpy(e->res.module, mod->name, ESP_BUS_NAME_MAX - 1);
+    e->job = job;
+    job->cnt++;
+    __atomic_add_fetch(&job->pending, 1, __ATOMIC_RELAXED);
+    
+    char target[ESP_BUS_PATTERN_MAX];
+    pat_node_t *pat = NULL;
+    if (snprintf(target, sizeof(target), "%s.%s", mod->name, action) < (int)sizeof(target)) {
+        pat = esp_bus_pat_get(target);
+    }
+    if (!pat) {
+        multi_done(ESP_ERR_INVALID_ARG, NULL, 0, e);
+        return;
+    }
+    
+    // Targets on the fanning-out task run on it: it cannot serve its queue
+    // while the caller waits for the result
+    const uint8_t *req = (const uint8_t *)&job->ent[job->max];
+    QueueHandle_t queue = esp_bus_worker_queue(pat);
+    if (esp_bus_worker_self(queue)) {
+        if (!inl) {
+            multi_done(ESP_ERR_NO_MEM, NULL, 0, e);
+            return;
+        }
+        inl[(*inl_cnt)++] = (multi_inline_t){ .pat = pat, .e = e };
+        return;
+    }
+    
+    // Served in order with the module's other requests on its task
+    message_t msg = { .type = MSG_REQ, .pat = pat, .reply = esp_bus_reply_async(0, multi_done, e) };
+    if (!msg.reply || esp_bus_msg_set_payload(&msg, req, job->req_len) != ESP_OK) {
+        if (msg.reply) esp_bus_reply_release(msg.reply);
+        multi_done(ESP_ERR_NO_MEM, NULL, 0, e);
+        return;
+    }
+    BUS_PROF_STAMP(&msg);
+    bool sent = queue ? xQueueSend(queue, &msg, 0) == pdTRUE : esp_bus_post(pat->prio, &msg, 0);
+    if (!sent) {
+        esp_bus_msg_free_payload(&msg);
+        esp_bus_reply_release(msg.reply);
+        esp_bus_report_error(pat->pattern, ESP_ERR_TIMEOUT, queue ? "worker queue full" : "queue full");
+        multi_done(ESP_ERR_TIMEOUT, NULL, 0, e);
+    }
+}
+
+// Bus task or a worker calling esp_bus_req_all(): one request per matching
+// module, static table first
+void esp_bus_multi_run(multi_job_t *job) {
+    char *dot = strchr(job->pattern, '.');
+    *dot = '\0';
+    const char *glob = job->pattern;
+    const char *action = dot + 1;
+    
+    uint32_t rcu = esp_bus_rcu_lock();
+    const esp_bus_module_t *mods;
+    size_t n = esp_bus_static_modules(&mods);
+    module_table_t *t = __atomic_load_n(&g_bus.modules, __ATOMIC_ACQUIRE);
+    size_t cap = n + (t ? t->cnt : 0);
+    multi_inline_t *inl = cap ? malloc(cap * sizeof(*inl)) : NULL;
+    size_t inl_cnt = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (esp_bus_match_pattern(glob, mods[i].name)) {
+            multi_target(job, &mods[i], action, inl, &inl_cnt);
+        }
+    }
+    for (size_t i = 0; t && i < t->cnt; i++) {
+        if (esp_bus_match_pattern(glob, t->mods[i]->name)) {
+            multi_target(job, &t->mods[i]->desc, action, inl, &inl_cnt);
         }
     }
+    esp_bus_rcu_unlock(rcu);
+    
+    // Handlers may block, so they run outside the read section; the request
+    // pins the module itself
+    const uint8_t *req = (const uint8_t *)&job->ent[job->max];
+    for (size_t i = 0; i < inl_cnt; i++) {
+        esp_err_t err = esp_bus_process_request(inl[i].pat, req, job->req_len, NULL, 0, NULL, NULL);
+        multi_done(err, NULL, 0, inl[i].e);
+    }
+    free(inl);
+    
+    // Drop the fan-out reference; completes now unless a worker still runs
+    multi_put(job, ESP_OK);
 }
 
 // ============================================================================
@@ -90,51 +453,192 @@ esp_err_t esp_bus_req(const char *pattern, const void *req, size_t req_len,
                        uint32_t timeout_ms) {
     if (!g_bus.initialized || !pattern) return ESP_ERR_INVALID_ARG;
     
-    // If called from bus_task context (e.g. from service callback), 
-    // process directly to avoid deadlock
-    if (xTaskGetCurrentTaskHandle() == g_bus.task) {
-        return esp_bus_process_request(pattern, req, req_len, res, res_size, res_len);
+    pat_node_t *pat = esp_bus_pat_get(pattern);
+    if (!pat) {
+        esp_bus_report_error(pattern, ESP_ERR_INVALID_ARG, "invalid pattern");
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    return esp_bus_req_h(pat, req, req_len, res, res_size, res_len, timeout_ms);
+}
+
+esp_err_t esp_bus_req_all(const char *pattern, const void *req, size_t req_len,
+                          esp_bus_target_res_t *res, size_t max, size_t *cnt,
+                          uint32_t timeout_ms) {
+    if (!g_bus.initialized || !pattern || (max && !res)) return ESP_ERR_INVALID_ARG;
+    
+    const char *dot = strchr(pattern, '.');
+    size_t len = strlen(pattern);
+    if (!dot || dot == pattern || strchr(dot + 1, '*') || len >= ESP_BUS_PATTERN_MAX) {
+        esp_bus_report_error(pattern, ESP_ERR_INVALID_ARG, "invalid pattern");
+        return ESP_ERR_INVALID_ARG;
     }
     
-    message_t msg = {
-        .type = MSG_REQ,
-        .res_buf = res,
-        .res_size = res_size,
-        .res_len = res_len,
-    };
+    // Results only go to a caller that waits for them
+    if (timeout_ms == 0) max = 0;
+    if (max > UINT16_MAX) max = UINT16_MAX;
+    size_t head = sizeof(multi_job_t) + max * sizeof(multi_ent_t);
+    multi_job_t *job = esp_bus_alloc(head + req_len);
+    if (!job) return ESP_ERR_NO_MEM;
     
-    strncpy(msg.pattern, pattern, ESP_BUS_PATTERN_MAX - 1);
+    memset(job, 0, head);
+    memcpy(job->pattern, pattern, len + 1);
+    job->max = (uint16_t)max;
+    job->req_len = req && req_len ? req_len : 0;
+    if (job->req_len) memcpy((uint8_t *)job + head, req, req_len);
+    job->pending = 1;
     
-    if (req && req_len > 0) {
-        msg.data = malloc(req_len);
-        if (!msg.data) return ESP_ERR_NO_MEM;
-        memcpy(msg.data, req, req_len);
-        msg.len = req_len;
+    if (timeout_ms > 0) {
+        job->reply = esp_bus_reply_get(res, max * sizeof(res[0]), cnt);
+        if (!job->reply) {
+            esp_bus_free(job);
+            esp_bus_report_error(pattern, ESP_ERR_NO_MEM, "no reply slot");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    msg_reply_t *reply = job->reply;
+    TickType_t ticks = pdMS_TO_TICKS(timeout_ms);
+    
+    // A serving task fans out itself, so targets it serves are not stuck
+    // in its own queue behind the wait
+    if (esp_bus_worker_index() >= 0) {
+        esp_bus_multi_run(job);
+    } else {
+        message_t msg = { .type = MSG_MULTI, .data = job, .reply = reply };
+        if (!esp_bus_post(ESP_BUS_PRIO_NORMAL, &msg, ticks)) {
+            esp_bus_free(job);
+            if (reply) esp_bus_reply_release(reply);
+            return ESP_ERR_TIMEOUT;
+        }
     }
     
-    esp_err_t result = ESP_OK;
-    SemaphoreHandle_t done = NULL;
+    return reply ? esp_bus_reply_wait(reply, ticks) : ESP_OK;
+}
+
+// Blocking request; out set: the response comes back as a bus buffer
+static esp_err_t send_request(esp_bus_handle_t h, const void *req, size_t req_len,
+                              void *res, size_t res_size, size_t *res_len,
+                              esp_bus_buf_t **out, uint32_t timeout_ms) {
+    uint32_t rcu = esp_bus_rcu_lock();
+    QueueHandle_t queue = esp_bus_worker_queue(h);
+    esp_bus_rcu_unlock(rcu);
+    
+    // If called from the task serving the module (e.g. from service callback),
+    // process directly to avoid deadlock
+    if (esp_bus_worker_self(queue)) {
+        esp_bus_buf_t *buf = NULL;
+        esp_err_t err = esp_bus_process_request(h, req, req_len, res, res_size, res_len, &buf);
+        if (out) {
+            *out = buf;
+        } else if (buf) {
+            if (res) memcpy(res, buf->data, buf->len < res_size ? buf->len : res_size);
+            if (res_len) *res_len = buf->len;
+            esp_bus_buf_release(buf);
+        }
+        return err;
+    }
+    
+    message_t msg = { .type = MSG_REQ, .pat = h };
+    if (esp_bus_msg_set_payload(&msg, req, req_len) != ESP_OK) return ESP_ERR_NO_MEM;
     
     if (timeout_ms > 0) {
-        done = xSemaphoreCreateBinary();
-        msg.done = done;
-        msg.result = &result;
+        msg.reply = esp_bus_reply_get(res, res_size, res_len);
+        if (!msg.reply) {
+            esp_bus_msg_free_payload(&msg);
+            esp_bus_report_error(h->pattern, ESP_ERR_NO_MEM, "no reply slot");
+            return ESP_ERR_NO_MEM;
+        }
+        msg.reply->out = out;
     }
     
-    if (xQueueSend(g_bus.queue, &msg, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
-        if (msg.data) free(msg.data);
-        if (done) vSemaphoreDelete(done);
+    TickType_t ticks = pdMS_TO_TICKS(timeout_ms);
+    BUS_PROF_STAMP(&msg);
+    bool sent = queue ? xQueueSend(queue, &msg, ticks) == pdTRUE : esp_bus_post(h->prio, &msg, ticks);
+    if (!sent) {
+        esp_bus_msg_free_payload(&msg);
+        if (msg.reply) esp_bus_reply_release(msg.reply);
         return ESP_ERR_TIMEOUT;
     }
     
-    if (done) {
-        if (xSemaphoreTake(done, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
-            result = ESP_ERR_TIMEOUT;
-        }
-        vSemaphoreDelete(done);
+    return msg.reply ? esp_bus_reply_wait(msg.reply, ticks) : ESP_OK;
+}
+
+esp_err_t esp_bus_req_h(esp_bus_handle_t h, const void *req, size_t req_len,
+                         void *res, size_t res_size, size_t *res_len,
+                         uint32_t timeout_ms) {
+    if (!g_bus.initialized || !h || h->sep != '.') return ESP_ERR_INVALID_ARG;
+    
+    return send_request(h, req, req_len, res, res_size, res_len, NULL, timeout_ms);
+}
+
+esp_err_t esp_bus_req_buf(const char *pattern, const void *req, size_t req_len,
+                          esp_bus_buf_t **res, uint32_t timeout_ms) {
+    if (!g_bus.initialized || !pattern) return ESP_ERR_INVALID_ARG;
+    
+    pat_node_t *pat = esp_bus_pat_get(pattern);
+    if (!pat) {
+        esp_bus_report_error(pattern, ESP_ERR_INVALID_ARG, "invalid pattern");
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    return esp_bus_req_buf_h(pat, req, req_len, res, timeout_ms);
+}
+
+esp_err_t esp_bus_req_buf_h(esp_bus_handle_t h, const void *req, size_t req_len,
+                            esp_bus_buf_t **res, uint32_t timeout_ms) {
+    if (!g_bus.initialized || !h || h->sep != '.' || !res || timeout_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    *res = NULL;
+    return send_request(h, req, req_len, NULL, 0, NULL, res, timeout_ms);
+}
+
+esp_err_t esp_bus_req_async(const char *pattern, const void *req, size_t req_len,
+                            size_t res_size, esp_bus_done_fn done, void *ctx) {
+    if (!g_bus.initialized || !pattern) return ESP_ERR_INVALID_ARG;
+    
+    pat_node_t *pat = esp_bus_pat_get(pattern);
+    if (!pat) {
+        esp_bus_report_error(pattern, ESP_ERR_INVALID_ARG, "invalid pattern");
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    return esp_bus_req_async_h(pat, req, req_len, res_size, done, ctx);
+}
+
+esp_err_t esp_bus_req_async_h(esp_bus_handle_t h, const void *req, size_t req_len,
+                              size_t res_size, esp_bus_done_fn done, void *ctx) {
+    if (!g_bus.initialized || !h || h->sep != '.' || !done) return ESP_ERR_INVALID_ARG;
+    
+    msg_reply_t *reply = esp_bus_reply_async(res_size, done, ctx);
+    if (!reply) return ESP_ERR_NO_MEM;
+    
+    uint32_t rcu = esp_bus_rcu_lock();
+    QueueHandle_t queue = esp_bus_worker_queue(h);
+    esp_bus_rcu_unlock(rcu);
+    
+    // Served right here: the callback runs before we return
+    if (esp_bus_worker_self(queue)) {
+        esp_bus_reply_serve(h, req, req_len, reply);
+        return ESP_OK;
     }
     
-    return result;
+    message_t msg = { .type = MSG_REQ, .pat = h, .reply = reply };
+    if (esp_bus_msg_set_payload(&msg, req, req_len) != ESP_OK) {
+        esp_bus_reply_release(reply);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    BUS_PROF_STAMP(&msg);
+    bool sent = queue ? xQueueSend(queue, &msg, 0) == pdTRUE : esp_bus_post(h->prio, &msg, 0);
+    if (!sent) {
+        esp_bus_msg_free_payload(&msg);
+        esp_bus_reply_release(reply);
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    return ESP_OK;
 }
 
 // ============================================================================
@@ -144,24 +648,183 @@ esp_err_t esp_bus_req(const char *pattern, const void *req, size_t req_len,
 esp_err_t esp_bus_emit(const char *src, const char *evt, const void *data, size_t len) {
     if (!g_bus.initialized || !src || !evt) return ESP_ERR_INVALID_ARG;
     
-    message_t msg = { .type = MSG_EVT };
-    snprintf(msg.pattern, ESP_BUS_PATTERN_MAX, "%s:%s", src, evt);
+    char full[ESP_BUS_PATTERN_MAX];
+    int n = snprintf(full, sizeof(full), "%s:%s", src, evt);
+    if (n < 0 || n >= (int)sizeof(full)) return ESP_ERR_INVALID_ARG;
+    
+    pat_node_t *pat = esp_bus_pat_get(full);
+    if (!pat) return ESP_ERR_INVALID_ARG;
+    
+    return esp_bus_emit_h(pat, data, len);
+}
+
+void esp_bus_count_drop(pat_node_t *pat, const char *msg) {
+    __atomic_add_fetch(&g_bus.drops, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&pat->drops, 1, __ATOMIC_RELAXED);
+    BUS_TRACE(pat, ESP_BUS_TRACE_DROP, 0, esp_bus_now_us(), ESP_ERR_TIMEOUT);
+    esp_bus_report_error(pat->pattern, ESP_ERR_TIMEOUT, msg);
+}
+
+// Queues an event under its pattern's overflow policy; the caller still
+// owns the payload on failure
+static esp_err_t post_event(pat_node_t *pat, message_t *msg) {
+    uint8_t policy = __atomic_load_n(&pat->overflow, __ATOMIC_RELAXED);
+    
+    // The bus task must not wait on its own lanes
+    if (xTaskGetCurrentTaskHandle() == g_bus.task) policy = ESP_BUS_OVERFLOW_DROP_NEWEST;
+    
+    TickType_t ticks = 0;
+    if (policy == ESP_BUS_OVERFLOW_BLOCK) ticks = pdMS_TO_TICKS(pat->block_ms);
+    if (esp_bus_post(pat->prio, msg, ticks)) return ESP_OK;
+    
+    if (policy == ESP_BUS_OVERFLOW_DROP_OLDEST && esp_bus_evict(pat->prio) &&
+        esp_bus_post(pat->prio, msg, 0)) {
+        return ESP_OK;
+    }
+    
+    esp_bus_count_drop(pat, "dropped, lane full");
+    return ESP_ERR_TIMEOUT;
+}
+
+// Replaces the payload of a pending message instead of queueing another
+static esp_err_t emit_conflated(pat_node_t *pat, const void *data, size_t len) {
+    void *copy = NULL;
+    if (data && len) {
+        copy = esp_bus_alloc(len);
+        if (!copy) return ESP_ERR_NO_MEM;
+        memcpy(copy, data, len);
+    } else {
+        len = 0;
+    }
+    
+    portENTER_CRITICAL_SAFE(&s_cfl_lock);
+    void *old = pat->cfl_data;
+    pat->cfl_data = copy;
+    pat->cfl_len = len;
+    bool queued = pat->cfl_queued;
+    pat->cfl_queued = true;
+    portEXIT_CRITICAL_SAFE(&s_cfl_lock);
+    
+    esp_bus_free(old);
+    if (queued) return ESP_OK;
+    
+    message_t msg = { .type = MSG_CFL, .pat = pat };
+    if (post_event(pat, &msg) != ESP_OK) {
+        // The value stays stored and goes out with the next emit
+        portENTER_CRITICAL_SAFE(&s_cfl_lock);
+        pat->cfl_queued = false;
+        portEXIT_CRITICAL_SAFE(&s_cfl_lock);
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_bus_emit_h(esp_bus_handle_t h, const void *data, size_t len) {
+    if (!g_bus.initialized || !h || h->sep != ':') return ESP_ERR_INVALID_ARG;
+    
+    if (__atomic_load_n(&h->conflate, __ATOMIC_RELAXED)) return emit_conflated(h, data, len);
     
-    if (data && len > 0) {
-        msg.data = malloc(len);
-        if (!msg.data) return ESP_ERR_NO_MEM;
-        memcpy(msg.data, data, len);
-        msg.len = len;
+    message_t msg = { .type = MSG_EVT, .pat = h };
+    if (esp_bus_msg_set_payload(&msg, data, len) != ESP_OK) return ESP_ERR_NO_MEM;
+    
+    esp_err_t err = post_event(h, &msg);
+    if (err != ESP_OK) esp_bus_msg_free_payload(&msg);
+    return err;
+}
+
+esp_err_t esp_bus_emit_buf(const char *src, const char *evt, esp_bus_buf_t *buf) {
+    if (!g_bus.initialized || !src || !evt || !buf) return ESP_ERR_INVALID_ARG;
+    
+    char full[ESP_BUS_PATTERN_MAX];
+    int n = snprintf(full, sizeof(full), "%s:%s", src, evt);
+    if (n < 0 || n >= (int)sizeof(full)) return ESP_ERR_INVALID_ARG;
+    
+    pat_node_t *pat = esp_bus_pat_get(full);
+    if (!pat) return ESP_ERR_INVALID_ARG;
+    
+    return esp_bus_emit_buf_h(pat, buf);
+}
+
+esp_err_t esp_bus_emit_buf_h(esp_bus_handle_t h, esp_bus_buf_t *buf) {
+    if (!g_bus.initialized || !h || h->sep != ':' || !buf) return ESP_ERR_INVALID_ARG;
+    if (buf->len > buf->size) return ESP_ERR_INVALID_SIZE;
+    
+    // The queue slot holds the caller's reference until dispatch is done
+    message_t msg = { .type = MSG_BUF, .pat = h, .data = buf, .len = buf->len };
+    return post_event(h, &msg);
+}
+
+#define BATCH_ALIGN(x)  (((x) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+esp_err_t esp_bus_emit_batch(const esp_bus_evt_batch_t *evts, size_t n) {
+    if (!g_bus.initialized || !evts || n == 0) return ESP_ERR_INVALID_ARG;
+    
+    size_t off = BATCH_ALIGN(n * sizeof(batch_ent_t));
+    size_t total = off;
+    for (size_t i = 0; i < n; i++) {
+        if (evts[i].data) total += BATCH_ALIGN(evts[i].len);
+    }
+    
+    uint8_t *buf = esp_bus_alloc(total);
+    if (!buf) return ESP_ERR_NO_MEM;
+    
+    batch_ent_t *ent = (batch_ent_t *)buf;
+    uint8_t prio = ESP_BUS_PRIO_LOW;
+    for (size_t i = 0; i < n; i++) {
+        pat_node_t *pat = evts[i].h;
+        if (!pat && evts[i].src && evts[i].evt) {
+            char full[ESP_BUS_PATTERN_MAX];
+            int len = snprintf(full, sizeof(full), "%s:%s", evts[i].src, evts[i].evt);
+            if (len > 0 && len < (int)sizeof(full)) pat = esp_bus_pat_get(full);
+        }
+        if (!pat || pat->sep != ':') {
+            // A bad entry rejects the whole batch
+            esp_bus_free(buf);
+            return ESP_ERR_INVALID_ARG;
+        }
+        
+        // The batch travels in the lane of its most urgent entry
+        if (pat->prio < prio) prio = pat->prio;
+        
+        size_t len = evts[i].data ? evts[i].len : 0;
+        ent[i].pat = pat;
+        ent[i].off = off;
+        ent[i].len = len;
+        if (len) {
+            memcpy(buf + off, evts[i].data, len);
+            off += BATCH_ALIGN(len);
+        }
     }
     
-    if (xQueueSend(g_bus.queue, &msg, 0) != pdTRUE) {
-        if (msg.data) free(msg.data);
+    message_t msg = { .type = MSG_BATCH, .data = buf, .len = n };
+    if (!esp_bus_post(prio, &msg, 0)) {
+        esp_bus_count_drop(ent[0].pat, "batch dropped, lane full");
+        esp_bus_free(buf);
         return ESP_ERR_TIMEOUT;
     }
     
     return ESP_OK;
 }
 
+esp_err_t esp_bus_get_retained(const char *pattern, void *buf, size_t size, size_t *len) {
+    if (!g_bus.initialized || !pattern || (size && !buf)) return ESP_ERR_INVALID_ARG;
+    
+    // Never interns: a topic nobody emitted has nothing retained
+    pat_node_t *pat = esp_bus_pat_find(pattern);
+    if (!pat || !pat->retain) return ESP_ERR_NOT_FOUND;
+    
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    portENTER_CRITICAL_SAFE(&s_ret_lock);
+    if (pat->ret_valid) {
+        size_t n = pat->ret_len < size ? pat->ret_len : size;
+        if (n) memcpy(buf, pat->ret_data, n);
+        if (len) *len = pat->ret_len;
+        err = ESP_OK;
+    }
+    portEXIT_CRITICAL_SAFE(&s_ret_lock);
+    return err;
+}
+
 int esp_bus_sub(const char *pattern, esp_bus_evt_fn handler, void *ctx) {
     if (!g_bus.initialized || !pattern || !handler) return -1;
     
@@ -173,14 +836,29 @@ int esp_bus_sub(const char *pattern, esp_bus_evt_fn handler, void *ctx) {
         return -1;
     }
     
-    node->id = g_bus.next_sub_id++;
     strncpy(node->pattern, pattern, ESP_BUS_PATTERN_MAX - 1);
     node->handler = handler;
     node->ctx = ctx;
+    node->refs = 1;
     
+    if (esp_bus_idx_add(node) != ESP_OK) {
+        xSemaphoreGive(g_bus.mutex);
+        free(node);
+        return -1;
+    }
+    
+    node->id = g_bus.next_sub_id++;
     SLIST_INSERT_HEAD(&g_bus.subs, node, next);
     xSemaphoreGive(g_bus.mutex);
     
+    // Retained values reach the subscriber on the bus task, like any event
+    if (__atomic_load_n(&g_bus.retained_cnt, __ATOMIC_RELAXED)) {
+        message_t msg = { .type = MSG_RETAINED, .len = (size_t)node->id };
+        if (!esp_bus_post(ESP_BUS_PRIO_NORMAL, &msg, 0)) {
+            esp_bus_report_error(pattern, ESP_ERR_TIMEOUT, "retained replay dropped");
+        }
+    }
+    
     ESP_LOGD(TAG, "Sub '%s' id=%d", pattern, node->id);
     return node->id;
 }
@@ -194,7 +872,9 @@ void esp_bus_unsub(int id) {
     SLIST_FOREACH(node, &g_bus.subs, next) {
         if (node->id == id) {
             SLIST_REMOVE(&g_bus.subs, node, sub_node, next);
-            free(node);
+            esp_bus_idx_remove(node);
+            __atomic_store_n(&node->gone, true, __ATOMIC_RELEASE);
+            esp_bus_retire(&node->rcu, sub_put);
             break;
         }
     }
@@ -202,24 +882,170 @@ void esp_bus_unsub(int id) {
     xSemaphoreGive(g_bus.mutex);
 }
 
+// Caller holds g_bus.mutex
+static sub_node_t *sub_find(int id) {
+    sub_node_t *node;
+    SLIST_FOREACH(node, &g_bus.subs, next) {
+        if (node->id == id) return node;
+    }
+    return NULL;
+}
+
+esp_err_t esp_bus_sub_budget(int id, uint32_t budget_us) {
+    if (!g_bus.initialized || id < 0) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
+    sub_node_t *node = sub_find(id);
+    if (node) __atomic_store_n(&node->budget_us, budget_us, __ATOMIC_RELAXED);
+    xSemaphoreGive(g_bus.mutex);
+    return node ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t esp_bus_sub_offload(int id, uint8_t worker) {
+#if BUS_WORKERS > 0
+    if (!g_bus.initialized || id < 0 || worker > BUS_WORKERS) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
+    sub_node_t *node = sub_find(id);
+    if (node) __atomic_store_n(&node->worker, worker, __ATOMIC_RELAXED);
+    xSemaphoreGive(g_bus.mutex);
+    return node ? ESP_OK : ESP_ERR_NOT_FOUND;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t esp_bus_sub_stats(int id, esp_bus_sub_stats_t *stats) {
+    if (!g_bus.initialized || id < 0 || !stats) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
+    sub_node_t *node = sub_find(id);
+    if (node) {
+        stats->calls = __atomic_load_n(&node->stats.calls, __ATOMIC_RELAXED);
+        stats->over_budget = __atomic_load_n(&node->stats.over_budget, __ATOMIC_RELAXED);
+        stats->max_us = __atomic_load_n(&node->stats.max_us, __ATOMIC_RELAXED);
+        stats->offloaded = __atomic_load_n(&node->stats.offloaded, __ATOMIC_RELAXED);
+        stats->drops = __atomic_load_n(&node->stats.drops, __ATOMIC_RELAXED);
+    }
+    xSemaphoreGive(g_bus.mutex);
+    return node ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+// ============================================================================
+// Subscription budget and offload
+// ============================================================================
+
+// Last reference: the index's (dropped by reclamation) or a queued event's
+static void sub_put(void *p) {
+    sub_node_t *s = p;
+    if (__atomic_sub_fetch(&s->refs, 1, __ATOMIC_ACQ_REL) == 0) free(s);
+}
+
+// Timed run on the bus task or the subscription's worker
+static void sub_call(sub_node_t *s, const char *evt, const void *data, size_t len) {
+    int64_t start = esp_bus_now_us();
+    s->handler(evt, data, len, s->ctx);
+    int64_t d = esp_bus_now_us() - start;
+    uint32_t us = d <= 0 ? 0 : (d > UINT32_MAX ? UINT32_MAX : (uint32_t)d);
+    
+    __atomic_add_fetch(&s->stats.calls, 1, __ATOMIC_RELAXED);
+    uint32_t max = __atomic_load_n(&s->stats.max_us, __ATOMIC_RELAXED);
+    while (us > max && !__atomic_compare_exchange_n(&s->stats.max_us, &max, us, true,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    
+    uint32_t budget = __atomic_load_n(&s->budget_us, __ATOMIC_RELAXED);
+    if (budget && us > budget) {
+        __atomic_add_fetch(&s->stats.over_budget, 1, __ATOMIC_RELAXED);
+        esp_bus_report_error(s->pattern, ESP_ERR_TIMEOUT, "handler over budget");
+    }
+}
+
+// Bus task, inside the dispatch read section or holding a reference: the
+// node cannot be freed before the reference taken here
+void esp_bus_sub_deliver(sub_node_t *s, const pat_node_t *pat, const void *data, size_t len) {
+#if BUS_WORKERS > 0
+    uint8_t worker = __atomic_load_n(&s->worker, __ATOMIC_RELAXED);
+    if (worker) {
+        sub_evt_t *e = esp_bus_alloc(sizeof(*e) + len);
+        if (!e) {
+            __atomic_add_fetch(&s->stats.drops, 1, __ATOMIC_RELAXED);
+            esp_bus_count_drop((pat_node_t *)pat, "no memory for offload");
+            return;
+        }
+        e->sub = s;
+        if (len) memcpy(e->data, data, len);
+        
+        __atomic_add_fetch(&s->refs, 1, __ATOMIC_RELAXED);
+        message_t msg = { .type = MSG_SUB, .pat = (pat_node_t *)pat, .len = len, .data = e };
+        if (xQueueSend(g_bus.worker_queue[worker - 1], &msg, 0) != pdTRUE) {
+            sub_put(s);
+            esp_bus_free(e);
+            __atomic_add_fetch(&s->stats.drops, 1, __ATOMIC_RELAXED);
+            esp_bus_count_drop((pat_node_t *)pat, "worker queue full");
+            return;
+        }
+        __atomic_add_fetch(&s->stats.offloaded, 1, __ATOMIC_RELAXED);
+        return;
+    }
+#endif
+    sub_call(s, pat->name, data, len);
+}
+
+// Worker side of an offloaded event
+void esp_bus_sub_run(message_t *msg) {
+    sub_evt_t *e = msg->data;
+    sub_node_t *s = e->sub;
+    if (!__atomic_load_n(&s->gone, __ATOMIC_ACQUIRE)) {
+        sub_call(s, msg->pat->name, msg->len ? e->data : NULL, msg->len);
+    }
+    sub_put(s);
+    esp_bus_msg_free_payload(msg);
+}
+
 // ============================================================================
 // Public API - Routing
 // ============================================================================
 
+// Caller holds g_bus.mutex
+static esp_err_t add_route(route_node_t *node, const char *evt_pattern) {
+    node->listener.id = -1;
+    strncpy(node->listener.pattern, evt_pattern, ESP_BUS_PATTERN_MAX - 1);
+    node->listener.handler = route_handler;
+    node->listener.ctx = node;
+    
+    esp_err_t err = esp_bus_idx_add(&node->listener);
+    if (err != ESP_OK) return err;
+    
+    SLIST_INSERT_HEAD(&g_bus.routes, node, next);
+    return ESP_OK;
+}
+
+static void free_route(void *p) {
+    route_node_t *r = p;
+    if (r->req_data) free(r->req_data);
+    free(r);
+}
+
 esp_err_t esp_bus_on(const char *evt_pattern, const char *req_pattern,
                       const void *req_data, size_t req_len) {
     if (!g_bus.initialized || !evt_pattern || !req_pattern) return ESP_ERR_INVALID_ARG;
     
     xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
     
+    pat_node_t *req_pat = esp_bus_pat_intern_locked(req_pattern);
+    if (!req_pat || req_pat->sep != '.') {
+        xSemaphoreGive(g_bus.mutex);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
     route_node_t *node = calloc(1, sizeof(route_node_t));
     if (!node) {
         xSemaphoreGive(g_bus.mutex);
         return ESP_ERR_NO_MEM;
     }
     
-    strncpy(node->evt_pattern, evt_pattern, ESP_BUS_PATTERN_MAX - 1);
-    strncpy(node->req_pattern, req_pattern, ESP_BUS_PATTERN_MAX - 1);
+    node->req_pat = req_pat;
     
     if (req_data && req_len > 0) {
         node->req_data = malloc(req_len);
@@ -229,16 +1055,20 @@ esp_err_t esp_bus_on(const char *evt_pattern, const char *req_pattern,
         }
     }
     
-    SLIST_INSERT_HEAD(&g_bus.routes, node, next);
+    esp_err_t err = add_route(node, evt_pattern);
     xSemaphoreGive(g_bus.mutex);
     
+    if (err != ESP_OK) {
+        free_route(node);
+        return err;
+    }
+    
     ESP_LOGD(TAG, "Route '%s' -> '%s'", evt_pattern, req_pattern);
     return ESP_OK;
 }
 
-esp_err_t esp_bus_on_fn(const char *evt_pattern, esp_bus_transform_fn fn, void *ctx) {
-    if (!g_bus.initialized || !evt_pattern || !fn) return ESP_ERR_INVALID_ARG;
-    
+static esp_err_t add_fn_route(const char *evt_pattern, esp_bus_transform_fn fn,
+                              esp_bus_transform_h_fn fn_h, void *ctx) {
     xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
     
     route_node_t *node = calloc(1, sizeof(route_node_t));
@@ -247,16 +1077,31 @@ esp_err_t esp_bus_on_fn(const char *evt_pattern, esp_bus_transform_fn fn, void *
         return ESP_ERR_NO_MEM;
     }
     
-    strncpy(node->evt_pattern, evt_pattern, ESP_BUS_PATTERN_MAX - 1);
     node->transform = fn;
+    node->transform_h = fn_h;
     node->ctx = ctx;
     
-    SLIST_INSERT_HEAD(&g_bus.routes, node, next);
+    esp_err_t err = add_route(node, evt_pattern);
     xSemaphoreGive(g_bus.mutex);
     
+    if (err != ESP_OK) {
+        free_route(node);
+        return err;
+    }
+    
     return ESP_OK;
 }
 
+esp_err_t esp_bus_on_fn(const char *evt_pattern, esp_bus_transform_fn fn, void *ctx) {
+    if (!g_bus.initialized || !evt_pattern || !fn) return ESP_ERR_INVALID_ARG;
+    return add_fn_route(evt_pattern, fn, NULL, ctx);
+}
+
+esp_err_t esp_bus_on_fn_h(const char *evt_pattern, esp_bus_transform_h_fn fn, void *ctx) {
+    if (!g_bus.initialized || !evt_pattern || !fn) return ESP_ERR_INVALID_ARG;
+    return add_fn_route(evt_pattern, NULL, fn, ctx);
+}
+
 esp_err_t esp_bus_off(const char *evt_pattern, const char *req_pattern) {
     if (!g_bus.initialized || !evt_pattern) return ESP_ERR_INVALID_ARG;
     
@@ -264,11 +1109,11 @@ esp_err_t esp_bus_off(const char *evt_pattern, const char *req_pattern) {
     
     route_node_t *r, *tmp;
     SLIST_FOREACH_SAFE(r, &g_bus.routes, next, tmp) {
-        if (strcmp(r->evt_pattern, evt_pattern) == 0) {
-            if (!req_pattern || strcmp(r->req_pattern, req_pattern) == 0) {
+        if (strcmp(r->listener.pattern, evt_pattern) == 0) {
+            if (!req_pattern || (r->req_pat && strcmp(r->req_pat->pattern, req_pattern) == 0)) {
                 SLIST_REMOVE(&g_bus.routes, r, route_node, next);
-                if (r->req_data) free(r->req_data);
-                free(r);
+                esp_bus_idx_remove(&r->listener);
+                esp_bus_retire(&r->listener.rcu, free_route);
             }
         }
     }
@@ -277,3 +1122,28 @@ esp_err_t esp_bus_off(const char *evt_pattern, const char *req_pattern) {
     return ESP_OK;
 }
 
+// ============================================================================
+// Public API - Flow Control
+// ============================================================================
+
+esp_err_t esp_bus_flow(uint16_t high, uint16_t low, esp_bus_flow_fn fn, void *ctx) {
+    if (!g_bus.initialized) return ESP_ERR_INVALID_ARG;
+    if (fn && (high == 0 || high > BUS_QUEUE_SIZE || low >= high)) return ESP_ERR_INVALID_ARG;
+    
+    // Stop callbacks before changing levels and context
+    __atomic_store_n(&g_bus.flow_fn, NULL, __ATOMIC_RELEASE);
+    g_bus.flow_high = high;
+    g_bus.flow_low = low;
+    g_bus.flow_ctx = ctx;
+    __atomic_store_n(&g_bus.congested, false, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_bus.flow_fn, fn, __ATOMIC_RELEASE);
+    return ESP_OK;
+}
+
+uint32_t esp_bus_drop_count(const char *pattern) {
+    if (!g_bus.initialized) return 0;
+    if (!pattern) return __atomic_load_n(&g_bus.drops, __ATOMIC_RELAXED);
+    
+    pat_node_t *pat = esp_bus_pat_find(pattern);
+    return pat ? __atomic_load_n(&pat->drops, __ATOMIC_RELAXED) : 0;
+}
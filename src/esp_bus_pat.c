@@ -0,0 +1,224 @@
+/**
+ * @file esp_bus_pat.c
+ * @brief ESP Bus - Pattern handles (interning, module binding)
+ *
+ * Every concrete pattern ("module.action" / "module:event") seen by the bus
+ * is interned once into a pat_node_t. The node caches the parsed pieces and a
+ * pointer to the target module, so the hot path never parses strings or scans
+ * the module list. Nodes live until esp_bus_deinit(); unregistering a module
+ * only unbinds them, so handles held by callers never dangle.
+ */
+
+#include "esp_bus_priv.h"
+#include <string.h>
+#include <stdlib.h>
+
+// ============================================================================
+// Hash Table
+// ============================================================================
+
+static uint32_t pat_hash(const char *s) {
+    uint32_t h = 2166136261u;   // FNV-1a
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static pat_node_t *bucket_head(uint32_t hash) {
+    return __atomic_load_n(&g_bus.pats[hash & (ESP_BUS_PAT_BUCKETS - 1)], __ATOMIC_ACQUIRE);
+}
+
+// Lock-free: nodes are only ever prepended (with release ordering) and are
+// never removed before deinit, so readers may walk a chain at any time.
+pat_node_t *esp_bus_pat_find(const char *pattern) {
+    uint32_t hash = pat_hash(pattern);
+    for (pat_node_t *p = bucket_head(hash); p; p = p->next) {
+        if (p->hash == hash && strcmp(p->pattern, pattern) == 0) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+// ============================================================================
+// Binding
+// ============================================================================
+
+static bool pat_is_module(const pat_node_t *pat, const esp_bus_module_t *mod) {
+    size_t len = (size_t)(pat->name - pat->pattern) - 1;
+    return strncmp(pat->pattern, mod->name, len) == 0 && mod->name[len] == '\0';
+}
+
+// The index is published before the module; see action_fn() in esp_bus_msg.c
+static void pat_bind(pat_node_t *pat, const esp_bus_module_t *mod) {
+    int16_t index = -1;
+    if (pat->sep == '.' && mod->actions) {
+        for (size_t i = 0; i < mod->action_cnt; i++) {
+            if (strcmp(mod->actions[i].name, pat->name) == 0) {
+                index = (int16_t)i;
+                break;
+            }
+        }
+    } else if (pat->sep == ':' && mod->events) {
+        for (size_t i = 0; i < mod->event_cnt; i++) {
+            if (strcmp(mod->events[i].name, pat->name) == 0) {
+                index = (int16_t)i;
+                break;
+            }
+        }
+    }
+    __atomic_store_n(&pat->index, index, __ATOMIC_RELEASE);
+    __atomic_store_n(&pat->mod, mod, __ATOMIC_RELEASE);
+}
+
+void esp_bus_pat_bind(const esp_bus_module_t *mod) {
+    for (size_t b = 0; b < ESP_BUS_PAT_BUCKETS; b++) {
+        for (pat_node_t *p = g_bus.pats[b]; p; p = p->next) {
+            if (!p->mod && pat_is_module(p, mod)) {
+                pat_bind(p, mod);
+            }
+        }
+    }
+}
+
+void esp_bus_pat_unbind(const esp_bus_module_t *mod) {
+    for (size_t b = 0; b < ESP_BUS_PAT_BUCKETS; b++) {
+        for (pat_node_t *p = g_bus.pats[b]; p; p = p->next) {
+            if (p->mod == mod) {
+                __atomic_store_n(&p->mod, NULL, __ATOMIC_RELEASE);
+                __atomic_store_n(&p->index, -1, __ATOMIC_RELEASE);
+            }
+        }
+    }
+}
+
+// ============================================================================
+// Interning
+// ============================================================================
+
+pat_node_t *esp_bus_pat_intern_locked(const char *pattern) {
+    pat_node_t *pat = esp_bus_pat_find(pattern);
+    if (pat) return pat;
+    
+    size_t len = strlen(pattern);
+    if (len >= ESP_BUS_PATTERN_MAX) return NULL;
+    
+    // Same precedence as the original parser: '.' wins over ':'
+    const char *sep = strchr(pattern, '.');
+    if (!sep) sep = strchr(pattern, ':');
+    if (!sep || (size_t)(sep - pattern) >= ESP_BUS_NAME_MAX) return NULL;
+    
+    pat = calloc(1, sizeof(pat_node_t));
+    if (!pat) return NULL;
+    
+    memcpy(pat->pattern, pattern, len + 1);
+    pat->hash = pat_hash(pattern);
+    pat->id = g_bus.next_pat_id++;
+    pat->sep = *sep;
+    pat->name = pat->pattern + (sep - pattern) + 1;
+    pat->index = -1;
+    pat->prio = ESP_BUS_PRIO_NORMAL;    // HIGH is 0, so not left to calloc
+    
+    char name[ESP_BUS_NAME_MAX];
+    memcpy(name, pattern, sep - pattern);
+    name[sep - pattern] = '\0';
+    const esp_bus_module_t *mod = esp_bus_find_module(name);
+    if (mod) pat_bind(pat, mod);
+    
+    pat_node_t **head = &g_bus.pats[pat->hash & (ESP_BUS_PAT_BUCKETS - 1)];
+    pat->next = *head;
+    __atomic_store_n(head, pat, __ATOMIC_RELEASE);
+    return pat;
+}
+
+pat_node_t *esp_bus_pat_get(const char *pattern) {
+    pat_node_t *pat = esp_bus_pat_find(pattern);
+    if (pat) return pat;
+    
+    xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
+    pat = esp_bus_pat_intern_locked(pattern);
+    xSemaphoreGive(g_bus.mutex);
+    return pat;
+}
+
+void esp_bus_pat_free_all(void) {
+    for (size_t b = 0; b < ESP_BUS_PAT_BUCKETS; b++) {
+        pat_node_t *p = g_bus.pats[b];
+        while (p) {
+            pat_node_t *next = p->next;
+            esp_bus_free(p->cfl_data);
+            esp_bus_free(p->ret_data);
+            free(p);
+            p = next;
+        }
+        g_bus.pats[b] = NULL;
+    }
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+esp_bus_handle_t esp_bus_resolve(const char *pattern) {
+    if (!g_bus.initialized || !pattern) return NULL;
+    return esp_bus_pat_get(pattern);
+}
+
+esp_err_t esp_bus_prio(const char *pattern, esp_bus_prio_t prio) {
+    if (!g_bus.initialized || !pattern || prio >= ESP_BUS_PRIO_MAX) return ESP_ERR_INVALID_ARG;
+    if (strchr(pattern, '*')) return ESP_ERR_INVALID_ARG;
+    
+    pat_node_t *pat = esp_bus_pat_get(pattern);
+    if (!pat) return ESP_ERR_INVALID_ARG;
+    
+    __atomic_store_n(&pat->prio, (uint8_t)prio, __ATOMIC_RELAXED);
+    return ESP_OK;
+}
+
+esp_err_t esp_bus_conflate(const char *pattern, bool enable) {
+    if (!g_bus.initialized || !pattern) return ESP_ERR_INVALID_ARG;
+    if (strchr(pattern, '*')) return ESP_ERR_INVALID_ARG;
+    
+    pat_node_t *pat = esp_bus_pat_get(pattern);
+    if (!pat || pat->sep != ':') return ESP_ERR_INVALID_ARG;
+    
+    __atomic_store_n(&pat->conflate, enable, __ATOMIC_RELAXED);
+    return ESP_OK;
+}
+
+esp_err_t esp_bus_retain(const char *pattern, bool enable) {
+    if (!g_bus.initialized || !pattern) return ESP_ERR_INVALID_ARG;
+    if (strchr(pattern, '*')) return ESP_ERR_INVALID_ARG;
+    
+    pat_node_t *pat = esp_bus_pat_get(pattern);
+    if (!pat || pat->sep != ':') return ESP_ERR_INVALID_ARG;
+    
+    if (enable && !__atomic_exchange_n(&pat->retain, true, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&g_bus.retained_cnt, 1, __ATOMIC_RELAXED);
+    } else if (!enable) {
+        // The bus task drops the cached value on the next event
+        __atomic_store_n(&pat->retain, false, __ATOMIC_RELAXED);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_bus_overflow(const char *pattern, esp_bus_overflow_t policy, uint32_t timeout_ms) {
+    if (!g_bus.initialized || !pattern || policy > ESP_BUS_OVERFLOW_COALESCE) return ESP_ERR_INVALID_ARG;
+    if (strchr(pattern, '*')) return ESP_ERR_INVALID_ARG;
+    
+    pat_node_t *pat = esp_bus_pat_get(pattern);
+    if (!pat || pat->sep != ':') return ESP_ERR_INVALID_ARG;
+    
+    __atomic_store_n(&pat->block_ms, timeout_ms, __ATOMIC_RELAXED);
+    uint8_t old = __atomic_exchange_n(&pat->overflow, (uint8_t)policy, __ATOMIC_RELAXED);
+    
+    // Coalescing is conflation; leaving it turns conflation back off
+    if (policy == ESP_BUS_OVERFLOW_COALESCE) {
+        __atomic_store_n(&pat->conflate, true, __ATOMIC_RELAXED);
+    } else if (old == ESP_BUS_OVERFLOW_COALESCE) {
+        __atomic_store_n(&pat->conflate, false, __ATOMIC_RELAXED);
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,158 @@
+/**
+ * @file esp_bus_pool.c
+ * @brief ESP Bus - Payload block pool
+ *
+ * Fixed-size block classes carved out of one allocation made in
+ * esp_bus_init(). Payloads that do not fit a free block fall back to the
+ * heap. A block's class is found from its address, so blocks carry no header.
+ *
+ * Shared buffers (esp_bus_buf_t) are allocated the same way, with their
+ * header in front of the payload.
+ */
+
+#include "esp_bus_priv.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const uint16_t s_class_size[ESP_BUS_POOL_CLASSES] = { 16, 64, 256 };
+static const uint16_t s_class_cnt[ESP_BUS_POOL_CLASSES] = {
+    BUS_POOL_BLOCKS_16, BUS_POOL_BLOCKS_64, BUS_POOL_BLOCKS_256,
+};
+
+static portMUX_TYPE s_pool_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// ============================================================================
+// Init / Deinit
+// ============================================================================
+
+esp_err_t esp_bus_pool_init(void) {
+    pool_t *pool = &g_bus.pool;
+    size_t total = 0;
+    
+    memset(pool, 0, sizeof(*pool));
+    for (int c = 0; c < ESP_BUS_POOL_CLASSES; c++) {
+        total += (size_t)s_class_size[c] * s_class_cnt[c];
+    }
+    if (total == 0) return ESP_OK;
+    
+    pool->mem = malloc(total);
+    if (!pool->mem) return ESP_ERR_NO_MEM;
+    
+    uint8_t *p = pool->mem;
+    for (int c = 0; c < ESP_BUS_POOL_CLASSES; c++) {
+        pool_class_t *cls = &pool->cls[c];
+        cls->start = p;
+        for (uint16_t i = 0; i < s_class_cnt[c]; i++) {
+            pool_block_t *blk = (pool_block_t *)p;
+            blk->next = cls->free;
+            cls->free = blk;
+            p += s_class_size[c];
+        }
+        cls->end = p;
+    }
+    return ESP_OK;
+}
+
+void esp_bus_pool_deinit(void) {
+    free(g_bus.pool.mem);
+    memset(&g_bus.pool, 0, sizeof(g_bus.pool));
+}
+
+// ============================================================================
+// Alloc / Free
+// ============================================================================
+
+void *esp_bus_alloc(size_t len) {
+    pool_t *pool = &g_bus.pool;
+    
+    for (int c = 0; c < ESP_BUS_POOL_CLASSES; c++) {
+        if (len > s_class_size[c]) continue;
+        
+        pool_class_t *cls = &pool->cls[c];
+        portENTER_CRITICAL_SAFE(&s_pool_lock);
+        pool_block_t *blk = cls->free;
+        if (blk) {
+            cls->free = blk->next;
+            if (++cls->in_use > cls->high_water) cls->high_water = cls->in_use;
+            pool->hits++;
+            portEXIT_CRITICAL_SAFE(&s_pool_lock);
+            return blk;
+        }
+        portEXIT_CRITICAL_SAFE(&s_pool_lock);
+        // Class exhausted: try the next larger one
+    }
+    
+    void *p = malloc(len);
+    if (p) {
+        portENTER_CRITICAL_SAFE(&s_pool_lock);
+        pool->misses++;
+        portEXIT_CRITICAL_SAFE(&s_pool_lock);
+    }
+    return p;
+}
+
+void esp_bus_free(void *p) {
+    if (!p) return;
+    
+    pool_t *pool = &g_bus.pool;
+    for (int c = 0; c < ESP_BUS_POOL_CLASSES; c++) {
+        pool_class_t *cls = &pool->cls[c];
+        if ((uint8_t *)p >= cls->start && (uint8_t *)p < cls->end) {
+            pool_block_t *blk = (pool_block_t *)p;
+            portENTER_CRITICAL_SAFE(&s_pool_lock);
+            blk->next = cls->free;
+            cls->free = blk;
+            cls->in_use--;
+            portEXIT_CRITICAL_SAFE(&s_pool_lock);
+            return;
+        }
+    }
+    free(p);
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+esp_err_t esp_bus_pool_stats(esp_bus_pool_stats_t *stats) {
+    if (!g_bus.initialized || !stats) return ESP_ERR_INVALID_ARG;
+    
+    pool_t *pool = &g_bus.pool;
+    portENTER_CRITICAL_SAFE(&s_pool_lock);
+    stats->hits = pool->hits;
+    stats->misses = pool->misses;
+    for (int c = 0; c < ESP_BUS_POOL_CLASSES; c++) {
+        stats->cls[c].block_size = s_class_size[c];
+        stats->cls[c].count = s_class_cnt[c];
+        stats->cls[c].in_use = pool->cls[c].in_use;
+        stats->cls[c].high_water = pool->cls[c].high_water;
+    }
+    portEXIT_CRITICAL_SAFE(&s_pool_lock);
+    return ESP_OK;
+}
+
+esp_bus_buf_t *esp_bus_buf_alloc(size_t size) {
+    if (!g_bus.initialized) return NULL;
+    
+    esp_bus_buf_t *buf = esp_bus_alloc(sizeof(esp_bus_buf_t) + size);
+    if (!buf) return NULL;
+    buf->refs = 1;
+    buf->size = size;
+    buf->len = size;
+    return buf;
+}
+
+esp_bus_buf_t *esp_bus_buf_acquire(esp_bus_buf_t *buf) {
+    if (buf) __atomic_add_fetch(&buf->refs, 1, __ATOMIC_RELAXED);
+    return buf;
+}
+
+void esp_bus_buf_release(esp_bus_buf_t *buf) {
+    if (!buf) return;
+    if (__atomic_sub_fetch(&buf->refs, 1, __ATOMIC_ACQ_REL) == 0) esp_bus_free(buf);
+}
+
+esp_bus_buf_t *esp_bus_cur_buf(void) {
+    if (xTaskGetCurrentTaskHandle() != g_bus.task) return NULL;
+    return g_bus.cur_buf;
+}
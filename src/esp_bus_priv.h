@@ -8,42 +8,141 @@
 #include "esp_bus.h"
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
+#include "esp_timer.h"
+#ifdef CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
 #include <sys/queue.h>
 
 // ============================================================================
 // Internal Types
 // ============================================================================
 
+// Retired node awaiting reclamation; first member of every retirable type
+typedef struct rcu_head {
+    struct rcu_head *next;
+    uint32_t epoch;
+    void (*fn)(void *);         // Frees the node (receives the head)
+} rcu_head_t;
+
+// SLIST updates visible to lock-free readers (writers hold g_bus.mutex)
+#define RCU_SLIST_FIRST(head)       __atomic_load_n(&(head)->slh_first, __ATOMIC_ACQUIRE)
+#define RCU_SLIST_NEXT(elm, field)  __atomic_load_n(&(elm)->field.sle_next, __ATOMIC_ACQUIRE)
+
+#define RCU_SLIST_FOREACH(var, head, field) \
+    for ((var) = RCU_SLIST_FIRST(head); (var); (var) = RCU_SLIST_NEXT(var, field))
+
+#define RCU_SLIST_INSERT_HEAD(head, elm, field) do { \
+    (elm)->field.sle_next = (head)->slh_first; \
+    __atomic_store_n(&(head)->slh_first, (elm), __ATOMIC_RELEASE); \
+} while (0)
+
+// The removed element keeps its link so readers standing on it can go on
+#define RCU_SLIST_REMOVE(head, elm, type, field) do { \
+    struct type **_pp = &(head)->slh_first; \
+    while (*_pp != (elm)) _pp = &(*_pp)->field.sle_next; \
+    __atomic_store_n(_pp, (elm)->field.sle_next, __ATOMIC_RELEASE); \
+} while (0)
+
+// Module added by esp_bus_reg(). Static modules (ESP_BUS_MODULE_DEFINE)
+// are used in place, so lookups and bindings deal in descriptors only.
 typedef struct module_node {
+    rcu_head_t rcu;
+    uint32_t refs;              // The table, plus handlers running outside a read section
+    esp_bus_module_t desc;      // desc.name points to name[]
     char name[ESP_BUS_NAME_MAX];
-    esp_bus_req_fn on_req;
-    esp_bus_evt_fn on_evt;
-    void *ctx;
-    const esp_bus_action_t *actions;
-    size_t action_cnt;
-    const esp_bus_event_t *events;
-    size_t event_cnt;
-    SLIST_ENTRY(module_node) next;
 } module_node_t;
 
+// Immutable module table, replaced as a whole by esp_bus_reg/unreg
+typedef struct {
+    rcu_head_t rcu;
+    size_t cnt;
+    module_node_t *mods[];
+} module_table_t;
+
+#define ESP_BUS_PAT_BUCKETS   32
+
+struct sub_node;
+SLIST_HEAD(idx_list, sub_node);
+
+// Interned pattern (public handle: esp_bus_handle_t)
+typedef struct esp_bus_pat {
+    uint32_t hash;
+    uint16_t id;
+    char sep;                   // '.' request, ':' event
+    int16_t index;              // Action/event index in module schema, -1 if none
+    uint8_t prio;               // esp_bus_prio_t lane on the bus task
+    bool conflate;              // At most one pending emit, latest payload wins
+    bool cfl_queued;            // Its MSG_CFL is in a lane (guarded by the conflation lock)
+    void *cfl_data;             // Latest conflated payload
+    size_t cfl_len;
+    uint8_t overflow;           // esp_bus_overflow_t when the lane is full
+    uint32_t block_ms;          // Wait for ESP_BUS_OVERFLOW_BLOCK
+    uint32_t drops;
+#ifdef CONFIG_ESP_BUS_PROFILE
+    esp_bus_hist_t prof_lat;    // Enqueue to dispatch
+    esp_bus_hist_t prof_exec;   // Handler time
+#endif
+    bool retain;                // Keep the last delivered payload
+    bool ret_valid;             // ret_data holds a value (guarded by the retain lock)
+    void *ret_data;             // Written by the bus task only
+    size_t ret_len;
+    const esp_bus_module_t *mod;    // Bound module, NULL while not registered
+    const char *name;           // Action/event part (points into pattern)
+    char pattern[ESP_BUS_PATTERN_MAX];
+    struct idx_list subs;       // Exact-match listeners
+    struct esp_bus_pat *next;   // Hash chain
+} pat_node_t;
+
+typedef enum {
+    SUB_EXACT,
+    SUB_PREFIX,
+    SUB_SUFFIX,
+    SUB_GLOB,
+} sub_kind_t;
+
+typedef struct trie_node {
+    rcu_head_t rcu;
+    char c;
+    struct trie_node *parent;
+    struct trie_node *child;
+    struct trie_node *sibling;
+    struct idx_list subs;
+} trie_node_t;
+
+// Index listener: a subscription, or the listener embedded in a route
 typedef struct sub_node {
-    int id;
+    rcu_head_t rcu;
+    int id;                     // -1 for routes
     char pattern[ESP_BUS_PATTERN_MAX];
     esp_bus_evt_fn handler;
     void *ctx;
+    uint8_t kind;               // sub_kind_t
+    bool verify;                // Candidate must be confirmed by the matcher
+    bool gone;                  // Unsubscribed, offloaded events are skipped
+    uint8_t worker;             // Offload target, 0 to run on the bus task
+    uint32_t budget_us;         // 0 if not measured
+    uint32_t refs;              // The index, plus offloaded events and replays in flight
+    esp_bus_sub_stats_t stats;
+    struct idx_list *list;      // Index list holding this listener
+    trie_node_t *trie;          // Owning trie node (prefix/suffix)
     SLIST_ENTRY(sub_node) next;
+    SLIST_ENTRY(sub_node) idx_next;
 } sub_node_t;
 
 typedef struct route_node {
-    char evt_pattern[ESP_BUS_PATTERN_MAX];
-    char req_pattern[ESP_BUS_PATTERN_MAX];
+    sub_node_t listener;        // First: registered in the index with this route as ctx
+    pat_node_t *req_pat;        // Resolved target, NULL for transform routes
     void *req_data;
     size_t req_len;
     esp_bus_transform_fn transform;
+    esp_bus_transform_h_fn transform_h;
     void *ctx;
     SLIST_ENTRY(route_node) next;
 } route_node_t;
 
+#define ESP_BUS_SVC_BUCKETS   16
+
 typedef struct svc_node {
     int id;
     esp_bus_svc_fn fn;
@@ -51,32 +150,223 @@ typedef struct svc_node {
     uint32_t interval_ms;
     int64_t next_run_us;
     bool repeat;
-    SLIST_ENTRY(svc_node) next;
+    bool cancelled;             // Cancelled while its callback runs
+    bool pm;                    // Runs under the CPU frequency lock
+    uint8_t policy;             // esp_bus_overrun_t
+    uint8_t max_catch_up;
+    uint8_t catch_up;           // Consecutive catch-up runs so far
+    uint32_t runs;
+    uint32_t missed;
+    uint32_t late_max_us;
+    uint64_t late_sum_us;
+    int32_t heap_idx;           // Position in svc_heap, -1 if not armed
+    struct svc_node *id_next;   // Id hash chain
 } svc_node_t;
 
 typedef enum {
     MSG_REQ,
     MSG_EVT,
-    MSG_TRIGGER,
+    MSG_BATCH,
+    MSG_BUF,                    // Event carrying a shared esp_bus_buf_t in data
+    MSG_CFL,                    // Conflated event, payload held by the pattern
+    MSG_RETAINED,               // Replay retained values to subscription id len
+    MSG_MULTI,                  // esp_bus_req_all() job in data, fanned out on the bus task
+    MSG_SUB,                    // Offloaded event for one subscription, sub_evt_t in data
 } msg_type_t;
 
+#ifdef CONFIG_ESP_BUS_INLINE_PAYLOAD_SIZE
+#define BUS_INLINE_MAX CONFIG_ESP_BUS_INLINE_PAYLOAD_SIZE
+#else
+#define BUS_INLINE_MAX 8
+#endif
+
+typedef enum {
+    REPLY_PENDING,              // Requester waits, result not written yet
+    REPLY_WRITING,              // Serving task copies the result out
+    REPLY_DONE,
+    REPLY_CANCELLED,            // Requester timed out, slot freed by the server
+} reply_state_t;
+
+// Reply of a request: a preallocated slot for blocking callers, a pooled
+// record for esp_bus_req_async() (see esp_bus_reply.c)
 typedef struct {
-    msg_type_t type;
+    uint32_t state;             // reply_state_t
+    void *buf;                  // Caller's response buffer
+    size_t size;
+    size_t *len;
+    esp_err_t result;
+    SemaphoreHandle_t done;     // Blocking slots only
+    esp_bus_buf_t **out;        // Caller takes a response buffer (esp_bus_req_buf)
+    esp_bus_done_fn fn;         // Async completion, NULL for blocking slots
+    void *ctx;
+} msg_reply_t;
+
+// Response buffer of the request a serving task is running
+typedef struct {
+    bool wanted;                // Someone reads the response
+    esp_bus_buf_t *buf;         // From esp_bus_res_buf()
+} res_slot_t;
+
+// MSG_MULTI payload: ent[max] followed by the request data. Targets on a
+// worker complete through an async reply whose ctx is their entry.
+struct multi_job;
+
+typedef struct {
+    esp_bus_target_res_t res;
+    struct multi_job *job;
+} multi_ent_t;
+
+typedef struct multi_job {
     char pattern[ESP_BUS_PATTERN_MAX];
-    void *data;
+    msg_reply_t *reply;         // NULL when nobody waits for the result
+    uint32_t pending;           // Targets in flight, plus one while fanning out
+    esp_err_t first_err;
+    uint16_t cnt;               // Targets matched
+    uint16_t max;               // Entries in ent[]
+    size_t req_len;
+    multi_ent_t sink;           // Completion context of targets past ent[max]
+    multi_ent_t ent[];
+} multi_job_t;
+
+// MSG_BATCH payload: entries followed by the copied event data
+typedef struct {
+    pat_node_t *pat;
+    size_t off;                 // Data offset from the start of the batch buffer
     size_t len;
-    void *res_buf;
-    size_t res_size;
-    size_t *res_len;
-    esp_err_t *result;
-    SemaphoreHandle_t done;
+} batch_ent_t;
+
+// MSG_SUB payload: the subscription holds a reference until it is run
+typedef struct {
+    sub_node_t *sub;
+    uint8_t data[];
+} sub_evt_t;
+
+typedef struct {
+    uint8_t type;               // msg_type_t
+    bool inlined;               // Payload stored in buf[] instead of data
+    pat_node_t *pat;
+    size_t len;
+    msg_reply_t *reply;         // NULL when nobody waits for the result
+#ifdef CONFIG_ESP_BUS_PROFILE
+    int64_t t_enq;              // Queued at (esp_bus_now_us)
+#endif
+    union {
+        void *data;
+        uint8_t buf[BUS_INLINE_MAX];
+    };
 } message_t;
 
+// ISR event ring
+#ifdef CONFIG_ESP_BUS_ISR_RING_SIZE
+#define BUS_ISR_RING_SIZE CONFIG_ESP_BUS_ISR_RING_SIZE
+#else
+#define BUS_ISR_RING_SIZE 16
+#endif
+
+#ifdef CONFIG_ESP_BUS_ISR_PAYLOAD_MAX
+#define BUS_ISR_PAYLOAD_MAX CONFIG_ESP_BUS_ISR_PAYLOAD_MAX
+#else
+#define BUS_ISR_PAYLOAD_MAX 16
+#endif
+
+typedef struct {
+    uint32_t seq;               // Slot state, see esp_bus_isr.c
+    esp_bus_svc_fn fn;          // Deferred call; event slot if NULL
+    void *ctx;
+    pat_node_t *pat;            // NULL: intern pattern[] on the bus task
+    uint8_t len;
+    char pattern[ESP_BUS_PATTERN_MAX];
+    union {
+        void *align;
+        uint8_t data[BUS_ISR_PAYLOAD_MAX];
+    };
+} isr_slot_t;
+
+// Trace ring (power of two, 0 compiles it out)
+#ifdef CONFIG_ESP_BUS_TRACE_SIZE
+#define BUS_TRACE_SIZE CONFIG_ESP_BUS_TRACE_SIZE
+#else
+#define BUS_TRACE_SIZE 64
+#endif
+
+// Bus task and workers
+#ifdef CONFIG_ESP_BUS_QUEUE_SIZE
+#define BUS_QUEUE_SIZE CONFIG_ESP_BUS_QUEUE_SIZE
+#else
+#define BUS_QUEUE_SIZE 16
+#endif
+
+#ifdef CONFIG_ESP_BUS_TASK_STACK_SIZE
+#define BUS_STACK_SIZE CONFIG_ESP_BUS_TASK_STACK_SIZE
+#else
+#define BUS_STACK_SIZE 4096
+#endif
+
+#ifdef CONFIG_ESP_BUS_TASK_PRIORITY
+#define BUS_PRIORITY CONFIG_ESP_BUS_TASK_PRIORITY
+#else
+#define BUS_PRIORITY 5
+#endif
+
+#ifdef CONFIG_ESP_BUS_PRIO_BURST
+#define BUS_PRIO_BURST CONFIG_ESP_BUS_PRIO_BURST
+#else
+#define BUS_PRIO_BURST 8
+#endif
+
+#ifdef CONFIG_ESP_BUS_REPLY_SLOTS
+#define BUS_REPLY_SLOTS CONFIG_ESP_BUS_REPLY_SLOTS
+#else
+#define BUS_REPLY_SLOTS 8
+#endif
+
+#ifdef CONFIG_ESP_BUS_WORKERS
+#define BUS_WORKERS CONFIG_ESP_BUS_WORKERS
+#else
+#define BUS_WORKERS 0
+#endif
+
+// Payload pool: one free list per block class
+#ifdef CONFIG_ESP_BUS_POOL_BLOCKS_16
+#define BUS_POOL_BLOCKS_16 CONFIG_ESP_BUS_POOL_BLOCKS_16
+#else
+#define BUS_POOL_BLOCKS_16 16
+#endif
+
+#ifdef CONFIG_ESP_BUS_POOL_BLOCKS_64
+#define BUS_POOL_BLOCKS_64 CONFIG_ESP_BUS_POOL_BLOCKS_64
+#else
+#define BUS_POOL_BLOCKS_64 8
+#endif
+
+#ifdef CONFIG_ESP_BUS_POOL_BLOCKS_256
+#define BUS_POOL_BLOCKS_256 CONFIG_ESP_BUS_POOL_BLOCKS_256
+#else
+#define BUS_POOL_BLOCKS_256 4
+#endif
+
+typedef struct pool_block {
+    struct pool_block *next;
+} pool_block_t;
+
+typedef struct {
+    uint8_t *start;
+    uint8_t *end;
+    pool_block_t *free;
+    uint16_t in_use;
+    uint16_t high_water;
+} pool_class_t;
+
+typedef struct {
+    uint8_t *mem;
+    pool_class_t cls[ESP_BUS_POOL_CLASSES];
+    uint32_t hits;
+    uint32_t misses;
+} pool_t;
+
 // List Heads
-SLIST_HEAD(module_list, module_node);
 SLIST_HEAD(sub_list, sub_node);
 SLIST_HEAD(route_list, route_node);
-SLIST_HEAD(svc_list, svc_node);
 
 // ============================================================================
 // Global State
@@ -88,17 +378,77 @@ typedef struct {
     esp_log_level_t log_level;
     esp_bus_err_fn on_err;
     
-    struct module_list modules;
+    module_table_t *modules;    // Published with release stores
     struct sub_list subs;
     struct route_list routes;
-    struct svc_list services;
+    
+    pat_node_t *pats[ESP_BUS_PAT_BUCKETS];
+    trie_node_t prefix_root;
+    trie_node_t suffix_root;
+    struct idx_list globs;
+    pool_t pool;
+    
+    svc_node_t **svc_heap;      // Min-heap on next_run_us
+    int64_t svc_next_us;        // next_run_us of svc_heap[0], 0 if empty
+    size_t svc_cnt;
+    size_t svc_cap;
+    svc_node_t *svc_ids[ESP_BUS_SVC_BUCKETS];
+    svc_node_t *svc_running;    // Callback in progress (bus task)
+    esp_bus_buf_t *cur_buf;     // Buffer of the event being dispatched (bus task)
+    const pat_node_t *cur_pat;  // Event being dispatched (bus task)
+    
+    isr_slot_t *isr_ring;
+    uint32_t isr_mask;
+    uint32_t isr_head;          // Next producer position
+    uint32_t isr_tail;          // Next consumer position (bus task only)
+    uint32_t isr_pending;       // Wake-up already signalled
+    
+    msg_reply_t replies[BUS_REPLY_SLOTS];
+    res_slot_t res_slots[1 + BUS_WORKERS];  // Bus task, then workers
+    uint32_t reply_free;        // Bit per free slot
+    
+    uint32_t rcu_epoch;
+    uint32_t rcu_readers[2];    // Open read sections per epoch parity
+    rcu_head_t *retired;
+    
+    uint32_t retained_cnt;      // Patterns with retain set, ever
+    
+    uint32_t drops;             // All patterns
+    esp_bus_flow_fn flow_fn;
+    void *flow_ctx;
+    uint16_t flow_high;
+    uint16_t flow_low;
+    bool congested;
+    
+#ifdef CONFIG_ESP_BUS_PROFILE
+    uint16_t lane_high_water[ESP_BUS_PRIO_MAX];
+    uint32_t wakeups;           // Bus task wake-ups since prof_since_us
+    int64_t prof_since_us;      // Last init or esp_bus_stats_reset()
+#endif
     
     int next_sub_id;
     int next_svc_id;
+    uint16_t next_pat_id;
     
-    QueueHandle_t queue;
+    QueueHandle_t lanes[ESP_BUS_PRIO_MAX];
+    uint8_t lane_skips[ESP_BUS_PRIO_MAX];   // Messages taken ahead of a waiting lane
+    SemaphoreHandle_t wake;     // Given after every post, or to wake the task
     SemaphoreHandle_t mutex;
     TaskHandle_t task;
+    
+#if BUS_WORKERS > 0
+    QueueHandle_t worker_queue[BUS_WORKERS];
+    TaskHandle_t worker_task[BUS_WORKERS];
+#endif
+    
+#ifdef CONFIG_ESP_BUS_HIRES_TIMER
+    esp_timer_handle_t hires_timer;
+    int64_t hires_deadline_us;  // Deadline the timer is armed for, 0 if none
+#endif
+    
+#ifdef CONFIG_PM_ENABLE
+    esp_pm_lock_handle_t pm_lock;   // CPU_FREQ_MAX, held while a pm service runs
+#endif
 } esp_bus_state_t;
 
 extern esp_bus_state_t g_bus;
@@ -110,16 +460,126 @@ extern esp_bus_state_t g_bus;
 // Helpers
 int64_t esp_bus_now_us(void);
 bool esp_bus_match_pattern(const char *pattern, const char *target);
-bool esp_bus_parse_pattern(const char *pattern, char *module, char *action, char *sep);
-module_node_t *esp_bus_find_module(const char *name);
+const esp_bus_module_t *esp_bus_find_module(const char *name);
+void esp_bus_module_hold(const esp_bus_module_t *mod);
+void esp_bus_module_release(const esp_bus_module_t *mod);
 void esp_bus_report_error(const char *pattern, esp_err_t err, const char *msg);
 
+// Static descriptors (linker sections)
+esp_err_t esp_bus_static_check(void);
+esp_err_t esp_bus_static_install(void);
+const esp_bus_module_t *esp_bus_static_find(const char *name);
+bool esp_bus_static_owns(const esp_bus_module_t *mod);
+size_t esp_bus_static_modules(const esp_bus_module_t **mods);
+
+// Read sections and deferred reclamation
+uint32_t esp_bus_rcu_lock(void);
+void esp_bus_rcu_unlock(uint32_t slot);
+void esp_bus_retire(rcu_head_t *head, void (*fn)(void *));
+bool esp_bus_rcu_reclaim(void);
+void esp_bus_rcu_free_all(void);
+
+// Pattern handles
+pat_node_t *esp_bus_pat_find(const char *pattern);
+pat_node_t *esp_bus_pat_get(const char *pattern);
+pat_node_t *esp_bus_pat_intern_locked(const char *pattern);
+void esp_bus_pat_bind(const esp_bus_module_t *mod);
+void esp_bus_pat_unbind(const esp_bus_module_t *mod);
+void esp_bus_pat_free_all(void);
+
+// Message payload
+esp_err_t esp_bus_msg_set_payload(message_t *msg, const void *data, size_t len);
+void esp_bus_msg_free_payload(message_t *msg);
+void esp_bus_msg_discard(message_t *msg);
+void esp_bus_msg_lost(message_t *msg);
+
+static inline const void *esp_bus_msg_payload(const message_t *msg) {
+    return msg->inlined ? msg->buf : msg->data;
+}
+
+// Payload pool
+esp_err_t esp_bus_pool_init(void);
+void esp_bus_pool_deinit(void);
+void *esp_bus_alloc(size_t len);
+void esp_bus_free(void *p);
+
+// Request replies
+esp_err_t esp_bus_reply_init(void);
+void esp_bus_reply_deinit(void);
+msg_reply_t *esp_bus_reply_get(void *buf, size_t size, size_t *len);
+msg_reply_t *esp_bus_reply_async(size_t size, esp_bus_done_fn fn, void *ctx);
+void esp_bus_reply_release(msg_reply_t *r);
+esp_err_t esp_bus_reply_wait(msg_reply_t *r, TickType_t ticks);
+void esp_bus_reply_serve(const pat_node_t *pat, const void *req, size_t req_len, msg_reply_t *r);
+void esp_bus_reply_finish(msg_reply_t *r, esp_err_t err, const void *res, size_t copy, size_t len);
+
+// ISR ring
+esp_err_t esp_bus_isr_init(void);
+void esp_bus_isr_deinit(void);
+void esp_bus_isr_drain(void);
+
+// Worker tasks
+esp_err_t esp_bus_worker_init(void);
+void esp_bus_worker_deinit(void);
+QueueHandle_t esp_bus_worker_queue(const pat_node_t *pat);
+bool esp_bus_worker_self(QueueHandle_t queue);
+int esp_bus_worker_index(void);
+
+// Subscription index
+void esp_bus_idx_init(void);
+esp_err_t esp_bus_idx_add(sub_node_t *sub);
+void esp_bus_idx_remove(sub_node_t *sub);
+void esp_bus_idx_dispatch(const pat_node_t *pat, const void *data, size_t len);
+void esp_bus_idx_free_all(void);
+void esp_bus_sub_deliver(sub_node_t *sub, const pat_node_t *pat, const void *data, size_t len);
+void esp_bus_sub_run(message_t *msg);
+
+// Handler start time, taken only when the profiler or the trace needs it
+#if defined(CONFIG_ESP_BUS_PROFILE) || BUS_TRACE_SIZE > 0
+#define BUS_CLOCK_START(t)      int64_t t = esp_bus_now_us()
+#else
+#define BUS_CLOCK_START(t)      ((void)0)
+#endif
+
+// Profiler (compiled out without CONFIG_ESP_BUS_PROFILE)
+#ifdef CONFIG_ESP_BUS_PROFILE
+#define BUS_PROF_STAMP(msg)     ((msg)->t_enq = esp_bus_now_us())
+#define BUS_PROF_EXEC(pat, t)   esp_bus_prof_exec(pat, t)
+#define BUS_PROF_WAKE()         __atomic_add_fetch(&g_bus.wakeups, 1, __ATOMIC_RELAXED)
+void esp_bus_prof_dequeue(const message_t *msg);
+void esp_bus_prof_exec(const pat_node_t *pat, int64_t start_us);
+void esp_bus_prof_depth(uint8_t prio);
+#else
+#define BUS_PROF_STAMP(msg)     ((void)0)
+#define BUS_PROF_EXEC(pat, t)   ((void)0)
+#define BUS_PROF_WAKE()         ((void)0)
+#endif
+
+// Trace ring (compiled out with CONFIG_ESP_BUS_TRACE_SIZE 0)
+#if BUS_TRACE_SIZE > 0
+#define BUS_TRACE(pat, type, len, t, err)   esp_bus_trace(pat, type, len, t, err)
+void esp_bus_trace_boot(void);
+void esp_bus_trace(const pat_node_t *pat, uint8_t type, size_t len, int64_t start_us, esp_err_t err);
+#else
+#define BUS_TRACE(pat, type, len, t, err)   ((void)0)
+#endif
+
 // Processing
-esp_err_t esp_bus_process_request(const char *pattern, const void *req, size_t req_len,
-                                   void *res, size_t res_size, size_t *res_len);
-void esp_bus_dispatch_event(const char *src, const char *evt, const void *data, size_t len);
+bool esp_bus_post(uint8_t prio, message_t *msg, TickType_t ticks);
+bool esp_bus_evict(uint8_t prio);
+void esp_bus_count_drop(pat_node_t *pat, const char *msg);
+void esp_bus_process_message(message_t *msg);
+esp_err_t esp_bus_process_request(const pat_node_t *pat, const void *req, size_t req_len,
+                                   void *res, size_t res_size, size_t *res_len,
+                                   esp_bus_buf_t **res_buf);
+void esp_bus_dispatch_event(const pat_node_t *pat, const void *data, size_t len);
+void esp_bus_dispatch_batch(const void *batch, size_t n);
+void esp_bus_dispatch_conflated(pat_node_t *pat);
+void esp_bus_replay_retained(int sub_id);
+void esp_bus_multi_run(multi_job_t *job);
 
 // Services
-uint32_t esp_bus_calc_next_wait(void);
+int64_t esp_bus_next_deadline_us(void);
 void esp_bus_run_services(void);
+void esp_bus_svc_free_all(void);
 
@@ -0,0 +1,136 @@
+/**
+ * @file esp_bus_prof.c
+ * @brief ESP Bus - Profiler
+ *
+ * With CONFIG_ESP_BUS_PROFILE every interned pattern carries two
+ * histograms: how long its messages waited in a queue, and how long its
+ * handler (or all subscribers of an event together) ran. Messages are
+ * stamped when queued; the serving task records on dequeue and around the
+ * handler call. Updates are relaxed atomics, so readers get a snapshot
+ * that may be a few messages apart between fields.
+ *
+ * Without the option nothing in this file is built and the stamps compile
+ * to nothing; the public API reports ESP_ERR_NOT_SUPPORTED.
+ */
+
+#include "esp_bus_priv.h"
+#include <string.h>
+
+#ifdef CONFIG_ESP_BUS_PROFILE
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+static void hist_add(esp_bus_hist_t *h, int64_t start_us) {
+    int64_t d = esp_bus_now_us() - start_us;
+    uint32_t us = d <= 0 ? 0 : (d > UINT32_MAX ? UINT32_MAX : (uint32_t)d);
+    
+    // Power-of-four buckets: 16, 64, 256 ... us
+    int b = us < 16 ? 0 : (31 - __builtin_clz(us)) / 2 - 1;
+    if (b >= ESP_BUS_HIST_BUCKETS) b = ESP_BUS_HIST_BUCKETS - 1;
+    
+    __atomic_add_fetch(&h->count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&h->sum_us, us, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&h->buckets[b], 1, __ATOMIC_RELAXED);
+    
+    uint32_t max = __atomic_load_n(&h->max_us, __ATOMIC_RELAXED);
+    while (us > max && !__atomic_compare_exchange_n(&h->max_us, &max, us, true,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void esp_bus_prof_dequeue(const message_t *msg) {
+    switch (msg->type) {
+        case MSG_REQ:
+        case MSG_EVT:
+        case MSG_BUF:
+        case MSG_CFL:
+            hist_add(&((pat_node_t *)msg->pat)->prof_lat, msg->t_enq);
+            break;
+        case MSG_BATCH: {
+            const batch_ent_t *ent = msg->data;
+            for (size_t i = 0; i < msg->len; i++) hist_add(&ent[i].pat->prof_lat, msg->t_enq);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void esp_bus_prof_exec(const pat_node_t *pat, int64_t start_us) {
+    hist_add(&((pat_node_t *)pat)->prof_exec, start_us);
+}
+
+void esp_bus_prof_depth(uint8_t prio) {
+    uint16_t depth = uxQueueMessagesWaiting(g_bus.lanes[prio]);
+    uint16_t max = __atomic_load_n(&g_bus.lane_high_water[prio], __ATOMIC_RELAXED);
+    while (depth > max && !__atomic_compare_exchange_n(&g_bus.lane_high_water[prio], &max, depth,
+                                                       true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+static void hist_merge(esp_bus_hist_t *dst, const esp_bus_hist_t *src) {
+    dst->count += __atomic_load_n(&src->count, __ATOMIC_RELAXED);
+    dst->sum_us += __atomic_load_n(&src->sum_us, __ATOMIC_RELAXED);
+    uint32_t max = __atomic_load_n(&src->max_us, __ATOMIC_RELAXED);
+    if (max > dst->max_us) dst->max_us = max;
+    for (int b = 0; b < ESP_BUS_HIST_BUCKETS; b++) {
+        dst->buckets[b] += __atomic_load_n(&src->buckets[b], __ATOMIC_RELAXED);
+    }
+}
+
+esp_err_t esp_bus_stats_get(const char *pattern, esp_bus_stats_t *stats) {
+    if (!g_bus.initialized || !stats) return ESP_ERR_INVALID_ARG;
+    
+    memset(stats, 0, sizeof(*stats));
+    for (int p = 0; p < ESP_BUS_PRIO_MAX; p++) {
+        stats->lane_high_water[p] = __atomic_load_n(&g_bus.lane_high_water[p], __ATOMIC_RELAXED);
+    }
+    stats->wakeups = __atomic_load_n(&g_bus.wakeups, __ATOMIC_RELAXED);
+    int64_t span = esp_bus_now_us() - g_bus.prof_since_us;
+    if (span > 0) stats->wakeups_per_s = (uint32_t)((uint64_t)stats->wakeups * 1000000 / span);
+    
+    // Patterns are only freed by deinit
+    bool found = false;
+    for (size_t b = 0; b < ESP_BUS_PAT_BUCKETS; b++) {
+        for (pat_node_t *p = __atomic_load_n(&g_bus.pats[b], __ATOMIC_ACQUIRE); p; p = p->next) {
+            if (pattern && !esp_bus_match_pattern(pattern, p->pattern)) continue;
+            hist_merge(&stats->latency, &p->prof_lat);
+            hist_merge(&stats->exec, &p->prof_exec);
+            found = true;
+        }
+    }
+    return (found || !pattern) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t esp_bus_stats_reset(void) {
+    if (!g_bus.initialized) return ESP_ERR_INVALID_ARG;
+    
+    for (size_t b = 0; b < ESP_BUS_PAT_BUCKETS; b++) {
+        for (pat_node_t *p = __atomic_load_n(&g_bus.pats[b], __ATOMIC_ACQUIRE); p; p = p->next) {
+            memset(&p->prof_lat, 0, sizeof(p->prof_lat));
+            memset(&p->prof_exec, 0, sizeof(p->prof_exec));
+        }
+    }
+    memset(g_bus.lane_high_water, 0, sizeof(g_bus.lane_high_water));
+    __atomic_store_n(&g_bus.wakeups, 0, __ATOMIC_RELAXED);
+    g_bus.prof_since_us = esp_bus_now_us();
+    return ESP_OK;
+}
+
+#else
+
+esp_err_t esp_bus_stats_get(const char *pattern, esp_bus_stats_t *stats) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_bus_stats_reset(void) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
@@ -0,0 +1,104 @@
+/**
+ * @file esp_bus_rcu.c
+ * @brief ESP Bus - Lock-free read sections and deferred reclamation
+ *
+ * The module table, the subscription index and routes are changed only
+ * under g_bus.mutex, by publishing fully built nodes with release stores.
+ * Readers on any task or core take no lock: they wrap their traversal in
+ * esp_bus_rcu_lock()/esp_bus_rcu_unlock(). Writers retire what they unlink
+ * instead of freeing it, and the bus task frees it at its quiescent point
+ * once no read section that could still see it is open.
+ *
+ * Read sections count themselves in one of two slots picked by the parity
+ * of the epoch. The bus task advances the epoch only when the slot of the
+ * previous epoch is empty, so a node retired in epoch e is unreachable
+ * once the epoch reaches e + 2.
+ */
+
+#include "esp_bus_priv.h"
+#include <stdlib.h>
+
+// ============================================================================
+// Readers
+// ============================================================================
+
+uint32_t esp_bus_rcu_lock(void) {
+    while (1) {
+        uint32_t e = __atomic_load_n(&g_bus.rcu_epoch, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&g_bus.rcu_readers[e & 1], 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&g_bus.rcu_epoch, __ATOMIC_SEQ_CST) == e) return e & 1;
+        
+        // Epoch moved before we were counted: retry in the current slot
+        __atomic_sub_fetch(&g_bus.rcu_readers[e & 1], 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+void esp_bus_rcu_unlock(uint32_t slot) {
+    __atomic_sub_fetch(&g_bus.rcu_readers[slot], 1, __ATOMIC_SEQ_CST);
+}
+
+// ============================================================================
+// Writers
+// ============================================================================
+
+// Caller holds g_bus.mutex and has already unlinked the node
+void esp_bus_retire(rcu_head_t *head, void (*fn)(void *)) {
+    head->fn = fn;
+    head->epoch = __atomic_load_n(&g_bus.rcu_epoch, __ATOMIC_SEQ_CST);
+    head->next = g_bus.retired;
+    __atomic_store_n(&g_bus.retired, head, __ATOMIC_RELEASE);
+    
+    // Let the bus task reach its quiescent point soon
+    if (g_bus.wake) xSemaphoreGive(g_bus.wake);
+}
+
+// ============================================================================
+// Reclamation (bus task, outside any read section)
+// ============================================================================
+
+// Returns true while retired nodes wait for a reader to leave
+bool esp_bus_rcu_reclaim(void) {
+    if (!__atomic_load_n(&g_bus.retired, __ATOMIC_ACQUIRE)) return false;
+    
+    // Two grace periods if no reader holds them back
+    for (int i = 0; i < 2; i++) {
+        uint32_t e = __atomic_load_n(&g_bus.rcu_epoch, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&g_bus.rcu_readers[(e + 1) & 1], __ATOMIC_SEQ_CST) != 0) break;
+        __atomic_store_n(&g_bus.rcu_epoch, e + 1, __ATOMIC_SEQ_CST);
+    }
+    uint32_t now = __atomic_load_n(&g_bus.rcu_epoch, __ATOMIC_SEQ_CST);
+    
+    rcu_head_t *done = NULL;
+    xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
+    rcu_head_t **pp = &g_bus.retired;
+    while (*pp) {
+        rcu_head_t *h = *pp;
+        if ((int32_t)(now - h->epoch) >= 2) {
+            *pp = h->next;
+            h->next = done;
+            done = h;
+        } else {
+            pp = &h->next;
+        }
+    }
+    bool pending = g_bus.retired != NULL;
+    xSemaphoreGive(g_bus.mutex);
+    
+    while (done) {
+        rcu_head_t *next = done->next;
+        done->fn(done);
+        done = next;
+    }
+    return pending;
+}
+
+// No readers are left at deinit
+void esp_bus_rcu_free_all(void) {
+    rcu_head_t *h = g_bus.retired;
+    while (h) {
+        rcu_head_t *next = h->next;
+        h->fn(h);
+        h = next;
+    }
+    g_bus.retired = NULL;
+}
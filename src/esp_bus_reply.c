@@ -0,0 +1,209 @@
+/**
+ * @file esp_bus_reply.c
+ * @brief ESP Bus - Request replies
+ *
+ * A blocking request borrows one of CONFIG_ESP_BUS_REPLY_SLOTS slots, each
+ * with a semaphore created at init. An async request carries a pooled
+ * record with its completion callback instead.
+ *
+ * The handler writes into a buffer owned by the bus; the result is copied
+ * to the caller only while the caller still waits. A caller that times out
+ * moves its slot from PENDING to CANCELLED, after which the serving task
+ * never touches the caller's memory again and frees the slot itself. A
+ * caller that loses that race is at most one copy away from its result.
+ *
+ * A handler with a variable-size answer takes a shared buffer from
+ * esp_bus_res_buf() instead. It goes to an esp_bus_req_buf() caller as is,
+ * and is copied (possibly truncated) for callers with a fixed buffer.
+ */
+
+#include "esp_bus_priv.h"
+#include <string.h>
+
+static portMUX_TYPE s_reply_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// ============================================================================
+// Init / Deinit
+// ============================================================================
+
+esp_err_t esp_bus_reply_init(void) {
+    for (int i = 0; i < BUS_REPLY_SLOTS; i++) {
+        g_bus.replies[i].done = xSemaphoreCreateBinary();
+        if (!g_bus.replies[i].done) {
+            esp_bus_reply_deinit();
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    g_bus.reply_free = (BUS_REPLY_SLOTS == 32) ? UINT32_MAX : (1u << BUS_REPLY_SLOTS) - 1;
+    return ESP_OK;
+}
+
+void esp_bus_reply_deinit(void) {
+    for (int i = 0; i < BUS_REPLY_SLOTS; i++) {
+        if (g_bus.replies[i].done) {
+            vSemaphoreDelete(g_bus.replies[i].done);
+            g_bus.replies[i].done = NULL;
+        }
+    }
+    g_bus.reply_free = 0;
+}
+
+// ============================================================================
+// Slots
+// ============================================================================
+
+msg_reply_t *esp_bus_reply_get(void *buf, size_t size, size_t *len) {
+    msg_reply_t *r = NULL;
+    
+    portENTER_CRITICAL_SAFE(&s_reply_lock);
+    if (g_bus.reply_free) {
+        int i = __builtin_ctz(g_bus.reply_free);
+        g_bus.reply_free &= ~(1u << i);
+        r = &g_bus.replies[i];
+    }
+    portEXIT_CRITICAL_SAFE(&s_reply_lock);
+    if (!r) return NULL;
+    
+    r->state = REPLY_PENDING;
+    r->buf = buf;
+    r->size = size;
+    r->len = len;
+    r->result = ESP_OK;
+    r->out = NULL;
+    r->fn = NULL;
+    r->ctx = NULL;
+    return r;
+}
+
+msg_reply_t *esp_bus_reply_async(size_t size, esp_bus_done_fn fn, void *ctx) {
+    msg_reply_t *r = esp_bus_alloc(sizeof(msg_reply_t));
+    if (!r) return NULL;
+    
+    memset(r, 0, sizeof(*r));
+    r->size = size;
+    r->fn = fn;
+    r->ctx = ctx;
+    return r;
+}
+
+void esp_bus_reply_release(msg_reply_t *r) {
+    if (r->fn) {
+        esp_bus_free(r);
+        return;
+    }
+    
+    int i = r - g_bus.replies;
+    portENTER_CRITICAL_SAFE(&s_reply_lock);
+    g_bus.reply_free |= 1u << i;
+    portEXIT_CRITICAL_SAFE(&s_reply_lock);
+}
+
+// ============================================================================
+// Requester side
+// ============================================================================
+
+esp_err_t esp_bus_reply_wait(msg_reply_t *r, TickType_t ticks) {
+    if (xSemaphoreTake(r->done, ticks) != pdTRUE) {
+        uint32_t expect = REPLY_PENDING;
+        if (__atomic_compare_exchange_n(&r->state, &expect, REPLY_CANCELLED, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            // The serving task frees the slot when it gets to the request
+            return ESP_ERR_TIMEOUT;
+        }
+        // The result is being copied out right now
+        xSemaphoreTake(r->done, portMAX_DELAY);
+    }
+    
+    esp_err_t err = r->result;
+    esp_bus_reply_release(r);
+    return err;
+}
+
+// ============================================================================
+// Serving side
+// ============================================================================
+
+static void reply_complete(msg_reply_t *r, esp_err_t err, const void *res, size_t copy,
+                           const size_t *len, esp_bus_buf_t *buf) {
+    if (r->fn) {
+        r->fn(err, copy ? res : NULL, copy, r->ctx);
+        esp_bus_buf_release(buf);
+        esp_bus_reply_release(r);
+        return;
+    }
+    
+    uint32_t expect = REPLY_PENDING;
+    if (!__atomic_compare_exchange_n(&r->state, &expect, REPLY_WRITING, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // Requester timed out: nobody reads this result
+        esp_bus_buf_release(buf);
+        esp_bus_reply_release(r);
+        return;
+    }
+    
+    if (r->out) {
+        *r->out = buf;          // Handed over without a copy
+        buf = NULL;
+    } else if (r->buf && copy) {
+        memcpy(r->buf, res, copy);
+    }
+    if (r->len && len) *r->len = *len;
+    r->result = err;
+    esp_bus_buf_release(buf);
+    __atomic_store_n(&r->state, REPLY_DONE, __ATOMIC_RELEASE);
+    xSemaphoreGive(r->done);
+}
+
+// Completes a reply with a result that is not a handler's response
+void esp_bus_reply_finish(msg_reply_t *r, esp_err_t err, const void *res, size_t copy, size_t len) {
+    reply_complete(r, err, res, copy, &len, NULL);
+}
+
+// Runs the handler into a bus-owned buffer and completes the reply
+void esp_bus_reply_serve(const pat_node_t *pat, const void *req, size_t req_len, msg_reply_t *r) {
+    void *res = NULL;
+    if (r->size) {
+        res = esp_bus_alloc(r->size);
+        if (!res) {
+            esp_bus_report_error(pat->pattern, ESP_ERR_NO_MEM, "no memory");
+            reply_complete(r, ESP_ERR_NO_MEM, NULL, 0, NULL, NULL);
+            return;
+        }
+        memset(res, 0, r->size);
+    }
+    
+    size_t res_len = SIZE_MAX;
+    esp_bus_buf_t *buf = NULL;
+    esp_err_t err = esp_bus_process_request(pat, req, req_len, res, r->size, &res_len, &buf);
+    
+    if (buf) {
+        // Variable-size answer: copied into a fixed buffer only if one was given
+        res_len = buf->len;
+        size_t copy = (r->fn || res_len < r->size) ? res_len : r->size;
+        reply_complete(r, err, buf->data, copy, &res_len, buf);
+    } else {
+        // A handler that reports no length gets its whole buffer copied
+        bool reported = (res_len != SIZE_MAX);
+        size_t copy = (reported && res_len < r->size) ? res_len : r->size;
+        reply_complete(r, err, res, copy, reported ? &res_len : NULL, NULL);
+    }
+    esp_bus_free(res);
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+esp_bus_buf_t *esp_bus_res_buf(size_t size) {
+    int idx = esp_bus_worker_index();
+    if (idx < 0) return NULL;
+    
+    res_slot_t *slot = &g_bus.res_slots[idx];
+    if (!slot->wanted) return NULL;
+    
+    esp_bus_buf_t *buf = esp_bus_buf_alloc(size);
+    if (!buf) return NULL;
+    esp_bus_buf_release(slot->buf);
+    slot->buf = buf;
+    return buf;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file esp_bus_static.c
+ * @brief ESP Bus - Static descriptors
+ *
+ * ESP_BUS_MODULE_DEFINE() and friends drop const descriptors into linker
+ * sections (see linker.lf). Modules land in one section per name, sorted
+ * by the linker, so the table is a ready-made binary search array in
+ * flash: esp_bus_init() only checks it and the bus uses the entries in
+ * place. Static subscriptions and routes are installed at init through
+ * the regular index.
+ */
+
+#include "esp_bus_priv.h"
+#include <string.h>
+
+static const char *TAG = "esp_bus";
+
+extern const esp_bus_module_t _esp_bus_mod_start[], _esp_bus_mod_end[];
+extern const esp_bus_sub_desc_t _esp_bus_sub_start[], _esp_bus_sub_end[];
+extern const esp_bus_route_desc_t _esp_bus_route_start[], _esp_bus_route_end[];
+
+// False if the linker did not sort the table; lookups fall back to a scan
+static bool s_sorted;
+
+// ============================================================================
+// Modules
+// ============================================================================
+
+esp_err_t esp_bus_static_check(void) {
+    size_t cnt = _esp_bus_mod_end - _esp_bus_mod_start;
+    s_sorted = true;
+    
+    for (size_t i = 0; i < cnt; i++) {
+        const esp_bus_module_t *m = &_esp_bus_mod_start[i];
+        if (strlen(m->name) >= ESP_BUS_NAME_MAX || m->worker > BUS_WORKERS) {
+            ESP_LOGE(TAG, "Static module '%s' invalid", m->name);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (i > 0 && strcmp(_esp_bus_mod_start[i - 1].name, m->name) >= 0) s_sorted = false;
+    }
+    
+    if (!s_sorted) {
+        // Off the fast path, so a quadratic duplicate check is fine
+        ESP_LOGW(TAG, "Static module table not sorted");
+        for (size_t i = 0; i < cnt; i++) {
+            for (size_t j = i + 1; j < cnt; j++) {
+                if (strcmp(_esp_bus_mod_start[i].name, _esp_bus_mod_start[j].name) == 0) {
+                    ESP_LOGE(TAG, "Static module '%s' defined twice", _esp_bus_mod_start[i].name);
+                    return ESP_ERR_INVALID_STATE;
+                }
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+const esp_bus_module_t *esp_bus_static_find(const char *name) {
+    const esp_bus_module_t *base = _esp_bus_mod_start;
+    size_t cnt = _esp_bus_mod_end - _esp_bus_mod_start;
+    
+    if (!s_sorted) {
+        for (size_t i = 0; i < cnt; i++) {
+            if (strcmp(base[i].name, name) == 0) return &base[i];
+        }
+        return NULL;
+    }
+    
+    while (cnt > 0) {
+        size_t half = cnt / 2;
+        int c = strcmp(base[half].name, name);
+        if (c == 0) return &base[half];
+        if (c < 0) {
+            base += half + 1;
+            cnt -= half + 1;
+        } else {
+            cnt = half;
+        }
+    }
+    return NULL;
+}
+
+bool esp_bus_static_owns(const esp_bus_module_t *mod) {
+    return mod >= _esp_bus_mod_start && mod < _esp_bus_mod_end;
+}
+
+size_t esp_bus_static_modules(const esp_bus_module_t **mods) {
+    *mods = _esp_bus_mod_start;
+    return _esp_bus_mod_end - _esp_bus_mod_start;
+}
+
+// ============================================================================
+// Subscriptions and routes
+// ============================================================================
+
+esp_err_t esp_bus_static_install(void) {
+    for (const esp_bus_sub_desc_t *s = _esp_bus_sub_start; s < _esp_bus_sub_end; s++) {
+        if (esp_bus_sub(s->pattern, s->handler, s->ctx) < 0) {
+            ESP_LOGE(TAG, "Static sub '%s' failed", s->pattern ? s->pattern : "");
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    
+    for (const esp_bus_route_desc_t *r = _esp_bus_route_start; r < _esp_bus_route_end; r++) {
+        esp_err_t err = esp_bus_on(r->evt_pattern, r->req_pattern, r->req_data, r->req_len);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Static route '%s' failed", r->evt_pattern ? r->evt_pattern : "");
+            return err;
+        }
+    }
+    return ESP_OK;
+}
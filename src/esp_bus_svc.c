@@ -1,63 +1,230 @@
 /**
  * @file esp_bus_svc.c
  * @brief ESP Bus - Service Loop (tick, timer)
+ *
+ * Armed services sit in a binary min-heap keyed on next_run_us, so the next
+ * deadline is heap[0] and insert/cancel/re-arm are O(log n). Nodes are also
+ * chained in a small id hash for lookup. The bus task pops due nodes under
+ * the mutex and runs the callback without it; a node cancelled while its
+ * callback runs is freed once the callback returns.
+ *
+ * Repeating services follow a fixed timeline (next += interval); a service
+ * that falls a full period behind applies its overrun policy.
  */
 
 #include "esp_bus_priv.h"
 #include <stdlib.h>
 
+#define SVC_HEAP_MIN 8
+
 // ============================================================================
-// Service Processing
+// Heap
 // ============================================================================
 
-uint32_t esp_bus_calc_next_wait(void) {
-    int64_t now = esp_bus_now_us();
-    int64_t min_wait = 100000; // 100ms max
-    
-    svc_node_t *s;
-    SLIST_FOREACH(s, &g_bus.services, next) {
-        if (s->next_run_us > 0) {
-            int64_t wait = s->next_run_us - now;
-            if (wait < 1000) wait = 1000; // Min 1ms to avoid WDT
-            if (wait < min_wait) min_wait = wait;
+static void heap_set(size_t i, svc_node_t *s) {
+    g_bus.svc_heap[i] = s;
+    s->heap_idx = (int32_t)i;
+    if (i == 0) __atomic_store_n(&g_bus.svc_next_us, s->next_run_us, __ATOMIC_RELAXED);
+}
+
+static void heap_up(size_t i) {
+    svc_node_t *s = g_bus.svc_heap[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (g_bus.svc_heap[parent]->next_run_us <= s->next_run_us) break;
+        heap_set(i, g_bus.svc_heap[parent]);
+        i = parent;
+    }
+    heap_set(i, s);
+}
+
+static void heap_down(size_t i) {
+    svc_node_t *s = g_bus.svc_heap[i];
+    size_t n = g_bus.svc_cnt;
+    while (1) {
+        size_t child = 2 * i + 1;
+        if (child >= n) break;
+        if (child + 1 < n && g_bus.svc_heap[child + 1]->next_run_us < g_bus.svc_heap[child]->next_run_us) {
+            child++;
         }
+        if (s->next_run_us <= g_bus.svc_heap[child]->next_run_us) break;
+        heap_set(i, g_bus.svc_heap[child]);
+        i = child;
+    }
+    heap_set(i, s);
+}
+
+static bool heap_push(svc_node_t *s) {
+    if (g_bus.svc_cnt == g_bus.svc_cap) {
+        size_t cap = g_bus.svc_cap ? g_bus.svc_cap * 2 : SVC_HEAP_MIN;
+        svc_node_t **heap = realloc(g_bus.svc_heap, cap * sizeof(svc_node_t *));
+        if (!heap) return false;
+        g_bus.svc_heap = heap;
+        g_bus.svc_cap = cap;
     }
+    heap_set(g_bus.svc_cnt++, s);
+    heap_up(g_bus.svc_cnt - 1);
+    return true;
+}
+
+static void heap_remove(svc_node_t *s) {
+    size_t i = (size_t)s->heap_idx;
+    svc_node_t *last = g_bus.svc_heap[--g_bus.svc_cnt];
+    s->heap_idx = -1;
+    if (g_bus.svc_cnt == 0) __atomic_store_n(&g_bus.svc_next_us, 0, __ATOMIC_RELAXED);
+    if (last == s) return;
     
-    uint32_t wait_ms = (uint32_t)(min_wait / 1000);
-    return wait_ms > 0 ? wait_ms : 1; // Ensure at least 1ms
+    heap_set(i, last);
+    heap_up(i);
+    heap_down((size_t)last->heap_idx);
+}
+
+// Re-position after next_run_us changed
+static void heap_fix(svc_node_t *s) {
+    heap_up((size_t)s->heap_idx);
+    heap_down((size_t)s->heap_idx);
+}
+
+// ============================================================================
+// Id Lookup
+// ============================================================================
+
+static svc_node_t **id_slot(int id) {
+    svc_node_t **pp = &g_bus.svc_ids[(unsigned)id & (ESP_BUS_SVC_BUCKETS - 1)];
+    while (*pp && (*pp)->id != id) pp = &(*pp)->id_next;
+    return pp;
+}
+
+static void svc_free(svc_node_t *s) {
+    svc_node_t **pp = id_slot(s->id);
+    if (*pp) *pp = s->id_next;
+    free(s);
+}
+
+// ============================================================================
+// Timeline
+// ============================================================================
+
+// s->next_run_us still holds the deadline of the run that just finished
+static void svc_reschedule(svc_node_t *s, int64_t now) {
+    int64_t period = (int64_t)s->interval_ms * 1000;
+    if (period == 0) {
+        s->next_run_us = now + 1;   // Once per pass
+        return;
+    }
+    
+    int64_t next = s->next_run_us + period;
+    if (next > now) {
+        s->catch_up = 0;
+        s->next_run_us = next;
+        return;
+    }
+    
+    uint32_t behind = (uint32_t)((now - next) / period) + 1;    // Periods already due
+    switch (s->policy) {
+        case ESP_BUS_OVERRUN_CATCH_UP:
+            if (s->catch_up < s->max_catch_up) {
+                s->catch_up++;
+                s->next_run_us = next;
+                return;
+            }
+            // Cap reached: drop the rest
+            // fallthrough
+        case ESP_BUS_OVERRUN_SKIP:
+        default:
+            s->catch_up = 0;
+            s->missed += behind;
+            s->next_run_us = next + (int64_t)behind * period;
+            break;
+        case ESP_BUS_OVERRUN_COALESCE:
+            // One immediate run stands for all of them
+            s->missed += behind - 1;
+            s->next_run_us = now;
+            break;
+    }
+}
+
+// ============================================================================
+// Service Processing
+// ============================================================================
+
+// Earliest service deadline, 0 if no service is armed. Kept by the heap, so
+// the bus task reads it without the mutex.
+int64_t esp_bus_next_deadline_us(void) {
+    return __atomic_load_n(&g_bus.svc_next_us, __ATOMIC_RELAXED);
 }
 
 void esp_bus_run_services(void) {
     int64_t now = esp_bus_now_us();
     
-    svc_node_t *s, *tmp;
-    SLIST_FOREACH_SAFE(s, &g_bus.services, next, tmp) {
-        if (s->next_run_us <= 0) continue;
+    xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
+    while (g_bus.svc_cnt > 0 && g_bus.svc_heap[0]->next_run_us <= now) {
+        svc_node_t *s = g_bus.svc_heap[0];
+        heap_remove(s);
+        g_bus.svc_running = s;
         
-        if (now >= s->next_run_us) {
-            s->fn(s->ctx);
-            
-            if (s->repeat) {
-                s->next_run_us = now + (int64_t)s->interval_ms * 1000;
-            } else {
-                s->next_run_us = 0;
-            }
+        int64_t late = esp_bus_now_us() - s->next_run_us;
+        if (late < 0) late = 0;
+        if (late > UINT32_MAX) late = UINT32_MAX;
+        s->runs++;
+        s->late_sum_us += (uint64_t)late;
+        if ((uint32_t)late > s->late_max_us) s->late_max_us = (uint32_t)late;
+        
+        xSemaphoreGive(g_bus.mutex);
+#ifdef CONFIG_PM_ENABLE
+        bool pm = s->pm;
+        if (pm) esp_pm_lock_acquire(g_bus.pm_lock);
+        s->fn(s->ctx);
+        if (pm) esp_pm_lock_release(g_bus.pm_lock);
+#else
+        s->fn(s->ctx);
+#endif
+        xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
+        
+        g_bus.svc_running = NULL;
+        if (s->cancelled) {
+            if (s->heap_idx >= 0) heap_remove(s);
+            svc_free(s);
+        } else if (s->heap_idx >= 0) {
+            // Re-armed by its own callback
+        } else if (s->repeat) {
+            svc_reschedule(s, esp_bus_now_us());
+            if (!heap_push(s)) svc_free(s);
+        } else {
+            svc_free(s);
         }
     }
-    
-    // Clean up expired one-shot timers
-    SLIST_FOREACH_SAFE(s, &g_bus.services, next, tmp) {
-        if (!s->repeat && s->next_run_us == 0) {
-            SLIST_REMOVE(&g_bus.services, s, svc_node, next);
+    xSemaphoreGive(g_bus.mutex);
+}
+
+void esp_bus_svc_free_all(void) {
+    for (size_t b = 0; b < ESP_BUS_SVC_BUCKETS; b++) {
+        svc_node_t *s = g_bus.svc_ids[b];
+        while (s) {
+            svc_node_t *next = s->id_next;
             free(s);
+            s = next;
         }
+        g_bus.svc_ids[b] = NULL;
     }
+    free(g_bus.svc_heap);
+    g_bus.svc_heap = NULL;
+    g_bus.svc_cnt = 0;
+    g_bus.svc_next_us = 0;
+    g_bus.svc_cap = 0;
 }
 
 // ============================================================================
 // Internal Helper
 // ============================================================================
 
+// Wake the bus task if the earliest deadline moved and it may be sleeping
+static void wake_if_first(const svc_node_t *s) {
+    if (s->heap_idx == 0 && xTaskGetCurrentTaskHandle() != g_bus.task) {
+        esp_bus_trigger();
+    }
+}
+
 static int add_service(esp_bus_svc_fn fn, uint32_t interval_ms, void *ctx, bool repeat) {
     if (!g_bus.initialized || !fn) return -1;
     
@@ -76,11 +243,19 @@ static int add_service(esp_bus_svc_fn fn, uint32_t interval_ms, void *ctx, bool
     node->next_run_us = esp_bus_now_us() + (int64_t)interval_ms * 1000;
     node->repeat = repeat;
     
-    SLIST_INSERT_HEAD(&g_bus.services, node, next);
-    xSemaphoreGive(g_bus.mutex);
+    if (!heap_push(node)) {
+        xSemaphoreGive(g_bus.mutex);
+        free(node);
+        return -1;
+    }
+    svc_node_t **slot = &g_bus.svc_ids[(unsigned)node->id & (ESP_BUS_SVC_BUCKETS - 1)];
+    node->id_next = *slot;
+    *slot = node;
     
-    esp_bus_trigger();
-    return node->id;
+    int id = node->id;
+    wake_if_first(node);
+    xSemaphoreGive(g_bus.mutex);
+    return id;
 }
 
 static void remove_service(int id) {
@@ -88,12 +263,13 @@ static void remove_service(int id) {
     
     xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
     
-    svc_node_t *node;
-    SLIST_FOREACH(node, &g_bus.services, next) {
-        if (node->id == id) {
-            SLIST_REMOVE(&g_bus.services, node, svc_node, next);
-            free(node);
-            break;
+    svc_node_t *node = *id_slot(id);
+    if (node && !node->cancelled) {
+        if (node == g_bus.svc_running) {
+            node->cancelled = true;     // Freed when the callback returns
+        } else {
+            if (node->heap_idx >= 0) heap_remove(node);
+            svc_free(node);
         }
     }
     
@@ -124,15 +300,81 @@ void esp_bus_cancel(int id) {
     remove_service(id);
 }
 
+esp_err_t esp_bus_rearm(int id, uint32_t delay_ms) {
+    if (!g_bus.initialized || id < 0) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
+    
+    svc_node_t *node = *id_slot(id);
+    if (!node || node->cancelled) {
+        xSemaphoreGive(g_bus.mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    node->next_run_us = esp_bus_now_us() + (int64_t)delay_ms * 1000;
+    if (node->heap_idx >= 0) {
+        heap_fix(node);
+    } else if (!heap_push(node)) {
+        // Running node that cannot be queued: drop it like an expired one-shot
+        node->cancelled = true;
+        xSemaphoreGive(g_bus.mutex);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    wake_if_first(node);
+    xSemaphoreGive(g_bus.mutex);
+    return ESP_OK;
+}
+
+esp_err_t esp_bus_svc_policy(int id, esp_bus_overrun_t policy, uint8_t max_catch_up) {
+    if (!g_bus.initialized || id < 0 || policy > ESP_BUS_OVERRUN_COALESCE) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
+    svc_node_t *node = *id_slot(id);
+    if (node) {
+        node->policy = (uint8_t)policy;
+        node->max_catch_up = max_catch_up;
+        node->catch_up = 0;
+    }
+    xSemaphoreGive(g_bus.mutex);
+    return node ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t esp_bus_svc_pm(int id, bool max_freq) {
+#ifdef CONFIG_PM_ENABLE
+    if (!g_bus.initialized || id < 0) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
+    svc_node_t *node = *id_slot(id);
+    if (node) node->pm = max_freq;
+    xSemaphoreGive(g_bus.mutex);
+    return node ? ESP_OK : ESP_ERR_NOT_FOUND;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t esp_bus_svc_stats(int id, esp_bus_svc_stats_t *stats) {
+    if (!g_bus.initialized || id < 0 || !stats) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(g_bus.mutex, portMAX_DELAY);
+    svc_node_t *node = *id_slot(id);
+    if (node) {
+        stats->runs = node->runs;
+        stats->missed = node->missed;
+        stats->late_max_us = node->late_max_us;
+        stats->late_avg_us = node->runs ? (uint32_t)(node->late_sum_us / node->runs) : 0;
+    }
+    xSemaphoreGive(g_bus.mutex);
+    return node ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
 void esp_bus_trigger(void) {
     if (!g_bus.initialized) return;
-    message_t msg = { .type = MSG_TRIGGER };
-    xQueueSend(g_bus.queue, &msg, 0);
+    xSemaphoreGive(g_bus.wake);
 }
 
 void esp_bus_trigger_isr(BaseType_t *woken) {
     if (!g_bus.initialized) return;
-    message_t msg = { .type = MSG_TRIGGER };
-    xQueueSendFromISR(g_bus.queue, &msg, woken);
+    xSemaphoreGiveFromISR(g_bus.wake, woken);
 }
-
@@ -0,0 +1,148 @@
+/**
+ * @file esp_bus_trace.c
+ * @brief ESP Bus - Trace ring
+ *
+ * Fixed-size ring of 16-byte binary records, one per request served, event
+ * dispatched and event dropped. Writers claim a slot with one atomic add
+ * and fill it in place: no lock, no allocation, two timer reads shared with
+ * the profiler. The newest CONFIG_ESP_BUS_TRACE_SIZE records are kept.
+ *
+ * The ring sits in no-init RAM behind a magic word, so it survives a
+ * software reset or panic reboot and the previous run can be read back
+ * after boot. esp_bus_init() appends a BOOT record instead of clearing it.
+ */
+
+#include "esp_bus_priv.h"
+#include "esp_attr.h"
+#include "esp_rom_sys.h"
+#include <string.h>
+
+#if BUS_TRACE_SIZE > 0
+
+// Rounded up to a power of two so a slot is one mask away
+#define TRACE_CAP   (BUS_TRACE_SIZE <= 16 ? 16 : BUS_TRACE_SIZE <= 32 ? 32 : \
+                     BUS_TRACE_SIZE <= 64 ? 64 : BUS_TRACE_SIZE <= 128 ? 128 : \
+                     BUS_TRACE_SIZE <= 256 ? 256 : BUS_TRACE_SIZE <= 512 ? 512 : 1024)
+#define TRACE_MAGIC (0xB0570000u | TRACE_CAP)
+
+typedef struct {
+    uint32_t magic;             // TRACE_MAGIC once the ring holds valid records
+    uint32_t head;              // Total records written, wraps
+    esp_bus_trace_rec_t rec[TRACE_CAP];
+} trace_ring_t;
+
+static __NOINIT_ATTR trace_ring_t s_trace;
+
+static inline uint16_t sat16(uint64_t v) {
+    return v > UINT16_MAX ? UINT16_MAX : (uint16_t)v;
+}
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+void esp_bus_trace_boot(void) {
+    if (s_trace.magic != TRACE_MAGIC) {
+        // Power-on or a different layout: nothing worth keeping
+        memset(&s_trace, 0, sizeof(s_trace));
+        s_trace.magic = TRACE_MAGIC;
+    }
+    
+    uint32_t i = __atomic_fetch_add(&s_trace.head, 1, __ATOMIC_RELAXED) & (TRACE_CAP - 1);
+    s_trace.rec[i] = (esp_bus_trace_rec_t) {
+        .ts_us = (uint32_t)esp_bus_now_us(),
+        .type = ESP_BUS_TRACE_BOOT,
+        .task = 0xff,
+    };
+}
+
+void esp_bus_trace(const pat_node_t *pat, uint8_t type, size_t len, int64_t start_us, esp_err_t err) {
+    int64_t now = esp_bus_now_us();
+    int task = esp_bus_worker_index();
+    
+    uint32_t i = __atomic_fetch_add(&s_trace.head, 1, __ATOMIC_RELAXED) & (TRACE_CAP - 1);
+    esp_bus_trace_rec_t *r = &s_trace.rec[i];
+    r->ts_us = (uint32_t)start_us;
+    r->pat_id = pat->id;
+    r->type = type;
+    r->task = task < 0 ? 0xff : (uint8_t)task;
+    r->len = sat16(len);
+    r->dur_us = sat16(now > start_us ? now - start_us : 0);
+    r->err = err;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+size_t esp_bus_trace_read(esp_bus_trace_rec_t *out, size_t max) {
+    if (!out || s_trace.magic != TRACE_MAGIC) return 0;
+    
+    uint32_t head = __atomic_load_n(&s_trace.head, __ATOMIC_ACQUIRE);
+    size_t n = head < TRACE_CAP ? head : TRACE_CAP;
+    if (n > max) n = max;
+    
+    for (size_t k = 0; k < n; k++) {
+        out[k] = s_trace.rec[(head - n + k) & (TRACE_CAP - 1)];
+    }
+    return n;
+}
+
+// Patterns are only freed by deinit; safe to walk without the mutex
+static const char *pattern_name(uint16_t id) {
+    if (!g_bus.initialized) return NULL;
+    for (size_t b = 0; b < ESP_BUS_PAT_BUCKETS; b++) {
+        for (pat_node_t *p = __atomic_load_n(&g_bus.pats[b], __ATOMIC_ACQUIRE); p; p = p->next) {
+            if (p->id == id) return p->pattern;
+        }
+    }
+    return NULL;
+}
+
+void esp_bus_trace_dump(void) {
+    static const char *const kinds[] = { "BOOT", "REQ", "EVT", "DROP" };
+    
+    if (s_trace.magic != TRACE_MAGIC) {
+        esp_rom_printf("esp_bus trace: empty\n");
+        return;
+    }
+    
+    uint32_t head = __atomic_load_n(&s_trace.head, __ATOMIC_ACQUIRE);
+    uint32_t n = head < TRACE_CAP ? head : TRACE_CAP;
+    esp_rom_printf("esp_bus trace: %u records\n", n);
+    
+    // Ids restart at every init: only records after the newest BOOT belong
+    // to the current pattern table. With no BOOT left, all of them do.
+    uint32_t cur = 0;
+    for (uint32_t k = n; k > 0; k--) {
+        if (s_trace.rec[(head - n + k - 1) & (TRACE_CAP - 1)].type == ESP_BUS_TRACE_BOOT) {
+            cur = k;
+            break;
+        }
+    }
+    
+    for (uint32_t k = 0; k < n; k++) {
+        const esp_bus_trace_rec_t *r = &s_trace.rec[(head - n + k) & (TRACE_CAP - 1)];
+        const char *name = NULL;
+        if (r->type == ESP_BUS_TRACE_BOOT) {
+            name = "-";
+        } else if (k >= cur) {
+            name = pattern_name(r->pat_id);
+            if (!name) name = "?";
+        }
+        esp_rom_printf("%u %s t%u #%u%s%s len %u %u us err 0x%x\n",
+                       r->ts_us, r->type < 4 ? kinds[r->type] : "?", r->task, r->pat_id,
+                       name ? " " : "", name ? name : "", r->len, r->dur_us, (unsigned)r->err);
+    }
+}
+
+#else
+
+size_t esp_bus_trace_read(esp_bus_trace_rec_t *out, size_t max) {
+    return 0;
+}
+
+void esp_bus_trace_dump(void) {
+}
+
+#endif
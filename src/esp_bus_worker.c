@@ -0,0 +1,109 @@
+/**
+ * @file esp_bus_worker.c
+ * @brief ESP Bus - Worker tasks
+ *
+ * Optional request workers (CONFIG_ESP_BUS_WORKERS), each pinned to a core
+ * with a queue of its own. Requests for a module with a worker affinity go
+ * to that worker instead of the bus task, so a slow handler there does not
+ * hold up modules served elsewhere. A module is served by exactly one task,
+ * which keeps its requests in order and its handler single-threaded.
+ * Subscriptions moved with esp_bus_sub_offload() get their events copied
+ * to a worker the same way. Dispatch, route matching and services stay on
+ * the bus task.
+ */
+
+#include "esp_bus_priv.h"
+
+// ============================================================================
+// Task
+// ============================================================================
+
+#if BUS_WORKERS > 0
+static void worker_task(void *arg) {
+    QueueHandle_t queue = arg;
+    message_t msg;
+    
+    while (1) {
+        if (xQueueReceive(queue, &msg, portMAX_DELAY) == pdTRUE) {
+            esp_bus_process_message(&msg);
+        }
+    }
+}
+#endif
+
+// ============================================================================
+// Init / Deinit
+// ============================================================================
+
+esp_err_t esp_bus_worker_init(void) {
+#if BUS_WORKERS > 0
+    for (int i = 0; i < BUS_WORKERS; i++) {
+        char name[] = "esp_bus_w0";
+        name[9] += i + 1;
+        
+        g_bus.worker_queue[i] = xQueueCreate(BUS_QUEUE_SIZE, sizeof(message_t));
+        if (!g_bus.worker_queue[i] ||
+            xTaskCreatePinnedToCore(worker_task, name, BUS_STACK_SIZE, g_bus.worker_queue[i],
+                                    BUS_PRIORITY, &g_bus.worker_task[i],
+                                    i % portNUM_PROCESSORS) != pdPASS) {
+            esp_bus_worker_deinit();
+            return ESP_ERR_NO_MEM;
+        }
+    }
+#endif
+    return ESP_OK;
+}
+
+void esp_bus_worker_deinit(void) {
+#if BUS_WORKERS > 0
+    for (int i = 0; i < BUS_WORKERS; i++) {
+        if (g_bus.worker_task[i]) {
+            vTaskDelete(g_bus.worker_task[i]);
+            g_bus.worker_task[i] = NULL;
+        }
+        if (g_bus.worker_queue[i]) {
+            // Drop queued requests still holding payloads
+            message_t msg;
+            while (xQueueReceive(g_bus.worker_queue[i], &msg, 0) == pdTRUE) {
+                esp_bus_msg_discard(&msg);
+            }
+            vQueueDelete(g_bus.worker_queue[i]);
+            g_bus.worker_queue[i] = NULL;
+        }
+    }
+#endif
+}
+
+// ============================================================================
+// Routing
+// ============================================================================
+
+QueueHandle_t esp_bus_worker_queue(const pat_node_t *pat) {
+#if BUS_WORKERS > 0
+    const esp_bus_module_t *mod = __atomic_load_n(&pat->mod, __ATOMIC_ACQUIRE);
+    if (mod && mod->worker) return g_bus.worker_queue[mod->worker - 1];
+#endif
+    return NULL;    // Bus task lanes
+}
+
+bool esp_bus_worker_self(QueueHandle_t queue) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+#if BUS_WORKERS > 0
+    for (int i = 0; i < BUS_WORKERS; i++) {
+        if (queue == g_bus.worker_queue[i]) return self == g_bus.worker_task[i];
+    }
+#endif
+    return self == g_bus.task;
+}
+
+// 0 for the bus task, n for worker n, -1 for any other task
+int esp_bus_worker_index(void) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (self == g_bus.task) return 0;
+#if BUS_WORKERS > 0
+    for (int i = 0; i < BUS_WORKERS; i++) {
+        if (self == g_bus.worker_task[i]) return i + 1;
+    }
+#endif
+    return -1;
+}
@@ -7,8 +7,11 @@
 #include "esp_bus.h"
 #include "esp_bus_btn.h"
 #include "esp_bus_led.h"
+#include "esp_bus_bridge.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include "esp_heap_caps.h"
 #include <string.h>
 
@@ -88,6 +91,19 @@ static void test_evt_handler(const char *event, const void *data, size_t len, vo
     test_counter++;
 }
 
+// Parks the bus task on "wait" until slow_release is given
+static SemaphoreHandle_t slow_release = NULL;
+
+static esp_err_t slow_req_handler(const char *action,
+                                   const void *req, size_t req_len,
+                                   void *res, size_t res_size, size_t *res_len,
+                                   void *ctx) {
+    if (strcmp(action, "wait") == 0) {
+        xSemaphoreTake(slow_release, pdMS_TO_TICKS(1000));
+    }
+    return ESP_OK;
+}
+
 // Service callback (different signature from event handler)
 static void test_svc_handler(void *ctx) {
     test_counter++;
@@ -195,6 +211,314 @@ TEST_CASE("esp_bus_req strict mode", "[esp_bus][request]")
     TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
 }
 
+static int async_done_cnt = 0;
+static int async_sum = 0;
+
+static void async_done(esp_err_t err, const void *res, size_t res_len, void *ctx) {
+    if (err == ESP_OK && res && res_len == sizeof(int)) async_sum += *(const int *)res;
+    async_done_cnt++;
+}
+
+static esp_err_t action_inc_handler(const char *action,
+                                     const void *req, size_t req_len,
+                                     void *res, size_t res_size, size_t *res_len,
+                                     void *ctx) {
+    *(int *)ctx += 100;
+    return ESP_OK;
+}
+
+TEST_CASE("schema action handlers bypass on_req", "[esp_bus][request]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    int hits = 0;
+    const esp_bus_action_t actions[] = {
+        { .name = "inc", .handler = action_inc_handler },
+        { .name = "echo" },
+    };
+    esp_bus_module_t mod = {
+        .name = "acts",
+        .on_req = test_req_handler,
+        .ctx = &hits,
+        .actions = actions,
+        .action_cnt = 2,
+    };
+    
+    // Bound before and after registration
+    esp_bus_handle_t inc = esp_bus_resolve("acts.inc");
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req_h(inc, NULL, 0, NULL, 0, NULL, 100));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req("acts.inc", NULL, 0, NULL, 0, NULL, 100));
+    TEST_ASSERT_EQUAL(200, hits);
+    TEST_ASSERT_EQUAL(0, test_counter);
+    
+    // No handler in the schema, or not in the schema: on_req
+    char res[8] = {0};
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req("acts.echo", "ok", 3, res, sizeof(res), NULL, 100));
+    TEST_ASSERT_EQUAL_STRING("ok", res);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_bus_req("acts.fail", NULL, 0, NULL, 0, NULL, 100));
+    TEST_ASSERT_EQUAL(2, test_counter);
+    
+    // Without on_req only schema handlers remain
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("acts"));
+    mod.on_req = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req_h(inc, NULL, 0, NULL, 0, NULL, 100));
+    TEST_ASSERT_EQUAL(300, hits);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, esp_bus_req("acts.echo", NULL, 0, NULL, 0, NULL, 100));
+    TEST_ASSERT_EQUAL(2, test_counter);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("acts"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+static int multi_hits = 0;
+
+static esp_err_t multi_req_handler(const char *action,
+                                   const void *req, size_t req_len,
+                                   void *res, size_t res_size, size_t *res_len,
+                                   void *ctx) {
+    __atomic_add_fetch(&multi_hits, 1, __ATOMIC_RELAXED);
+    if (strcmp(action, "fail") == 0) return ESP_ERR_INVALID_STATE;
+    if (req && req_len == 2 && strcmp(req, "x") != 0) return ESP_ERR_INVALID_ARG;
+    return ESP_OK;
+}
+
+#if CONFIG_ESP_BUS_WORKERS > 0
+// Fans out from worker 1, which also serves one of the targets
+static esp_err_t fan_req_handler(const char *action,
+                                 const void *req, size_t req_len,
+                                 void *res, size_t res_size, size_t *res_len,
+                                 void *ctx) {
+    size_t cnt = 0;
+    esp_err_t err = esp_bus_req_all("grp*.off", NULL, 0, NULL, 0, &cnt, 200);
+    if (res && res_size >= sizeof(cnt)) {
+        memcpy(res, &cnt, sizeof(cnt));
+        *res_len = sizeof(cnt);
+    }
+    return err;
+}
+#endif
+
+TEST_CASE("esp_bus_req_all fans out to matching modules", "[esp_bus][request][multi]")
+{
+    multi_hits = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    const esp_bus_action_t only[] = { { .name = "only" } };
+    esp_bus_module_t mods[] = {
+        { .name = "grp1", .on_req = multi_req_handler },
+        { .name = "grp2", .on_req = multi_req_handler },
+#if CONFIG_ESP_BUS_WORKERS > 0
+        { .name = "grp3", .on_req = multi_req_handler, .worker = 1 },
+#else
+        { .name = "grp3", .on_req = multi_req_handler },
+#endif
+        { .name = "grp4", .on_req = multi_req_handler, .actions = only, .action_cnt = 1 },
+        { .name = "solo", .on_req = multi_req_handler },
+    };
+    for (size_t i = 0; i < sizeof(mods) / sizeof(mods[0]); i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mods[i]));
+    }
+    
+    // grp4's schema has no "off"; results past max are still counted
+    esp_bus_target_res_t res[2];
+    size_t cnt = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req_all("grp*.off", "x", 2, res, 2, &cnt, 500));
+    TEST_ASSERT_EQUAL(3, cnt);
+    TEST_ASSERT_EQUAL(3, multi_hits);
+    TEST_ASSERT_EQUAL_STRING("grp1", res[0].module);
+    TEST_ASSERT_EQUAL(ESP_OK, res[0].err);
+    TEST_ASSERT_EQUAL_STRING("grp2", res[1].module);
+    
+    // First error is the result
+    esp_bus_target_res_t all[8];
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_bus_req_all("grp*.fail", NULL, 0, all, 8, &cnt, 500));
+    TEST_ASSERT_EQUAL(3, cnt);
+    for (size_t i = 0; i < cnt; i++) TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, all[i].err);
+    
+    // Modules without a schema take any action
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req_all("grp*.only", NULL, 0, all, 8, &cnt, 500));
+    TEST_ASSERT_EQUAL(4, cnt);
+    TEST_ASSERT_EQUAL_STRING("grp4", all[3].module);
+    
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, esp_bus_req_all("none*.off", NULL, 0, NULL, 0, NULL, 500));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_req_all("grp*.*", NULL, 0, NULL, 0, NULL, 500));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_req_all("grp", NULL, 0, NULL, 0, NULL, 500));
+    
+#if CONFIG_ESP_BUS_WORKERS > 0
+    // From a worker: its own target runs inline instead of queuing behind it
+    esp_bus_module_t fan = { .name = "fan", .on_req = fan_req_handler, .worker = 1 };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&fan));
+    multi_hits = 0;
+    size_t fan_cnt = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req("fan.go", NULL, 0, &fan_cnt, sizeof(fan_cnt), NULL, 500));
+    TEST_ASSERT_EQUAL(3, fan_cnt);
+    TEST_ASSERT_EQUAL(3, multi_hits);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("fan"));
+#endif
+    
+    // One message, no waiting
+    multi_hits = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req_all("grp*.off", NULL, 0, NULL, 0, NULL, 0));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(3, multi_hits);
+    
+    for (size_t i = 0; i < sizeof(mods) / sizeof(mods[0]); i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg(mods[i].name));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+TEST_CASE("esp_bus_req_async completes through the callback", "[esp_bus][request]")
+{
+    reset_test_state();
+    async_done_cnt = 0;
+    async_sum = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    esp_bus_module_t mod = {
+        .name = "test",
+        .on_req = test_req_handler,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    
+    // Pipelined: all outstanding before the first completes
+    int sent = 0;
+    for (int i = 1; i <= 10; i++) {
+        if (esp_bus_req_async("test.echo", &i, sizeof(i), sizeof(int), async_done, NULL) == ESP_OK) {
+            sent++;
+        }
+    }
+    TEST_ASSERT_EQUAL(10, sent);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_EQUAL(10, async_done_cnt);
+    TEST_ASSERT_EQUAL(55, async_sum);
+    
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_req_async("test.echo", NULL, 0, 0, NULL, NULL));
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("test"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+// Answers only after slow_release is given
+static esp_err_t late_req_handler(const char *action,
+                                   const void *req, size_t req_len,
+                                   void *res, size_t res_size, size_t *res_len,
+                                   void *ctx) {
+    xSemaphoreTake(slow_release, pdMS_TO_TICKS(1000));
+    if (res && res_size >= 4) {
+        memset(res, 0xEE, 4);
+        if (res_len) *res_len = 4;
+    }
+    return ESP_OK;
+}
+
+TEST_CASE("timed out request is never written back", "[esp_bus][request]")
+{
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    slow_release = xSemaphoreCreateBinary();
+    
+    esp_bus_module_t mod = {
+        .name = "late",
+        .on_req = late_req_handler,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    
+    // Each timed-out slot is freed by the bus task once the handler is done
+    for (int i = 0; i < 3; i++) {
+        uint8_t res[4] = {0};
+        size_t res_len = 0;
+        TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, esp_bus_req("late.get", NULL, 0, res, sizeof(res), &res_len, 20));
+        
+        xSemaphoreGive(slow_release);
+        vTaskDelay(pdMS_TO_TICKS(30));
+        TEST_ASSERT_EQUAL(0, res[0]);
+        TEST_ASSERT_EQUAL(0, res_len);
+    }
+    
+    // And a request that makes it in time gets its answer
+    xSemaphoreGive(slow_release);
+    uint8_t res[4] = {0};
+    size_t res_len = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req("late.get", NULL, 0, res, sizeof(res), &res_len, 200));
+    TEST_ASSERT_EQUAL(0xEE, res[3]);
+    TEST_ASSERT_EQUAL(4, res_len);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("late"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+    vSemaphoreDelete(slow_release);
+}
+
+static bool dump_unwanted = false;
+
+// "dump": as many bytes as asked for, sized by the handler
+static esp_err_t dump_req_handler(const char *action,
+                                   const void *req, size_t req_len,
+                                   void *res, size_t res_size, size_t *res_len,
+                                   void *ctx) {
+    size_t n = (req && req_len == sizeof(size_t)) ? *(const size_t *)req : 0;
+    esp_bus_buf_t *buf = esp_bus_res_buf(n);
+    if (!buf) {
+        dump_unwanted = true;
+        return ESP_OK;
+    }
+    for (size_t i = 0; i < n; i++) buf->data[i] = (uint8_t)i;
+    return ESP_OK;
+}
+
+TEST_CASE("handler sized response is handed back without a copy", "[esp_bus][request][buf]")
+{
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    TEST_ASSERT_NOT_NULL(esp_bus_resolve("cfg.dump"));
+    async_done_cnt = 0;
+    async_sum = 0;
+    dump_unwanted = false;
+    
+    esp_bus_module_t mod = {
+        .name = "cfg",
+        .on_req = dump_req_handler,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    
+    MEMORY_CHECK_START();
+    
+    // One round trip, no caller-side sizing
+    size_t n = 300;
+    esp_bus_buf_t *res = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req_buf("cfg.dump", &n, sizeof(n), &res, 100));
+    TEST_ASSERT_NOT_NULL(res);
+    TEST_ASSERT_EQUAL(300, res->len);
+    TEST_ASSERT_EQUAL(299 & 0xFF, res->data[299]);
+    esp_bus_buf_release(res);
+    
+    // Fixed-buffer callers get a truncated copy and the full length
+    uint8_t small[16] = {0};
+    size_t res_len = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req("cfg.dump", &n, sizeof(n), small, sizeof(small), &res_len, 100));
+    TEST_ASSERT_EQUAL(300, res_len);
+    TEST_ASSERT_EQUAL(15, small[15]);
+    
+    // Async callers see the handler's buffer
+    n = sizeof(int);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req_async("cfg.dump", &n, sizeof(n), 0, async_done, NULL));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(1, async_done_cnt);
+    
+    // Nobody waits: the handler is told not to bother
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req("cfg.dump", &n, sizeof(n), NULL, 0, NULL, ESP_BUS_NO_WAIT));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_TRUE(dump_unwanted);
+    
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_req_buf("cfg.dump", NULL, 0, &res, 0));
+    
+    MEMORY_CHECK_END(64);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("cfg"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
 // ============================================================================
 // Event Tests
 // ============================================================================
@@ -250,106 +574,1371 @@ TEST_CASE("esp_bus_sub wildcard matching", "[esp_bus][event]")
     vTaskDelay(pdMS_TO_TICKS(50));
     TEST_ASSERT_EQUAL(2, test_counter);
     
-    esp_bus_emit("btn1", "long_press", NULL, 0);
-    vTaskDelay(pdMS_TO_TICKS(50));
-    TEST_ASSERT_EQUAL(2, test_counter);
+    esp_bus_emit("btn1", "long_press", NULL, 0);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(2, test_counter);
+    
+    esp_bus_unsub(sub_id);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+static uint32_t last_u32 = 0;
+
+static void u32_evt_handler(const char *event, const void *data, size_t len, void *ctx) {
+    if (data && len == sizeof(uint32_t)) {
+        memcpy(&last_u32, data, sizeof(uint32_t));
+    }
+    test_counter++;
+}
+
+TEST_CASE("small payloads are carried inline", "[esp_bus][event]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    int sub_id = esp_bus_sub("adc:sample", u32_evt_handler, NULL);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, sub_id);
+    
+    esp_bus_pool_stats_t before, after;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_pool_stats(&before));
+    
+    uint32_t value = 0xA5A51234;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("adc", "sample", &value, sizeof(value)));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    
+    TEST_ASSERT_EQUAL(1, test_counter);
+    TEST_ASSERT_EQUAL_HEX32(value, last_u32);
+    
+    // No pool block or heap copy was needed
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_pool_stats(&after));
+    TEST_ASSERT_EQUAL(before.hits, after.hits);
+    TEST_ASSERT_EQUAL(before.misses, after.misses);
+    
+    esp_bus_unsub(sub_id);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+static char batch_log[64] = {0};
+
+static void batch_evt_handler(const char *event, const void *data, size_t len, void *ctx) {
+    size_t n = strlen(batch_log);
+    snprintf(batch_log + n, sizeof(batch_log) - n, "%s%s,", event, data ? (const char *)data : "");
+    test_counter++;
+}
+
+TEST_CASE("esp_bus_emit_batch dispatches in order", "[esp_bus][event]")
+{
+    reset_test_state();
+    batch_log[0] = '\0';
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    int sub_id = esp_bus_sub("adc:*", batch_evt_handler, NULL);
+    esp_bus_handle_t h = esp_bus_resolve("adc:c");
+    
+    esp_bus_evt_batch_t evts[] = {
+        { .src = "adc", .evt = "a", .data = "1", .len = 2 },
+        { .src = "adc", .evt = "b" },
+        { .h = h, .data = "a longer payload", .len = 17 },
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit_batch(evts, 3));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    
+    TEST_ASSERT_EQUAL(3, test_counter);
+    TEST_ASSERT_EQUAL_STRING("a1,b,ca longer payload,", batch_log);
+    
+    // One invalid entry rejects the whole batch
+    esp_bus_evt_batch_t bad[] = {
+        { .src = "adc", .evt = "a" },
+        { .src = "adc" },
+    };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_emit_batch(bad, 2));
+    
+    // A burst larger than the queue fits in one message
+    esp_bus_evt_batch_t burst[40];
+    for (int i = 0; i < 40; i++) {
+        burst[i] = (esp_bus_evt_batch_t){ .h = h };
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit_batch(burst, 40));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(43, test_counter);
+    
+    esp_bus_unsub(sub_id);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+TEST_CASE("esp_bus_emit_isr delivers through the ring", "[esp_bus][event][isr]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    slow_release = xSemaphoreCreateBinary();
+    
+    esp_bus_module_t mod = {
+        .name = "slow",
+        .on_req = slow_req_handler,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    int sub_id = esp_bus_sub("gpio:*", u32_evt_handler, NULL);
+    
+    // Not interned yet: resolved by the bus task
+    BaseType_t woken = pdFALSE;
+    uint32_t value = 42;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit_isr("gpio", "edge", &value, sizeof(value), &woken));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(1, test_counter);
+    TEST_ASSERT_EQUAL(42, last_u32);
+    
+    esp_bus_handle_t h = esp_bus_resolve("gpio:edge");
+    value = 7;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit_isr_h(h, &value, sizeof(value), &woken));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(2, test_counter);
+    TEST_ASSERT_EQUAL(7, last_u32);
+    
+    uint8_t big[64] = {0};
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, esp_bus_emit_isr_h(h, big, sizeof(big), &woken));
+    
+    // Fill the ring while the bus task is busy
+    esp_bus_call("slow.wait");
+    vTaskDelay(pdMS_TO_TICKS(20));
+    int accepted = 0;
+    for (int i = 0; i < 200; i++) {
+        if (esp_bus_emit_isr_h(h, NULL, 0, &woken) == ESP_OK) accepted++;
+    }
+    TEST_ASSERT_GREATER_THAN(0, accepted);
+    TEST_ASSERT_LESS_THAN(200, accepted);
+    
+    xSemaphoreGive(slow_release);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_EQUAL(2 + accepted, test_counter);
+    
+    // Ring is usable again after draining
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit_isr_h(h, NULL, 0, &woken));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(3 + accepted, test_counter);
+    
+    esp_bus_unsub(sub_id);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("slow"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+    vSemaphoreDelete(slow_release);
+}
+
+static TaskHandle_t deferred_task = NULL;
+
+static void deferred_fn(void *ctx) {
+    deferred_task = xTaskGetCurrentTaskHandle();
+    test_counter += (int)(intptr_t)ctx;
+}
+
+TEST_CASE("esp_bus_defer_isr runs callback on bus task", "[esp_bus][isr]")
+{
+    reset_test_state();
+    deferred_task = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    BaseType_t woken = pdFALSE;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_defer_isr(deferred_fn, (void *)(intptr_t)5, &woken));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_defer_isr(NULL, NULL, &woken));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    
+    TEST_ASSERT_EQUAL(5, test_counter);
+    TEST_ASSERT_NOT_NULL(deferred_task);
+    TEST_ASSERT_TRUE(deferred_task != xTaskGetCurrentTaskHandle());
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+// ============================================================================
+// Handle Tests
+// ============================================================================
+
+TEST_CASE("esp_bus_resolve request and event handles", "[esp_bus][handle]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    esp_bus_module_t mod = {
+        .name = "test",
+        .on_req = test_req_handler,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    
+    esp_bus_handle_t echo = esp_bus_resolve("test.echo");
+    TEST_ASSERT_NOT_NULL(echo);
+    TEST_ASSERT_EQUAL_PTR(echo, esp_bus_resolve("test.echo"));
+    TEST_ASSERT_NULL(esp_bus_resolve("no_separator"));
+    
+    char res[8] = {0};
+    size_t res_len = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req_h(echo, "hi", 3, res, sizeof(res), &res_len, 100));
+    TEST_ASSERT_EQUAL_STRING("hi", res);
+    TEST_ASSERT_EQUAL(3, res_len);
+    
+    esp_bus_handle_t evt = esp_bus_resolve("src:ping");
+    TEST_ASSERT_NOT_NULL(evt);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_req_h(evt, NULL, 0, NULL, 0, NULL, 100));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_emit_h(echo, NULL, 0));
+    
+    int sub_id = esp_bus_sub("src:ping", test_evt_handler, NULL);
+    test_counter = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit_h(evt, NULL, 0));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL_STRING("ping", last_event);
+    TEST_ASSERT_EQUAL(1, test_counter);
+    
+    esp_bus_unsub(sub_id);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("test"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+TEST_CASE("handle is unbound on unreg and rebound on reg", "[esp_bus][handle]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    esp_bus_strict(true);
+    
+    // Resolve before the module exists
+    esp_bus_handle_t h = esp_bus_resolve("late.action");
+    TEST_ASSERT_NOT_NULL(h);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, esp_bus_req_h(h, NULL, 0, NULL, 0, NULL, 100));
+    
+    esp_bus_module_t mod = {
+        .name = "late",
+        .on_req = test_req_handler,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req_h(h, NULL, 0, NULL, 0, NULL, 100));
+    TEST_ASSERT_EQUAL_STRING("action", last_action);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("late"));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, esp_bus_req_h(h, NULL, 0, NULL, 0, NULL, 100));
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req_h(h, NULL, 0, NULL, 0, NULL, 100));
+    
+    esp_bus_strict(false);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("late"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+// ============================================================================
+// Static Registration Tests
+// ============================================================================
+
+static int static_sub_hits = 0;
+
+static void static_sub_handler(const char *event, const void *data, size_t len, void *ctx) {
+    static_sub_hits += *(const int *)ctx;
+}
+
+static const int static_sub_weight = 1;
+static const esp_bus_action_t static_zeta_actions[] = {
+    { .name = "pong" },
+};
+
+// Defined out of order; the linker sorts the table by name
+ESP_BUS_MODULE_DEFINE(zeta_static,
+    .on_req = test_req_handler,
+    .actions = static_zeta_actions,
+    .action_cnt = 1,
+);
+ESP_BUS_MODULE_DEFINE(alpha_static,
+    .on_req = test_req_handler,
+);
+ESP_BUS_SUB_DEFINE(alpha_any, "alpha_static:*", static_sub_handler, (void *)&static_sub_weight);
+ESP_BUS_ROUTE_DEFINE(alpha_ping, "alpha_static:ping", "zeta_static.pong", NULL, 0);
+
+TEST_CASE("static modules, subs and routes are set up by init", "[esp_bus][static]")
+{
+    reset_test_state();
+    static_sub_hits = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    TEST_ASSERT_TRUE(esp_bus_exists("alpha_static"));
+    TEST_ASSERT_TRUE(esp_bus_exists("zeta_static"));
+    TEST_ASSERT_TRUE(esp_bus_has_action("zeta_static", "pong"));
+    TEST_ASSERT_FALSE(esp_bus_exists("beta_static"));
+    
+    // Names are taken and the table is fixed
+    esp_bus_module_t dup = { .name = "alpha_static", .on_req = test_req_handler };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_bus_reg(&dup));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, esp_bus_unreg("alpha_static"));
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req("alpha_static.ping", NULL, 0, NULL, 0, NULL, 100));
+    TEST_ASSERT_EQUAL_STRING("ping", last_action);
+    
+    // Static sub and route both fire on the event
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("alpha_static", "ping", NULL, 0));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(1, static_sub_hits);
+    TEST_ASSERT_EQUAL_STRING("pong", last_action);
+    
+    // Installed again on the next init
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("alpha_static", "tick", NULL, 0));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(2, static_sub_hits);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+// ============================================================================
+// Routing Tests
+// ============================================================================
+
+TEST_CASE("esp_bus_on routes event to request", "[esp_bus][routing]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    esp_bus_module_t mod = {
+        .name = "target",
+        .on_req = test_req_handler,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    
+    // Setup route
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_on("src:trigger", "target.action", NULL, 0));
+    
+    // Emit event - should trigger request
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("src", "trigger", NULL, 0));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    
+    TEST_ASSERT_EQUAL_STRING("action", last_action);
+    TEST_ASSERT_EQUAL(1, test_counter);
+    
+    // Disconnect route
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_off("src:trigger", "target.action"));
+    
+    // Emit again - should NOT trigger
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("src", "trigger", NULL, 0));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(0, test_counter);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("target"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+static char order_log[8];
+
+static void order_evt_handler(const char *event, const void *data, size_t len, void *ctx) {
+    strncat(order_log, "S", sizeof(order_log) - strlen(order_log) - 1);
+}
+
+static esp_err_t order_req_handler(const char *action,
+                                   const void *req, size_t req_len,
+                                   void *res, size_t res_size, size_t *res_len,
+                                   void *ctx) {
+    strncat(order_log, "R", sizeof(order_log) - strlen(order_log) - 1);
+    return ESP_OK;
+}
+
+TEST_CASE("routes run after every subscriber of the event", "[esp_bus][routing]")
+{
+    order_log[0] = '\0';
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    esp_bus_module_t mod = { .name = "ordm", .on_req = order_req_handler };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    int exact_id = esp_bus_sub("ord:go", order_evt_handler, NULL);
+    int glob_id = esp_bus_sub("*:go", order_evt_handler, NULL);
+    
+    // Newest in the exact list, still served last
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_on("ord:go", "ordm.hit", NULL, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("ord", "go", NULL, 0));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL_STRING("SSR", order_log);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_off("ord:go", NULL));
+    esp_bus_unsub(exact_id);
+    esp_bus_unsub(glob_id);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("ordm"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+static esp_bus_handle_t sw_targets[2];
+
+// Picks the target by the switch position, no pattern lookup per hop
+static void switch_transform(const char *evt, const void *data, size_t len,
+                             esp_bus_handle_t *out_req, void **out_data, size_t *out_len,
+                             void *ctx) {
+    if (data && len == 1) *out_req = sw_targets[*(const uint8_t *)data ? 1 : 0];
+}
+
+TEST_CASE("esp_bus_on_fn_h routes through resolved handles", "[esp_bus][routing]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    esp_bus_module_t mod = {
+        .name = "target",
+        .on_req = test_req_handler,
+    };
+    sw_targets[0] = esp_bus_resolve("target.off");
+    sw_targets[1] = esp_bus_resolve("target.on");
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_on_fn_h("sw:changed", switch_transform, NULL));
+    
+    // Not registered yet: the handle is unbound and nothing runs
+    uint8_t pos = 1;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("sw", "changed", &pos, 1));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(0, test_counter);
+    
+    // Registering binds the same handles
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("sw", "changed", &pos, 1));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(1, test_counter);
+    TEST_ASSERT_EQUAL_STRING("on", last_action);
+    
+    pos = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("sw", "changed", &pos, 1));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(2, test_counter);
+    TEST_ASSERT_EQUAL_STRING("off", last_action);
+    
+    // No target: no request
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("sw", "changed", NULL, 0));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(2, test_counter);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_off("sw:changed", NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("target"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+// ============================================================================
+// Priority Tests
+// ============================================================================
+
+static char prio_log[40];
+static int prio_cnt = 0;
+
+static void prio_evt_handler(const char *event, const void *data, size_t len, void *ctx) {
+    if (prio_cnt < (int)sizeof(prio_log) - 1) prio_log[prio_cnt++] = *(const char *)ctx;
+}
+
+static esp_err_t prio_req_handler(const char *action,
+                                   const void *req, size_t req_len,
+                                   void *res, size_t res_size, size_t *res_len,
+                                   void *ctx) {
+    if (prio_cnt < (int)sizeof(prio_log) - 1) prio_log[prio_cnt++] = 'H';
+    return ESP_OK;
+}
+
+TEST_CASE("high lane overtakes bulk traffic without starving it", "[esp_bus][prio]")
+{
+    memset(prio_log, 0, sizeof(prio_log));
+    prio_cnt = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    slow_release = xSemaphoreCreateBinary();
+    
+    esp_bus_module_t slow = { .name = "slow", .on_req = slow_req_handler };
+    esp_bus_module_t estop = { .name = "estop", .on_req = prio_req_handler };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&slow));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&estop));
+    int sub_low = esp_bus_sub("tele:data", prio_evt_handler, "L");
+    int sub_high = esp_bus_sub("fault:*", prio_evt_handler, "F");
+    
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_prio("tele:*", ESP_BUS_PRIO_LOW));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_prio("tele:data", ESP_BUS_PRIO_MAX));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_prio("tele:data", ESP_BUS_PRIO_LOW));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_prio("estop.trigger", ESP_BUS_PRIO_HIGH));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_prio("fault:hit", ESP_BUS_PRIO_HIGH));
+    
+    // Park the bus task, queue bulk first, then urgent traffic
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_call("slow.wait"));
+    vTaskDelay(pdMS_TO_TICKS(20));
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("tele", "data", NULL, 0));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_call("estop.trigger"));
+    for (int i = 0; i < CONFIG_ESP_BUS_PRIO_BURST + 2; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("fault", "hit", NULL, 0));
+    }
+    
+    xSemaphoreGive(slow_release);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    
+    // Urgent first; bulk gets a turn after CONFIG_ESP_BUS_PRIO_BURST of them
+    TEST_ASSERT_EQUAL(4 + 1 + CONFIG_ESP_BUS_PRIO_BURST + 2, prio_cnt);
+    TEST_ASSERT_EQUAL('H', prio_log[0]);
+    for (int i = 1; i < CONFIG_ESP_BUS_PRIO_BURST; i++) {
+        TEST_ASSERT_EQUAL('F', prio_log[i]);
+    }
+    TEST_ASSERT_EQUAL('L', prio_log[CONFIG_ESP_BUS_PRIO_BURST]);
+    TEST_ASSERT_EQUAL('F', prio_log[CONFIG_ESP_BUS_PRIO_BURST + 1]);
+    TEST_ASSERT_EQUAL('L', prio_log[prio_cnt - 1]);
+    
+    esp_bus_unsub(sub_low);
+    esp_bus_unsub(sub_high);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+    vSemaphoreDelete(slow_release);
+}
+
+TEST_CASE("lane set before registration survives re-registration", "[esp_bus][prio]")
+{
+    memset(prio_log, 0, sizeof(prio_log));
+    prio_cnt = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    slow_release = xSemaphoreCreateBinary();
+    
+    // Lane chosen while nobody serves the pattern yet
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_prio("estop.trigger", ESP_BUS_PRIO_HIGH));
+    
+    esp_bus_module_t slow = { .name = "slow", .on_req = slow_req_handler };
+    esp_bus_module_t estop = { .name = "estop", .on_req = prio_req_handler };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&slow));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&estop));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("estop"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&estop));
+    int sub = esp_bus_sub("tele:data", prio_evt_handler, "L");
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_call("slow.wait"));
+    vTaskDelay(pdMS_TO_TICKS(20));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("tele", "data", NULL, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("tele", "data", NULL, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_call("estop.trigger"));
+    
+    xSemaphoreGive(slow_release);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(3, prio_cnt);
+    TEST_ASSERT_EQUAL('H', prio_log[0]);
+    
+    esp_bus_unsub(sub);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+    vSemaphoreDelete(slow_release);
+}
+
+// ============================================================================
+// Worker Tests
+// ============================================================================
+
+TEST_CASE("conflated topic keeps one pending message", "[esp_bus][event][conflate]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    slow_release = xSemaphoreCreateBinary();
+    
+    esp_bus_module_t mod = { .name = "slow", .on_req = slow_req_handler };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_conflate("temp1:value", true));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_conflate("temp1.value", true));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_conflate("temp*:value", true));
+    int sub_id = esp_bus_sub("temp1:value", u32_evt_handler, NULL);
+    
+    // A fast producer while the bus task is busy
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_call("slow.wait"));
+    vTaskDelay(pdMS_TO_TICKS(20));
+    for (uint32_t v = 1; v <= 200; v++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("temp1", "value", &v, sizeof(v)));
+    }
+    
+    // The lane still has room for everyone else
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_call("slow.other"));
+    
+    xSemaphoreGive(slow_release);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(1, test_counter);
+    TEST_ASSERT_EQUAL(200, last_u32);
+    
+    // Delivered: the next emit queues again
+    uint32_t v = 7;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("temp1", "value", &v, sizeof(v)));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(2, test_counter);
+    TEST_ASSERT_EQUAL(7, last_u32);
+    
+    esp_bus_unsub(sub_id);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("slow"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+    vSemaphoreDelete(slow_release);
+}
+
+TEST_CASE("retained value reaches late subscribers", "[esp_bus][event][retain]")
+{
+    reset_test_state();
+    last_u32 = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_retain("tank:level", true));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_retain("tank.level", true));
+    
+    uint32_t v = 0;
+    size_t len = 0;
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, esp_bus_get_retained("tank:level", &v, sizeof(v), &len));
+    
+    v = 41;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("tank", "level", &v, sizeof(v)));
+    v = 42;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("tank", "level", &v, sizeof(v)));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("tank", "other", &v, sizeof(v)));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    
+    // Read without a round trip
+    v = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_get_retained("tank:level", &v, sizeof(v), &len));
+    TEST_ASSERT_EQUAL(42, v);
+    TEST_ASSERT_EQUAL(sizeof(v), len);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, esp_bus_get_retained("tank:other", &v, sizeof(v), NULL));
+    
+    // A late wildcard subscriber gets only the retained topic
+    int sub_id = esp_bus_sub("tank:*", u32_evt_handler, NULL);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(1, test_counter);
+    TEST_ASSERT_EQUAL(42, last_u32);
+    
+    // Dropped with the next event once disabled
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_retain("tank:level", false));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("tank", "level", &v, sizeof(v)));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(2, test_counter);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, esp_bus_get_retained("tank:level", &v, sizeof(v), NULL));
+    
+    esp_bus_unsub(sub_id);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+static volatile int flow_on_cnt = 0;
+static volatile int flow_off_cnt = 0;
+static volatile int drop_err_cnt = 0;
+
+static void flow_cb(bool congested, void *ctx) {
+    if (congested) flow_on_cnt++;
+    else flow_off_cnt++;
+}
+
+static void drop_err_cb(const char *pattern, esp_err_t err, const char *msg) {
+    if (err == ESP_ERR_TIMEOUT && strncmp(pattern, "flood:", 6) == 0) drop_err_cnt++;
+}
+
+static void release_later_task(void *arg) {
+    vTaskDelay(pdMS_TO_TICKS(30));
+    xSemaphoreGive(slow_release);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("full lanes follow the overflow policy", "[esp_bus][event][flow]")
+{
+    reset_test_state();
+    flow_on_cnt = flow_off_cnt = drop_err_cnt = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    slow_release = xSemaphoreCreateBinary();
+    esp_bus_on_err(drop_err_cb);
+    
+    esp_bus_module_t mod = { .name = "slow", .on_req = slow_req_handler };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_overflow("flood.a", ESP_BUS_OVERFLOW_BLOCK, 10));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_overflow("flood:*", ESP_BUS_OVERFLOW_BLOCK, 10));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_flow(4, 4, flow_cb, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_flow(4, 1, flow_cb, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_overflow("flood:b", ESP_BUS_OVERFLOW_DROP_OLDEST, 0));
+    int sub_id = esp_bus_sub("flood:*", u32_evt_handler, NULL);
+    
+    // Default: the newest emit fails once the lane is full
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_call("slow.wait"));
+    vTaskDelay(pdMS_TO_TICKS(20));
+    int accepted = 0;
+    uint32_t v = 0;
+    while (accepted < 100 && esp_bus_emit("flood", "a", &v, sizeof(v)) == ESP_OK) accepted++;
+    TEST_ASSERT_GREATER_THAN(4, accepted);
+    TEST_ASSERT_LESS_THAN(100, accepted);
+    TEST_ASSERT_EQUAL(1, esp_bus_drop_count("flood:a"));
+    TEST_ASSERT_EQUAL(1, drop_err_cnt);
+    TEST_ASSERT_EQUAL(1, flow_on_cnt);
+    
+    // Drop oldest: each emit evicts a queued event and still gets in
+    for (v = 1; v <= 3; v++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("flood", "b", &v, sizeof(v)));
+    }
+    TEST_ASSERT_EQUAL(4, esp_bus_drop_count("flood:a"));
+    TEST_ASSERT_EQUAL(0, esp_bus_drop_count("flood:b"));
+    TEST_ASSERT_EQUAL(4, esp_bus_drop_count(NULL));
+    
+    xSemaphoreGive(slow_release);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(accepted, test_counter);
+    TEST_ASSERT_EQUAL(3, last_u32);
+    TEST_ASSERT_EQUAL(1, flow_on_cnt);
+    TEST_ASSERT_EQUAL(1, flow_off_cnt);
+    
+    // Block: the emit waits until the bus task drains the lane
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_overflow("flood:c", ESP_BUS_OVERFLOW_BLOCK, 500));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_call("slow.wait"));
+    vTaskDelay(pdMS_TO_TICKS(20));
+    for (int i = 0; i < accepted; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("flood", "a", NULL, 0));
+    }
+    xTaskCreate(release_later_task, "release", 2048, NULL, 5, NULL);
+    v = 9;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("flood", "c", &v, sizeof(v)));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(2 * accepted + 1, test_counter);
+    TEST_ASSERT_EQUAL(9, last_u32);
+    TEST_ASSERT_EQUAL(4, esp_bus_drop_count(NULL));
+    TEST_ASSERT_EQUAL(2, flow_on_cnt);
+    TEST_ASSERT_EQUAL(2, flow_off_cnt);
+    
+    esp_bus_unsub(sub_id);
+    esp_bus_on_err(NULL);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("slow"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+    vSemaphoreDelete(slow_release);
+}
+
+static int disk_log[8];
+static volatile int disk_cnt = 0;
+static volatile int budget_err_cnt = 0;
+static volatile bool disk_on_bus = false;
+
+// A subscriber doing slow work, e.g. flash writes
+static void disk_evt_handler(const char *event, const void *data, size_t len, void *ctx) {
+    if (esp_bus_cur_pattern()) disk_on_bus = true;
+    vTaskDelay(pdMS_TO_TICKS(20));
+    if (data && len == sizeof(int) && disk_cnt < 8) disk_log[disk_cnt] = *(const int *)data;
+    disk_cnt++;
+}
+
+static void budget_err_cb(const char *pattern, esp_err_t err, const char *msg) {
+    if (err == ESP_ERR_TIMEOUT && strcmp(pattern, "disk:write") == 0) budget_err_cnt++;
+}
+
+TEST_CASE("slow subscribers are measured and offloaded", "[esp_bus][event][worker]")
+{
+    reset_test_state();
+    disk_cnt = budget_err_cnt = 0;
+    disk_on_bus = false;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    esp_bus_on_err(budget_err_cb);
+    
+    int slow_id = esp_bus_sub("disk:write", disk_evt_handler, NULL);
+    int fast_id = esp_bus_sub("disk:write", test_evt_handler, NULL);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, esp_bus_sub_budget(fast_id + 100, 1000));
+    
+    // Budget: every overrun is counted and reported, the handler still runs
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_sub_budget(slow_id, 5000));
+    int v = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("disk", "write", &v, sizeof(v)));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("disk", "write", &v, sizeof(v)));
+    vTaskDelay(pdMS_TO_TICKS(80));
+    TEST_ASSERT_EQUAL(2, disk_cnt);
+    TEST_ASSERT_EQUAL(2, budget_err_cnt);
+    TEST_ASSERT_TRUE(disk_on_bus);
+    
+    esp_bus_sub_stats_t st;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_sub_stats(slow_id, &st));
+    TEST_ASSERT_EQUAL(2, st.calls);
+    TEST_ASSERT_EQUAL(2, st.over_budget);
+    TEST_ASSERT_GREATER_OR_EQUAL(15000, st.max_us);
+    TEST_ASSERT_EQUAL(0, st.offloaded);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_sub_stats(fast_id, &st));
+    TEST_ASSERT_EQUAL(0, st.calls);
+    
+#if CONFIG_ESP_BUS_WORKERS > 0
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_sub_offload(slow_id, CONFIG_ESP_BUS_WORKERS + 1));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_sub_offload(slow_id, 1));
+    
+    // Offloaded: the fast subscriber is not held up, the slow one keeps order
+    disk_cnt = 0;
+    disk_on_bus = false;
+    test_counter = 0;
+    for (int i = 1; i <= 5; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("disk", "write", &i, sizeof(i)));
+    }
+    vTaskDelay(pdMS_TO_TICKS(10));
+    TEST_ASSERT_EQUAL(5, test_counter);
+    TEST_ASSERT_LESS_THAN(5, disk_cnt);
+    vTaskDelay(pdMS_TO_TICKS(150));
+    TEST_ASSERT_EQUAL(5, disk_cnt);
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL(i + 1, disk_log[i]);
+    }
+    TEST_ASSERT_FALSE(disk_on_bus);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_sub_stats(slow_id, &st));
+    TEST_ASSERT_EQUAL(5, st.offloaded);
+    TEST_ASSERT_EQUAL(7, st.calls);
+    TEST_ASSERT_EQUAL(0, st.drops);
+    
+    // Unsubscribed with events still queued: they are skipped and freed
+    MEMORY_CHECK_START();
+    disk_cnt = 0;
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("disk", "write", &i, sizeof(i)));
+    }
+    vTaskDelay(pdMS_TO_TICKS(5));
+    esp_bus_unsub(slow_id);
+    vTaskDelay(pdMS_TO_TICKS(80));
+    TEST_ASSERT_LESS_OR_EQUAL(1, disk_cnt);
+    MEMORY_CHECK_END(64);
+    
+    // A late subscriber's retained replay takes the offload path too; the
+    // bus is parked so the offload is set before the replay runs
+    slow_release = xSemaphoreCreateBinary();
+    esp_bus_module_t slow = { .name = "slow", .on_req = slow_req_handler };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&slow));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_retain("disk:write", true));
+    v = 9;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("disk", "write", &v, sizeof(v)));
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, esp_bus_req("slow.wait", NULL, 0, NULL, 0, NULL, 10));
+    disk_cnt = 0;
+    disk_on_bus = false;
+    int late_id = esp_bus_sub("disk:write", disk_evt_handler, NULL);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_sub_offload(late_id, 1));
+    xSemaphoreGive(slow_release);
+    vTaskDelay(pdMS_TO_TICKS(80));
+    TEST_ASSERT_EQUAL(1, disk_cnt);
+    TEST_ASSERT_EQUAL(9, disk_log[0]);
+    TEST_ASSERT_FALSE(disk_on_bus);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_sub_stats(late_id, &st));
+    TEST_ASSERT_EQUAL(1, st.offloaded);
+    TEST_ASSERT_EQUAL(1, st.calls);
+    esp_bus_unsub(late_id);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_retain("disk:write", false));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("slow"));
+    vSemaphoreDelete(slow_release);
+    slow_release = NULL;
+#else
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, esp_bus_sub_offload(slow_id, 1));
+    esp_bus_unsub(slow_id);
+#endif
+    
+    esp_bus_on_err(NULL);
+    esp_bus_unsub(fast_id);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+#ifdef CONFIG_ESP_BUS_PROFILE
+static esp_err_t sleepy_req_handler(const char *action,
+                                    const void *req, size_t req_len,
+                                    void *res, size_t res_size, size_t *res_len,
+                                    void *ctx) {
+    vTaskDelay(pdMS_TO_TICKS(10));
+    return ESP_OK;
+}
+
+TEST_CASE("profiler records latency and handler time", "[esp_bus][profile]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    esp_bus_module_t mod = { .name = "prof", .on_req = sleepy_req_handler };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    int sub_id = esp_bus_sub("prof:tick", test_evt_handler, NULL);
+    
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req("prof.nap", NULL, 0, NULL, 0, NULL, 1000));
+    }
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("prof", "tick", NULL, 0));
+    }
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(5, test_counter);
+    
+    esp_bus_stats_t st;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_stats_get("prof.*", &st));
+    TEST_ASSERT_EQUAL(3, st.exec.count);
+    TEST_ASSERT_EQUAL(3, st.latency.count);
+    TEST_ASSERT_GREATER_OR_EQUAL(5000, st.exec.max_us);
+    TEST_ASSERT_GREATER_OR_EQUAL(3 * 5000, st.exec.sum_us);
+    uint32_t total = 0;
+    for (int b = 0; b < ESP_BUS_HIST_BUCKETS; b++) total += st.exec.buckets[b];
+    TEST_ASSERT_EQUAL(3, total);
+    TEST_ASSERT_EQUAL(0, st.exec.buckets[0]);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_stats_get("prof:tick", &st));
+    TEST_ASSERT_EQUAL(5, st.exec.count);
+    TEST_ASSERT_EQUAL(5, st.latency.count);
+    TEST_ASSERT_GREATER_THAN(0, st.lane_high_water[ESP_BUS_PRIO_NORMAL]);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_stats_get(NULL, &st));
+    TEST_ASSERT_GREATER_OR_EQUAL(8, st.exec.count);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, esp_bus_stats_get("none:*", &st));
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_stats_reset());
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_stats_get("prof.*", &st));
+    TEST_ASSERT_EQUAL(0, st.exec.count);
+    TEST_ASSERT_EQUAL(0, st.exec.max_us);
+    
+    esp_bus_unsub(sub_id);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("prof"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+#else
+TEST_CASE("profiler is compiled out by default", "[esp_bus][profile]")
+{
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    esp_bus_stats_t st;
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, esp_bus_stats_get(NULL, &st));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+#endif
+
+#if CONFIG_ESP_BUS_TRACE_SIZE > 0
+TEST_CASE("trace ring records requests, events and drops", "[esp_bus][trace]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    esp_bus_module_t mod = { .name = "test", .on_req = test_req_handler };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    int sub_id = esp_bus_sub("trc:evt", test_evt_handler, NULL);
+    
+    uint32_t v = 5;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("trc", "evt", &v, sizeof(v)));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_bus_req("test.fail", NULL, 0, NULL, 0, NULL, 100));
+    vTaskDelay(pdMS_TO_TICKS(20));
+    
+    // Oldest first: the event went through the lane ahead of the request
+    esp_bus_trace_rec_t rec[16];
+    size_t n = esp_bus_trace_read(rec, 16);
+    TEST_ASSERT_GREATER_OR_EQUAL(3, n);
+    TEST_ASSERT_EQUAL(ESP_BUS_TRACE_EVT, rec[n - 2].type);
+    TEST_ASSERT_EQUAL(sizeof(v), rec[n - 2].len);
+    TEST_ASSERT_EQUAL(0, rec[n - 2].task);
+    TEST_ASSERT_EQUAL(ESP_OK, rec[n - 2].err);
+    TEST_ASSERT_EQUAL(ESP_BUS_TRACE_REQ, rec[n - 1].type);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, rec[n - 1].err);
+    TEST_ASSERT_NOT_EQUAL(rec[n - 2].pat_id, rec[n - 1].pat_id);
+    TEST_ASSERT_GREATER_OR_EQUAL(rec[n - 2].ts_us, rec[n - 1].ts_us);
+    
+    // The init of this test left a boot marker before them
+    bool boot = false;
+    for (size_t i = 0; i < n - 2; i++) {
+        if (rec[i].type == ESP_BUS_TRACE_BOOT) boot = true;
+    }
+    TEST_ASSERT_TRUE(boot);
+    
+    // A full lane leaves a drop record
+    slow_release = xSemaphoreCreateBinary();
+    esp_bus_module_t slow = { .name = "slow", .on_req = slow_req_handler };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&slow));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_call("slow.wait"));
+    vTaskDelay(pdMS_TO_TICKS(20));
+    while (esp_bus_emit("trc", "evt", NULL, 0) == ESP_OK) {}
+    n = esp_bus_trace_read(rec, 16);
+    TEST_ASSERT_EQUAL(ESP_BUS_TRACE_DROP, rec[n - 1].type);
+    TEST_ASSERT_EQUAL(0xff, rec[n - 1].task);
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, rec[n - 1].err);
+    xSemaphoreGive(slow_release);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    
+    esp_bus_trace_dump();
+    
+    esp_bus_unsub(sub_id);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("slow"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("test"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+    vSemaphoreDelete(slow_release);
+}
+#endif
+
+#if CONFIG_ESP_BUS_WORKERS > 0
+static int seq_log[8];
+static int seq_cnt = 0;
+
+static esp_err_t seq_req_handler(const char *action,
+                                  const void *req, size_t req_len,
+                                  void *res, size_t res_size, size_t *res_len,
+                                  void *ctx) {
+    if (req && req_len == sizeof(int) && seq_cnt < 8) {
+        seq_log[seq_cnt++] = *(const int *)req;
+    }
+    return ESP_OK;
+}
+
+TEST_CASE("worker module runs off the bus task", "[esp_bus][worker]")
+{
+    reset_test_state();
+    seq_cnt = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    slow_release = xSemaphoreCreateBinary();
+    
+    esp_bus_module_t bad = { .name = "bad", .on_req = test_req_handler, .worker = CONFIG_ESP_BUS_WORKERS + 1 };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_reg(&bad));
+    
+    esp_bus_module_t slow = { .name = "slow", .on_req = slow_req_handler, .worker = 1 };
+    esp_bus_module_t seq = { .name = "seq", .on_req = seq_req_handler, .worker = 1 };
+    esp_bus_module_t test = { .name = "test", .on_req = test_req_handler };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&slow));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&seq));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&test));
+    
+    // Worker parked: the bus task still answers
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_call("slow.wait"));
+    char res[8] = {0};
+    size_t res_len = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req("test.echo", "hi", 3, res, sizeof(res), &res_len, 100));
+    TEST_ASSERT_EQUAL_STRING("hi", res);
+    
+    // Requests queued behind the stall keep their order, routed ones too
+    for (int i = 1; i <= 3; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req("seq.step", &i, sizeof(i), NULL, 0, NULL, 0));
+    }
+    int four = 4;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_on("src:go", "seq.step", &four, sizeof(four)));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("src", "go", NULL, 0));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(0, seq_cnt);
+    
+    xSemaphoreGive(slow_release);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(4, seq_cnt);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(i + 1, seq_log[i]);
+    }
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+    vSemaphoreDelete(slow_release);
+}
+#endif
+
+// ============================================================================
+// Service Tests
+// ============================================================================
+
+TEST_CASE("esp_bus_tick periodic callback", "[esp_bus][service]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    // Register tick callback
+    int tick_id = esp_bus_tick(test_svc_handler, 50, NULL);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, tick_id);
+    
+    // Wait for some ticks
+    vTaskDelay(pdMS_TO_TICKS(180));
+    
+    // Should have been called ~3 times
+    TEST_ASSERT_GREATER_OR_EQUAL(2, test_counter);
+    TEST_ASSERT_LESS_OR_EQUAL(4, test_counter);
+    
+    // Remove tick
+    esp_bus_tick_del(tick_id);
+    
+    int count_after_del = test_counter;
+    vTaskDelay(pdMS_TO_TICKS(100));
+    
+    // Counter should not have increased much
+    TEST_ASSERT_LESS_OR_EQUAL(count_after_del + 1, test_counter);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+TEST_CASE("esp_bus_after one-shot timer", "[esp_bus][service]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    // Register one-shot timer
+    int timer_id = esp_bus_after(test_svc_handler, 50, NULL);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, timer_id);
+    
+    // Before timer fires
+    TEST_ASSERT_EQUAL(0, test_counter);
+    
+    // Wait for timer
+    vTaskDelay(pdMS_TO_TICKS(100));
+    
+    // Should have been called exactly once
+    TEST_ASSERT_EQUAL(1, test_counter);
+    
+    // Wait more - should not fire again
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_EQUAL(1, test_counter);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+static int rearm_id = -1;
+
+static void rearm_svc_handler(void *ctx) {
+    test_counter++;
+    if (test_counter < 3) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_rearm(rearm_id, 20));
+    }
+}
+
+TEST_CASE("esp_bus_rearm reuses a one-shot timer", "[esp_bus][service]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    rearm_id = esp_bus_after(rearm_svc_handler, 20, NULL);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, rearm_id);
+    
+    // Re-armed twice from its own callback, then expires
+    vTaskDelay(pdMS_TO_TICKS(200));
+    TEST_ASSERT_EQUAL(3, test_counter);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, esp_bus_rearm(rearm_id, 20));
+    
+    // Re-arming a pending timer postpones it
+    int id = esp_bus_after(test_svc_handler, 50, NULL);
+    vTaskDelay(pdMS_TO_TICKS(30));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_rearm(id, 100));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(3, test_counter);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_EQUAL(4, test_counter);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+static char svc_order[16] = {0};
+
+static void order_svc_handler(void *ctx) {
+    size_t n = strlen(svc_order);
+    if (n < sizeof(svc_order) - 1) {
+        svc_order[n] = *(const char *)ctx;
+        svc_order[n + 1] = '\0';
+    }
+}
+
+static int self_cancel_id = -1;
+
+static void self_cancel_handler(void *ctx) {
+    test_counter++;
+    esp_bus_cancel(self_cancel_id);
+}
+
+TEST_CASE("timers fire in deadline order and cancel safely", "[esp_bus][service]")
+{
+    reset_test_state();
+    svc_order[0] = '\0';
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    esp_bus_after(order_svc_handler, 90, "d");
+    esp_bus_after(order_svc_handler, 30, "b");
+    int c = esp_bus_after(order_svc_handler, 60, "c");
+    esp_bus_after(order_svc_handler, 10, "a");
+    esp_bus_after(order_svc_handler, 60, "x");
+    esp_bus_cancel(c);
+    
+    // A repeating service cancelling itself runs once
+    self_cancel_id = esp_bus_tick(self_cancel_handler, 10, NULL);
+    
+    vTaskDelay(pdMS_TO_TICKS(200));
+    TEST_ASSERT_EQUAL_STRING("abxd", svc_order);
+    TEST_ASSERT_EQUAL(1, test_counter);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+static void stall_once_handler(void *ctx) {
+    // First run overruns its 10 ms period by several periods
+    if ((*(int *)ctx)++ == 0) vTaskDelay(pdMS_TO_TICKS(60));
+}
+
+static esp_bus_svc_stats_t run_overrun(esp_bus_overrun_t policy, int *runs) {
+    *runs = 0;
+    int id = esp_bus_every(stall_once_handler, 10, runs);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_svc_policy(id, policy, 10));
+    vTaskDelay(pdMS_TO_TICKS(300));
+    
+    esp_bus_svc_stats_t st;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_svc_stats(id, &st));
+    esp_bus_cancel(id);
+    TEST_ASSERT_EQUAL(*runs, st.runs);
+    return st;
+}
+
+TEST_CASE("repeating services follow a fixed timeline", "[esp_bus][service]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    int id = esp_bus_every(test_svc_handler, 20, NULL);
+    vTaskDelay(pdMS_TO_TICKS(410));
+    
+    // No accumulated dispatch latency: every period is run
+    TEST_ASSERT_GREATER_OR_EQUAL(19, test_counter);
+    TEST_ASSERT_LESS_OR_EQUAL(21, test_counter);
+    
+    esp_bus_svc_stats_t st;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_svc_stats(id, &st));
+    TEST_ASSERT_EQUAL(0, st.missed);
+    TEST_ASSERT_LESS_OR_EQUAL(st.late_max_us, st.late_avg_us);
+    esp_bus_cancel(id);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, esp_bus_svc_stats(id, &st));
     
-    esp_bus_unsub(sub_id);
     TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
 }
 
-// ============================================================================
-// Routing Tests
-// ============================================================================
-
-TEST_CASE("esp_bus_on routes event to request", "[esp_bus][routing]")
+#ifdef CONFIG_ESP_BUS_HIRES_TIMER
+TEST_CASE("hires timer runs sub-tick intervals", "[esp_bus][service]")
 {
     reset_test_state();
     TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
     
-    esp_bus_module_t mod = {
-        .name = "target",
-        .on_req = test_req_handler,
-    };
-    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    int id = esp_bus_every(test_svc_handler, 2, NULL);
+    vTaskDelay(pdMS_TO_TICKS(200));
+    esp_bus_cancel(id);
     
-    // Setup route
-    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_on("src:trigger", "target.action", NULL, 0));
+    // One run per 2 ms, independent of the tick rate
+    TEST_ASSERT_GREATER_OR_EQUAL(90, test_counter);
+    TEST_ASSERT_LESS_OR_EQUAL(101, test_counter);
     
-    // Emit event - should trigger request
-    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("src", "trigger", NULL, 0));
-    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+#endif
+
+TEST_CASE("repeating service overrun policies", "[esp_bus][service]")
+{
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    int runs;
     
-    TEST_ASSERT_EQUAL_STRING("action", last_action);
-    TEST_ASSERT_EQUAL(1, test_counter);
+    // Skip: periods lost to the stall are dropped, phase kept
+    esp_bus_svc_stats_t st = run_overrun(ESP_BUS_OVERRUN_SKIP, &runs);
+    TEST_ASSERT_GREATER_OR_EQUAL(4, st.missed);
     
-    // Disconnect route
-    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_off("src:trigger", "target.action"));
+    // Catch up: missed periods run back-to-back, none lost
+    st = run_overrun(ESP_BUS_OVERRUN_CATCH_UP, &runs);
+    TEST_ASSERT_EQUAL(0, st.missed);
+    TEST_ASSERT_GREATER_OR_EQUAL(28, runs);
+    TEST_ASSERT_GREATER_OR_EQUAL(40000, st.late_max_us);
     
-    // Emit again - should NOT trigger
-    reset_test_state();
-    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("src", "trigger", NULL, 0));
-    vTaskDelay(pdMS_TO_TICKS(50));
-    TEST_ASSERT_EQUAL(0, test_counter);
+    // Coalesce: one run for the stall, then a fresh timeline
+    st = run_overrun(ESP_BUS_OVERRUN_COALESCE, &runs);
+    TEST_ASSERT_GREATER_OR_EQUAL(4, st.missed);
+    TEST_ASSERT_LESS_OR_EQUAL(27, runs);
     
-    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("target"));
     TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
 }
 
-// ============================================================================
-// Service Tests
-// ============================================================================
-
-TEST_CASE("esp_bus_tick periodic callback", "[esp_bus][service]")
+TEST_CASE("idle bus task sleeps until a service is due", "[esp_bus][service]")
 {
     reset_test_state();
     TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
     
-    // Register tick callback
-    int tick_id = esp_bus_tick(test_svc_handler, 50, NULL);
-    TEST_ASSERT_GREATER_OR_EQUAL(0, tick_id);
-    
-    // Wait for some ticks
-    vTaskDelay(pdMS_TO_TICKS(180));
+    int id = esp_bus_every(test_svc_handler, 20, NULL);
+#ifdef CONFIG_PM_ENABLE
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_svc_pm(id, true));
+#else
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, esp_bus_svc_pm(id, true));
+#endif
+    
+#ifdef CONFIG_ESP_BUS_PROFILE
+    // One wake-up per run, nothing in between
+    esp_bus_stats_t st;
+    vTaskDelay(pdMS_TO_TICKS(10));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_stats_reset());
+    vTaskDelay(pdMS_TO_TICKS(200));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_stats_get(NULL, &st));
+    TEST_ASSERT_GREATER_OR_EQUAL(9, st.wakeups);
+    TEST_ASSERT_LESS_OR_EQUAL(12, st.wakeups);
+    TEST_ASSERT_GREATER_OR_EQUAL(40, st.wakeups_per_s);
+    TEST_ASSERT_LESS_OR_EQUAL(60, st.wakeups_per_s);
+    
+    // Nothing armed: no periodic wake-ups at all
+    esp_bus_cancel(id);
+    vTaskDelay(pdMS_TO_TICKS(30));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_stats_reset());
+    vTaskDelay(pdMS_TO_TICKS(300));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_stats_get(NULL, &st));
+    TEST_ASSERT_LESS_OR_EQUAL(1, st.wakeups);
+#else
+    vTaskDelay(pdMS_TO_TICKS(100));
+    esp_bus_cancel(id);
+#endif
+    TEST_ASSERT_GREATER_OR_EQUAL(4, test_counter);
     
-    // Should have been called ~3 times
-    TEST_ASSERT_GREATER_OR_EQUAL(2, test_counter);
-    TEST_ASSERT_LESS_OR_EQUAL(4, test_counter);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+#if CONFIG_ESP_BUS_WORKERS > 0 && defined(CONFIG_ESP_BUS_PROFILE)
+TEST_CASE("blocked worker handler does not hold back reclamation", "[esp_bus][service][worker]")
+{
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    slow_release = xSemaphoreCreateBinary();
     
-    // Remove tick
-    esp_bus_tick_del(tick_id);
+    esp_bus_module_t parked = { .name = "parked", .on_req = slow_req_handler, .worker = 1 };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&parked));
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, esp_bus_req("parked.wait", NULL, 0, NULL, 0, NULL, 10));
     
-    int count_after_del = test_counter;
-    vTaskDelay(pdMS_TO_TICKS(100));
+    // Retired while the handler is still blocked on worker 1
+    esp_bus_module_t scratch = { .name = "scratch", .on_req = test_req_handler };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&scratch));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("scratch"));
     
-    // Counter should not have increased much
-    TEST_ASSERT_LESS_OR_EQUAL(count_after_del + 1, test_counter);
+    // Reclaimed at once, so the bus task goes back to sleep
+    esp_bus_stats_t st;
+    vTaskDelay(pdMS_TO_TICKS(30));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_stats_reset());
+    vTaskDelay(pdMS_TO_TICKS(200));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_stats_get(NULL, &st));
+    TEST_ASSERT_LESS_OR_EQUAL(2, st.wakeups);
     
+    xSemaphoreGive(slow_release);
+    vTaskDelay(pdMS_TO_TICKS(20));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("parked"));
+    vSemaphoreDelete(slow_release);
+    slow_release = NULL;
     TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
 }
+#endif
 
-TEST_CASE("esp_bus_after one-shot timer", "[esp_bus][service]")
+// ============================================================================
+// Button Module Tests
+// ============================================================================
+
+static char btn_log[128];
+
+static void btn_evt_handler(const char *event, const void *data, size_t len, void *ctx) {
+    strncat(btn_log, event, sizeof(btn_log) - strlen(btn_log) - 1);
+    strncat(btn_log, ",", sizeof(btn_log) - strlen(btn_log) - 1);
+}
+
+TEST_CASE("esp_bus_btn interrupt mode", "[esp_bus][btn][isr]")
 {
-    reset_test_state();
+    btn_log[0] = '\0';
     TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
     
-    // Register one-shot timer
-    int timer_id = esp_bus_after(test_svc_handler, 50, NULL);
-    TEST_ASSERT_GREATER_OR_EQUAL(0, timer_id);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_btn_reg("ibtn", &(esp_bus_btn_cfg_t){
+        .pin = GPIO_NUM_5,
+        .active_low = true,
+        .long_press_ms = 300,
+        .use_isr = true,
+    }));
     
-    // Before timer fires
-    TEST_ASSERT_EQUAL(0, test_counter);
+    // The pad is driven from its own output, edges raise the interrupt
+    gpio_set_level(GPIO_NUM_5, 1);
+    gpio_set_direction(GPIO_NUM_5, GPIO_MODE_INPUT_OUTPUT);
+    int sub_id = esp_bus_sub("ibtn:*", btn_evt_handler, NULL);
+    vTaskDelay(pdMS_TO_TICKS(50));
     
-    // Wait for timer
+    gpio_set_level(GPIO_NUM_5, 0);
     vTaskDelay(pdMS_TO_TICKS(100));
-    
-    // Should have been called exactly once
-    TEST_ASSERT_EQUAL(1, test_counter);
-    
-    // Wait more - should not fire again
+    gpio_set_level(GPIO_NUM_5, 1);
+    vTaskDelay(pdMS_TO_TICKS(400));
+    TEST_ASSERT_EQUAL_STRING("short_press,short_release,", btn_log);
+    
+    // Held: timed by polling, then back to waiting for an edge
+    btn_log[0] = '\0';
+    gpio_set_level(GPIO_NUM_5, 0);
+    vTaskDelay(pdMS_TO_TICKS(500));
+    gpio_set_level(GPIO_NUM_5, 1);
     vTaskDelay(pdMS_TO_TICKS(100));
-    TEST_ASSERT_EQUAL(1, test_counter);
+    TEST_ASSERT_EQUAL_STRING("short_press,long_press,long_release,", btn_log);
+    
+    // Unregistered right after an edge, and right after registering: the
+    // wakes still queued run before the context is freed
+    MEMORY_CHECK_START();
+    for (int i = 0; i < 10; i++) {
+        gpio_set_level(GPIO_NUM_5, i & 1);
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_btn_unreg("ibtn"));
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_btn_reg("ibtn", &(esp_bus_btn_cfg_t){
+            .pin = GPIO_NUM_5,
+            .active_low = true,
+            .use_isr = true,
+        }));
+        if (i & 1) vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_btn_unreg("ibtn"));
+    gpio_set_level(GPIO_NUM_5, 1);
+    MEMORY_CHECK_END(64);
     
+    gpio_set_direction(GPIO_NUM_5, GPIO_MODE_INPUT);
+    esp_bus_unsub(sub_id);
     TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
 }
 
@@ -393,6 +1982,262 @@ TEST_CASE("esp_bus_led basic operations", "[esp_bus][led]")
     TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
 }
 
+static uint8_t led_state(const char *pattern) {
+    uint8_t state = 0xff;
+    esp_bus_req(pattern, NULL, 0, &state, sizeof(state), NULL, 100);
+    return state;
+}
+
+TEST_CASE("esp_bus_led binary blink and patterns", "[esp_bus][led]")
+{
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_led_reg("led1", &(esp_bus_led_cfg_t){ .pin = GPIO_NUM_2 }));
+    
+    // on 40, off 40, on 40, then off for good
+    esp_bus_led_pattern_t pat = { .repeat = 1, .step_cnt = 3, .steps = { 40, 40, 40 } };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req(LED_CMD_PATTERN("led1"), &pat, sizeof(pat), NULL, 0, NULL, 100));
+    vTaskDelay(pdMS_TO_TICKS(20));
+    TEST_ASSERT_EQUAL(1, led_state(LED_CMD_STATE("led1")));
+    vTaskDelay(pdMS_TO_TICKS(40));
+    TEST_ASSERT_EQUAL(0, led_state(LED_CMD_STATE("led1")));
+    vTaskDelay(pdMS_TO_TICKS(40));
+    TEST_ASSERT_EQUAL(1, led_state(LED_CMD_STATE("led1")));
+    vTaskDelay(pdMS_TO_TICKS(60));
+    TEST_ASSERT_EQUAL(0, led_state(LED_CMD_STATE("led1")));
+    
+    // Only the used steps need to be sent
+    size_t short_len = offsetof(esp_bus_led_pattern_t, steps) + 3 * sizeof(uint16_t);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req(LED_CMD_PATTERN("led1"), &pat, short_len, NULL, 0, NULL, 100));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_req(LED_CMD_PATTERN("led1"), &pat, short_len - 1, NULL, 0, NULL, 100));
+    pat.steps[1] = 0;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_req(LED_CMD_PATTERN("led1"), &pat, sizeof(pat), NULL, 0, NULL, 100));
+    pat.step_cnt = ESP_BUS_LED_STEPS_MAX + 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_req(LED_CMD_PATTERN("led1"), &pat, sizeof(pat), NULL, 0, NULL, 100));
+    
+    // Binary blink replaces the running pattern; count 0 stops it
+    esp_bus_led_blink_t blink = { .on_ms = 40, .off_ms = 40, .count = -1 };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req(LED_CMD_BLINK_BIN("led1"), &blink, sizeof(blink), NULL, 0, NULL, 100));
+    vTaskDelay(pdMS_TO_TICKS(60));
+    TEST_ASSERT_EQUAL(0, led_state(LED_CMD_STATE("led1")));
+    blink.count = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req(LED_CMD_BLINK_BIN("led1"), &blink, sizeof(blink), NULL, 0, NULL, 100));
+    vTaskDelay(pdMS_TO_TICKS(60));
+    TEST_ASSERT_EQUAL(0, led_state(LED_CMD_STATE("led1")));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_req(LED_CMD_BLINK_BIN("led1"), &blink, 2, NULL, 0, NULL, 100));
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_led_unreg("led1"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+TEST_CASE("esp_bus_led group runs members in lockstep", "[esp_bus][led]")
+{
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_led_reg("led1", &(esp_bus_led_cfg_t){ .pin = GPIO_NUM_2 }));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_led_reg("led2", &(esp_bus_led_cfg_t){ .pin = GPIO_NUM_4 }));
+    
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, esp_bus_led_group_reg("leds", (const char *[]){ "led1", "nope" }, 2));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_led_group_reg("leds", (const char *[]){ "led1", "led2" }, 2));
+    
+    // A member's own blink is taken over by the group
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_call_s(LED_CMD_BLINK("led2"), "10,10,-1"));
+    esp_bus_led_blink_t blink = { .on_ms = 40, .off_ms = 40, .count = 1 };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req(LED_CMD_BLINK_BIN("leds"), &blink, sizeof(blink), NULL, 0, NULL, 100));
+    vTaskDelay(pdMS_TO_TICKS(20));
+    TEST_ASSERT_EQUAL(1, led_state(LED_CMD_STATE("led1")));
+    TEST_ASSERT_EQUAL(1, led_state(LED_CMD_STATE("led2")));
+    vTaskDelay(pdMS_TO_TICKS(40));
+    TEST_ASSERT_EQUAL(0, led_state(LED_CMD_STATE("led1")));
+    TEST_ASSERT_EQUAL(0, led_state(LED_CMD_STATE("led2")));
+    vTaskDelay(pdMS_TO_TICKS(60));
+    TEST_ASSERT_EQUAL(0, led_state(LED_CMD_STATE("led2")));
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_call(LED_CMD_ON("leds")));
+    vTaskDelay(pdMS_TO_TICKS(20));
+    TEST_ASSERT_EQUAL(1, led_state(LED_CMD_STATE("leds")));
+    TEST_ASSERT_EQUAL(1, led_state(LED_CMD_STATE("led2")));
+    
+    // Members stay while their group exists
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_bus_led_unreg("led1"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_call_s(LED_CMD_BLINK("leds"), "10,10,-1"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_led_unreg("leds"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_led_unreg("led1"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_led_unreg("led2"));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+// ============================================================================
+// Bridge Module Tests
+// ============================================================================
+
+// Loopback link: a pump task plays the peer's receive side
+typedef struct {
+    const char *to;             // Receiving bridge, NULL stops the pump
+    size_t len;
+    uint8_t data[ESP_BUS_BRIDGE_MTU];
+} link_frame_t;
+
+static QueueHandle_t link_q;
+static int link_evt_cnt = 0;
+static int link_evt_sum = 0;
+static int link_up_cnt = 0;
+static int link_loc_cnt = 0;
+static int link_echo_cnt = 0;
+
+static esp_err_t link_send(const void *frame, size_t len, void *ctx) {
+    link_frame_t f = { .to = ctx, .len = len };
+    memcpy(f.data, frame, len);
+    return xQueueSend(link_q, &f, 0) == pdTRUE ? ESP_OK : ESP_FAIL;
+}
+
+static void link_pump_task(void *arg) {
+    link_frame_t f;
+    while (xQueueReceive(link_q, &f, portMAX_DELAY) == pdTRUE && f.to) {
+        // Split each frame, as a UART read would
+        size_t half = f.len / 2;
+        esp_bus_bridge_input(f.to, f.data, half);
+        esp_bus_bridge_input(f.to, f.data + half, f.len - half);
+    }
+    vTaskDelete(NULL);
+}
+
+static void link_evt_handler(const char *event, const void *data, size_t len, void *ctx) {
+    int v = 0;
+    if (data && len == sizeof(v)) memcpy(&v, data, sizeof(v));
+    link_evt_cnt++;
+    link_evt_sum += v;
+}
+
+static void link_up_handler(const char *event, const void *data, size_t len, void *ctx) {
+    link_up_cnt++;
+}
+
+static void link_cnt_handler(const char *event, const void *data, size_t len, void *ctx) {
+    (*(int *)ctx)++;
+}
+
+static esp_bus_bridge_stats_t link_stats(const char *pattern) {
+    esp_bus_bridge_stats_t st = {0};
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req(pattern, NULL, 0, &st, sizeof(st), NULL, 100));
+    return st;
+}
+
+TEST_CASE("esp_bus_bridge carries events and requests over a link", "[esp_bus][bridge]")
+{
+    reset_test_state();
+    link_evt_cnt = link_evt_sum = link_up_cnt = link_loc_cnt = link_echo_cnt = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    link_q = xQueueCreate(16, sizeof(link_frame_t));
+    TEST_ASSERT_NOT_NULL(link_q);
+    xTaskCreate(link_pump_task, "link", 4096, NULL, 5, NULL);
+    
+    esp_bus_module_t mods[] = {
+        { .name = "test", .on_req = test_req_handler },
+        { .name = "hidden", .on_req = test_req_handler },
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mods[0]));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mods[1]));
+    TEST_ASSERT(esp_bus_sub(BRIDGE_ON_PEER_UP("near"), link_up_handler, NULL) >= 0);
+    TEST_ASSERT(esp_bus_sub("far_tsrc:*", link_evt_handler, NULL) >= 0);
+    TEST_ASSERT(esp_bus_sub("far_near_loc:*", link_cnt_handler, &link_loc_cnt) >= 0);
+    TEST_ASSERT(esp_bus_sub("near_far_tsrc:*", link_cnt_handler, &link_echo_cnt) >= 0);
+    
+    // Both ends share this bus: "near" sees the other end's modules as far_*
+    esp_bus_bridge_cfg_t near = {
+        .prefix = "far_",
+        .send = link_send,
+        .send_ctx = "far",
+        .timeout_ms = 200,
+        .events = (const char *[]){ "far_tsrc:*" },
+        .event_cnt = 1,
+        .modules = (const char *[]){ "test", "hidden" },
+        .module_cnt = 2,
+        .serve = (const char *[]){ "none" },
+        .serve_cnt = 1,
+#if CONFIG_ESP_BUS_WORKERS > 0
+        .worker = 1,
+#endif
+    };
+    esp_bus_bridge_cfg_t far = {
+        .prefix = "near_",
+        .send = link_send,
+        .send_ctx = "near",
+        .batch_ms = 20,
+        .events = (const char *[]){ "tsrc:*", "near_loc:*" },
+        .event_cnt = 2,
+        .serve = (const char *[]){ "test" },
+        .serve_cnt = 1,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_bridge_reg("near", &near));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_bridge_reg("far", &far));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_bus_bridge_reg("far", &far));
+    far.modules = (const char *[]){ "much_too_long" };
+    far.module_cnt = 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_bridge_reg("far2", &far));
+    TEST_ASSERT_TRUE(esp_bus_exists("far_test"));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(1, link_up_cnt);
+    
+    // Small events within batch_ms share one frame
+    esp_bus_bridge_stats_t far0 = link_stats(BRIDGE_CMD_STATS("far"));
+    for (int i = 1; i <= 3; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("tsrc", "tick", &i, sizeof(i)));
+    }
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_EQUAL(3, link_evt_cnt);
+    TEST_ASSERT_EQUAL(6, link_evt_sum);
+    esp_bus_bridge_stats_t far1 = link_stats(BRIDGE_CMD_STATS("far"));
+    TEST_ASSERT_EQUAL(3, far1.tx_msgs - far0.tx_msgs);
+    TEST_ASSERT_EQUAL(1, far1.tx_frames - far0.tx_frames);
+    
+    // Same burst again: the pattern id is defined already
+    for (int i = 1; i <= 3; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("tsrc", "tick", &i, sizeof(i)));
+    }
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_EQUAL(6, link_evt_cnt);
+    esp_bus_bridge_stats_t far2 = link_stats(BRIDGE_CMD_STATS("far"));
+    TEST_ASSERT_LESS_THAN(far1.tx_bytes - far0.tx_bytes, far2.tx_bytes - far1.tx_bytes);
+    
+    // Nothing that came in over "near" went back, although it forwards
+    // far_tsrc:*; a local name that merely starts with a prefix does cross
+    TEST_ASSERT_EQUAL(0, link_echo_cnt);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("near_loc", "ping", NULL, 0));
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_EQUAL(1, link_loc_cnt);
+    
+#if CONFIG_ESP_BUS_WORKERS > 0
+    // Remote requests block a worker, not the bus task serving "test"
+    int v = 42, out = 0;
+    size_t out_len = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_req("far_test.echo", &v, sizeof(v), &out, sizeof(out), &out_len, 500));
+    TEST_ASSERT_EQUAL(42, out);
+    TEST_ASSERT_EQUAL(sizeof(int), out_len);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_bus_req("far_test.fail", NULL, 0, NULL, 0, NULL, 500));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, esp_bus_req("far_hidden.echo", &v, sizeof(v), NULL, 0, NULL, 500));
+    TEST_ASSERT_EQUAL_STRING("fail", last_action);
+    TEST_ASSERT_EQUAL(3, link_stats(BRIDGE_CMD_STATS("near")).rtt.count);
+#endif
+    
+    // Corrupt frame and unknown bridge
+    const uint8_t junk[] = { 0xB5, 0x62, 0x02, 0x00, 0x01, 0x01, 0x00, 0x00 };
+    uint32_t errors = link_stats(BRIDGE_CMD_STATS("near")).rx_errors;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_bridge_input("near", junk, sizeof(junk)));
+    TEST_ASSERT_EQUAL(errors + 1, link_stats(BRIDGE_CMD_STATS("near")).rx_errors);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, esp_bus_bridge_input("nobody", junk, sizeof(junk)));
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_bridge_unreg("near"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_bridge_unreg("far"));
+    TEST_ASSERT_FALSE(esp_bus_exists("far_test"));
+    link_frame_t stop = { .to = NULL };
+    xQueueSend(link_q, &stop, portMAX_DELAY);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    vQueueDelete(link_q);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("test"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("hidden"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
 // ============================================================================
 // Pattern Matching Tests
 // ============================================================================
@@ -420,6 +2265,52 @@ TEST_CASE("pattern matching basic", "[esp_bus][pattern]")
     TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
 }
 
+static void count_evt_handler(const char *event, const void *data, size_t len, void *ctx) {
+    (*(int *)ctx)++;
+}
+
+TEST_CASE("subscription index matches all wildcard forms", "[esp_bus][pattern]")
+{
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    
+    static const struct {
+        const char *pattern;
+        int expected;
+    } cases[] = {
+        {"btn1:short_press", 1},    // exact
+        {"btn*",             3},    // prefix
+        {"btn*:*",           3},    // prefix + glob
+        {"*:pressed",        2},    // suffix
+        {"*:*_press",        2},    // suffix + glob
+        {"*_press",          2},    // suffix
+        {"b*n2:long*",       1},    // prefix + glob
+        {"*1:*",             3},    // general glob
+        {"*",                4},    // match all
+        {"btn1",             0},    // no separator
+    };
+    const size_t n = sizeof(cases) / sizeof(cases[0]);
+    int counts[sizeof(cases) / sizeof(cases[0])] = {0};
+    int ids[sizeof(cases) / sizeof(cases[0])];
+    
+    for (size_t i = 0; i < n; i++) {
+        ids[i] = esp_bus_sub(cases[i].pattern, count_evt_handler, &counts[i]);
+        TEST_ASSERT_GREATER_OR_EQUAL(0, ids[i]);
+    }
+    
+    esp_bus_emit("btn1", "short_press", NULL, 0);
+    esp_bus_emit("btn2", "long_press", NULL, 0);
+    esp_bus_emit("led1", "pressed", NULL, 0);
+    esp_bus_emit("btn1", "pressed", NULL, 0);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    
+    for (size_t i = 0; i < n; i++) {
+        TEST_ASSERT_EQUAL_MESSAGE(cases[i].expected, counts[i], cases[i].pattern);
+        esp_bus_unsub(ids[i]);
+    }
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
 // ============================================================================
 // Memory Leak Tests
 // ============================================================================
@@ -483,6 +2374,10 @@ TEST_CASE("no memory leak on routing on/off cycle", "[esp_bus][memory]")
     };
     TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
     
+    // Patterns are interned on first use and kept until deinit
+    TEST_ASSERT_NOT_NULL(esp_bus_resolve("src:evt"));
+    TEST_ASSERT_NOT_NULL(esp_bus_resolve("target.act"));
+    
     MEMORY_CHECK_START();
     
     for (int i = 0; i < 10; i++) {
@@ -506,6 +2401,9 @@ TEST_CASE("no memory leak on routing with data", "[esp_bus][memory]")
     };
     TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
     
+    TEST_ASSERT_NOT_NULL(esp_bus_resolve("src:evt"));
+    TEST_ASSERT_NOT_NULL(esp_bus_resolve("target.act"));
+    
     MEMORY_CHECK_START();
     
     char data[] = "test_data_payload";
@@ -544,6 +2442,9 @@ TEST_CASE("no memory leak on emit events", "[esp_bus][memory]")
     
     int sub_id = esp_bus_sub("src:*", test_evt_handler, NULL);
     
+    // Patterns are interned on first use and kept until deinit
+    TEST_ASSERT_NOT_NULL(esp_bus_resolve("src:event"));
+    
     MEMORY_CHECK_START();
     
     for (int i = 0; i < 20; i++) {
@@ -569,6 +2470,7 @@ TEST_CASE("no memory leak on request with data", "[esp_bus][memory]")
         .on_req = test_req_handler,
     };
     TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    TEST_ASSERT_NOT_NULL(esp_bus_resolve("test.echo"));
     
     MEMORY_CHECK_START();
     
@@ -590,6 +2492,11 @@ TEST_CASE("no memory leak on LED module", "[esp_bus][memory][led]")
 {
     TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
     
+    // Patterns are interned on first use and kept until deinit
+    TEST_ASSERT_NOT_NULL(esp_bus_resolve("led1.on"));
+    TEST_ASSERT_NOT_NULL(esp_bus_resolve("led1.off"));
+    TEST_ASSERT_NOT_NULL(esp_bus_resolve("led1.blink"));
+    
     MEMORY_CHECK_START();
     
     // Note: GPIO driver may allocate some memory on first init
@@ -656,6 +2563,183 @@ TEST_CASE("heap integrity after stress test", "[esp_bus][memory][stress]")
     TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
 }
 
+static int churn_ids[2];
+
+// Removes itself and the next listener while the bus task walks the list
+static void unsub_all_handler(const char *event, const void *data, size_t len, void *ctx) {
+    test_counter++;
+    esp_bus_unsub(churn_ids[0]);
+    esp_bus_unsub(churn_ids[1]);
+}
+
+static volatile bool churn_run = false;
+static volatile int churn_reads = 0;
+
+static void churn_reader_task(void *arg) {
+    while (churn_run) {
+        esp_bus_has_action("churn", "go");
+        esp_bus_exists("churn");
+        churn_reads++;
+    }
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("tables changed during dispatch and lookup are reclaimed", "[esp_bus][memory][stress]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    TEST_ASSERT_NOT_NULL(esp_bus_resolve("churn:evt"));
+    TEST_ASSERT_NOT_NULL(esp_bus_resolve("churn.go"));
+    
+    MEMORY_CHECK_START();
+    
+    churn_ids[0] = esp_bus_sub("churn:evt", test_evt_handler, NULL);
+    churn_ids[1] = esp_bus_sub("churn:evt", unsub_all_handler, NULL);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("churn", "evt", NULL, 0));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    int seen = test_counter;
+    TEST_ASSERT_GREATER_OR_EQUAL(1, seen);
+    
+    // Both listeners are gone for the next event
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("churn", "evt", NULL, 0));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(seen, test_counter);
+    
+    // Lock-free lookups race module registration on another task
+    static const esp_bus_action_t actions[] = { { .name = "go" } };
+    esp_bus_module_t mod = {
+        .name = "churn",
+        .on_req = test_req_handler,
+        .actions = actions,
+        .action_cnt = 1,
+    };
+    churn_reads = 0;
+    churn_run = true;
+    xTaskCreate(churn_reader_task, "churn", 4096, NULL, 5, NULL);
+    for (int i = 0; i < 100; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+        esp_bus_call("churn.go");
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("churn"));
+        if (i % 10 == 0) vTaskDelay(1);
+    }
+    churn_run = false;
+    vTaskDelay(pdMS_TO_TICKS(20));
+    TEST_ASSERT_GREATER_THAN(0, churn_reads);
+    
+    MEMORY_CHECK_END(64);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+static esp_bus_buf_t *kept_buf = NULL;
+static const void *seen_data = NULL;
+
+static void buf_keep_handler(const char *event, const void *data, size_t len, void *ctx) {
+    seen_data = data;
+    kept_buf = esp_bus_buf_acquire(esp_bus_cur_buf());
+    test_counter++;
+}
+
+TEST_CASE("shared buffer reaches subscribers without a copy", "[esp_bus][memory][buf]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    TEST_ASSERT_NOT_NULL(esp_bus_resolve("cam:frame"));
+    TEST_ASSERT_NOT_NULL(esp_bus_resolve("cam.frame"));
+    
+    MEMORY_CHECK_START();
+    
+    int id = esp_bus_sub("cam:frame", buf_keep_handler, NULL);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, id);
+    
+    esp_bus_buf_t *buf = esp_bus_buf_alloc(2048);
+    TEST_ASSERT_NOT_NULL(buf);
+    memset(buf->data, 0xA5, buf->size);
+    buf->len = 1500;
+    
+    // Ownership moves to the bus
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit_buf("cam", "frame", buf));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(1, test_counter);
+    TEST_ASSERT_EQUAL_PTR(buf->data, seen_data);
+    TEST_ASSERT_EQUAL_PTR(buf, kept_buf);
+    TEST_ASSERT_EQUAL(1, kept_buf->refs);
+    TEST_ASSERT_EQUAL(0xA5, kept_buf->data[1499]);
+    esp_bus_buf_release(kept_buf);
+    
+    // Copied payloads have no buffer behind them
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("cam", "frame", "x", 1));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(2, test_counter);
+    TEST_ASSERT_NULL(kept_buf);
+    TEST_ASSERT_NULL(esp_bus_cur_buf());
+    
+    // A rejected emit leaves the reference with the caller
+    buf = esp_bus_buf_alloc(32);
+    TEST_ASSERT_NOT_NULL(buf);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_bus_emit_buf_h(esp_bus_resolve("cam.frame"), buf));
+    TEST_ASSERT_EQUAL(1, buf->refs);
+    esp_bus_buf_release(buf);
+    
+    esp_bus_unsub(id);
+    MEMORY_CHECK_END(64);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+}
+
+TEST_CASE("payload pool falls back to heap when exhausted", "[esp_bus][memory][pool]")
+{
+    reset_test_state();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_init());
+    slow_release = xSemaphoreCreateBinary();
+    
+    esp_bus_module_t mod = {
+        .name = "slow",
+        .on_req = slow_req_handler,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_reg(&mod));
+    int sub_id = esp_bus_sub("src:*", test_evt_handler, NULL);
+    TEST_ASSERT_NOT_NULL(esp_bus_resolve("slow.wait"));
+    TEST_ASSERT_NOT_NULL(esp_bus_resolve("src:big"));
+    
+    esp_bus_pool_stats_t before, st;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_pool_stats(&before));
+    TEST_ASSERT_EQUAL(256, before.cls[2].block_size);
+    
+    MEMORY_CHECK_START();
+    
+    // Park the bus task so payloads pile up in the queue
+    esp_bus_call("slow.wait");
+    vTaskDelay(pdMS_TO_TICKS(20));
+    
+    int n = before.cls[2].count + 3;
+    if (n > 7) n = 7;  // Smallest queue is 8, one slot holds slow.wait
+    uint8_t payload[200] = {0};
+    for (int i = 0; i < n; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_bus_emit("src", "big", payload, sizeof(payload)));
+    }
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_pool_stats(&st));
+    int pooled = n < before.cls[2].count ? n : before.cls[2].count;
+    TEST_ASSERT_EQUAL(pooled, st.cls[2].in_use);
+    TEST_ASSERT_EQUAL(before.misses + (n - pooled), st.misses);
+    
+    xSemaphoreGive(slow_release);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_EQUAL(n, test_counter);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_pool_stats(&st));
+    TEST_ASSERT_EQUAL(0, st.cls[2].in_use);
+    TEST_ASSERT_EQUAL(pooled, st.cls[2].high_water);
+    
+    MEMORY_CHECK_END(64);
+    
+    esp_bus_unsub(sub_id);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_unreg("slow"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_bus_deinit());
+    vSemaphoreDelete(slow_release);
+}
+
 // ============================================================================
 // Test Runner
 // ============================================================================